@@ -0,0 +1,413 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AABBTree.h"
+
+namespace
+{
+	// Smallest box containing both a and b
+	AABB Union(const AABB& a, const AABB& b)
+	{
+		AABB retVal(a);
+		retVal.UpdateMinMax(b.mMin);
+		retVal.UpdateMinMax(b.mMax);
+		return retVal;
+	}
+
+	// Surface area heuristic (half the surface area is enough
+	// since we only ever compare costs)
+	float Cost(const AABB& box)
+	{
+		Vector3 d = box.mMax - box.mMin;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	bool ContainsBox(const AABB& outer, const AABB& inner)
+	{
+		return outer.mMin.x <= inner.mMin.x &&
+			outer.mMin.y <= inner.mMin.y &&
+			outer.mMin.z <= inner.mMin.z &&
+			outer.mMax.x >= inner.mMax.x &&
+			outer.mMax.y >= inner.mMax.y &&
+			outer.mMax.z >= inner.mMax.z;
+	}
+}
+
+AABBTree::AABBTree(float fatMargin)
+	:mRoot(NullNode)
+	,mFreeList(NullNode)
+	,mProxyCount(0)
+	,mFatMargin(fatMargin)
+{
+}
+
+std::vector<int>& AABBTree::GetQueryStack()
+{
+	thread_local std::vector<int> stack;
+	return stack;
+}
+
+int AABBTree::CreateProxy(const AABB& box, void* userData)
+{
+	int proxyID = AllocateNode();
+	Node& node = mNodes[proxyID];
+	// Fatten the box by the margin
+	Vector3 margin(mFatMargin, mFatMargin, mFatMargin);
+	node.mBox.mMin = box.mMin - margin;
+	node.mBox.mMax = box.mMax + margin;
+	node.mUserData = userData;
+	node.mHeight = 0;
+
+	InsertLeaf(proxyID);
+	mProxyCount++;
+	return proxyID;
+}
+
+void AABBTree::DestroyProxy(int proxyID)
+{
+	RemoveLeaf(proxyID);
+	FreeNode(proxyID);
+	mProxyCount--;
+}
+
+bool AABBTree::MoveProxy(int proxyID, const AABB& box)
+{
+	// Still inside the fat box, so nothing to do
+	if (ContainsBox(mNodes[proxyID].mBox, box))
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxyID);
+	Vector3 margin(mFatMargin, mFatMargin, mFatMargin);
+	mNodes[proxyID].mBox.mMin = box.mMin - margin;
+	mNodes[proxyID].mBox.mMax = box.mMax + margin;
+	InsertLeaf(proxyID);
+	return true;
+}
+
+int AABBTree::AllocateNode()
+{
+	// Grow the pool if the free list is empty
+	if (mFreeList == NullNode)
+	{
+		mNodes.emplace_back();
+		return static_cast<int>(mNodes.size()) - 1;
+	}
+
+	int nodeID = mFreeList;
+	mFreeList = mNodes[nodeID].mParent;
+	mNodes[nodeID] = Node();
+	return nodeID;
+}
+
+void AABBTree::FreeNode(int node)
+{
+	mNodes[node].mParent = mFreeList;
+	mNodes[node].mHeight = -1;
+	mNodes[node].mUserData = nullptr;
+	mFreeList = node;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+	if (mRoot == NullNode)
+	{
+		mRoot = leaf;
+		mNodes[mRoot].mParent = NullNode;
+		return;
+	}
+
+	// Find the best sibling for this leaf with a branch and bound
+	// search over the surface area heuristic. The cost of making a
+	// node the sibling is the area of the new parent plus how much
+	// every ancestor's area grows.
+	AABB leafBox = mNodes[leaf].mBox;
+	float leafCost = Cost(leafBox);
+	int index = mRoot;
+	float bestCost = Cost(Union(mNodes[mRoot].mBox, leafBox));
+	// Stack of (node, inherited cost) still to consider
+	mInsertStack.clear();
+	mInsertStack.emplace_back(mRoot, 0.0f);
+	while (!mInsertStack.empty())
+	{
+		int nodeID = mInsertStack.back().first;
+		float inherited = mInsertStack.back().second;
+		mInsertStack.pop_back();
+
+		const Node& node = mNodes[nodeID];
+		float combined = Cost(Union(node.mBox, leafBox));
+		float cost = combined + inherited;
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			index = nodeID;
+		}
+
+		// Lower bound for any node further down this subtree
+		if (!node.IsLeaf())
+		{
+			float childInherited = inherited + combined - Cost(node.mBox);
+			if (leafCost + childInherited < bestCost)
+			{
+				mInsertStack.emplace_back(node.mChild1, childInherited);
+				mInsertStack.emplace_back(node.mChild2, childInherited);
+			}
+		}
+	}
+	int sibling = index;
+
+	// Create a new parent for the sibling and the leaf
+	int oldParent = mNodes[sibling].mParent;
+	int newParent = AllocateNode();
+	mNodes[newParent].mParent = oldParent;
+	mNodes[newParent].mBox = Union(leafBox, mNodes[sibling].mBox);
+	mNodes[newParent].mHeight = mNodes[sibling].mHeight + 1;
+	mNodes[newParent].mChild1 = sibling;
+	mNodes[newParent].mChild2 = leaf;
+	mNodes[sibling].mParent = newParent;
+	mNodes[leaf].mParent = newParent;
+
+	if (oldParent != NullNode)
+	{
+		if (mNodes[oldParent].mChild1 == sibling)
+		{
+			mNodes[oldParent].mChild1 = newParent;
+		}
+		else
+		{
+			mNodes[oldParent].mChild2 = newParent;
+		}
+	}
+	else
+	{
+		// The sibling was the root
+		mRoot = newParent;
+	}
+
+	// Walk back up the tree refitting boxes and heights
+	index = mNodes[leaf].mParent;
+	while (index != NullNode)
+	{
+		index = Balance(index);
+		Node& node = mNodes[index];
+		const Node& child1 = mNodes[node.mChild1];
+		const Node& child2 = mNodes[node.mChild2];
+		node.mHeight = 1 + Math::Max(child1.mHeight, child2.mHeight);
+		node.mBox = Union(child1.mBox, child2.mBox);
+		index = node.mParent;
+	}
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == mRoot)
+	{
+		mRoot = NullNode;
+		return;
+	}
+
+	int parent = mNodes[leaf].mParent;
+	int grandParent = mNodes[parent].mParent;
+	int sibling = mNodes[parent].mChild1 == leaf ?
+		mNodes[parent].mChild2 : mNodes[parent].mChild1;
+
+	if (grandParent != NullNode)
+	{
+		// Replace the parent with the sibling
+		if (mNodes[grandParent].mChild1 == parent)
+		{
+			mNodes[grandParent].mChild1 = sibling;
+		}
+		else
+		{
+			mNodes[grandParent].mChild2 = sibling;
+		}
+		mNodes[sibling].mParent = grandParent;
+		FreeNode(parent);
+
+		// Refit the ancestors
+		int index = grandParent;
+		while (index != NullNode)
+		{
+			index = Balance(index);
+			Node& node = mNodes[index];
+			const Node& child1 = mNodes[node.mChild1];
+			const Node& child2 = mNodes[node.mChild2];
+			node.mBox = Union(child1.mBox, child2.mBox);
+			node.mHeight = 1 + Math::Max(child1.mHeight, child2.mHeight);
+			index = node.mParent;
+		}
+	}
+	else
+	{
+		mRoot = sibling;
+		mNodes[sibling].mParent = NullNode;
+		FreeNode(parent);
+	}
+}
+
+// Perform a left or right rotation if node a is imbalanced
+int AABBTree::Balance(int a)
+{
+	Node& A = mNodes[a];
+	if (A.IsLeaf() || A.mHeight < 2)
+	{
+		return a;
+	}
+
+	int b = A.mChild1;
+	int c = A.mChild2;
+	Node& B = mNodes[b];
+	Node& C = mNodes[c];
+	int balance = C.mHeight - B.mHeight;
+
+	// Rotate C up
+	if (balance > 1)
+	{
+		int f = C.mChild1;
+		int g = C.mChild2;
+		Node& F = mNodes[f];
+		Node& G = mNodes[g];
+
+		// Swap A and C
+		C.mChild1 = a;
+		C.mParent = A.mParent;
+		A.mParent = c;
+
+		// A's old parent should point to C
+		if (C.mParent != NullNode)
+		{
+			if (mNodes[C.mParent].mChild1 == a)
+			{
+				mNodes[C.mParent].mChild1 = c;
+			}
+			else
+			{
+				mNodes[C.mParent].mChild2 = c;
+			}
+		}
+		else
+		{
+			mRoot = c;
+		}
+
+		// Keep the taller of F and G under C
+		if (F.mHeight > G.mHeight)
+		{
+			C.mChild2 = f;
+			A.mChild2 = g;
+			G.mParent = a;
+			A.mBox = Union(B.mBox, G.mBox);
+			C.mBox = Union(A.mBox, F.mBox);
+			A.mHeight = 1 + Math::Max(B.mHeight, G.mHeight);
+			C.mHeight = 1 + Math::Max(A.mHeight, F.mHeight);
+		}
+		else
+		{
+			C.mChild2 = g;
+			A.mChild2 = f;
+			F.mParent = a;
+			A.mBox = Union(B.mBox, F.mBox);
+			C.mBox = Union(A.mBox, G.mBox);
+			A.mHeight = 1 + Math::Max(B.mHeight, F.mHeight);
+			C.mHeight = 1 + Math::Max(A.mHeight, G.mHeight);
+		}
+		return c;
+	}
+
+	// Rotate B up
+	if (balance < -1)
+	{
+		int d = B.mChild1;
+		int e = B.mChild2;
+		Node& D = mNodes[d];
+		Node& E = mNodes[e];
+
+		// Swap A and B
+		B.mChild1 = a;
+		B.mParent = A.mParent;
+		A.mParent = b;
+
+		// A's old parent should point to B
+		if (B.mParent != NullNode)
+		{
+			if (mNodes[B.mParent].mChild1 == a)
+			{
+				mNodes[B.mParent].mChild1 = b;
+			}
+			else
+			{
+				mNodes[B.mParent].mChild2 = b;
+			}
+		}
+		else
+		{
+			mRoot = b;
+		}
+
+		// Keep the taller of D and E under B
+		if (D.mHeight > E.mHeight)
+		{
+			B.mChild2 = d;
+			A.mChild1 = e;
+			E.mParent = a;
+			A.mBox = Union(C.mBox, E.mBox);
+			B.mBox = Union(A.mBox, D.mBox);
+			A.mHeight = 1 + Math::Max(C.mHeight, E.mHeight);
+			B.mHeight = 1 + Math::Max(A.mHeight, D.mHeight);
+		}
+		else
+		{
+			B.mChild2 = e;
+			A.mChild1 = d;
+			D.mParent = a;
+			A.mBox = Union(C.mBox, D.mBox);
+			B.mBox = Union(A.mBox, E.mBox);
+			A.mHeight = 1 + Math::Max(C.mHeight, D.mHeight);
+			B.mHeight = 1 + Math::Max(A.mHeight, E.mHeight);
+		}
+		return b;
+	}
+
+	return a;
+}
+
+bool AABBTree::SegmentOverlaps(const Vector3& start, const Vector3& invDir,
+	const AABB& box, float maxT)
+{
+	float tMin = 0.0f;
+	float tMax = maxT;
+	const float* s = start.GetAsFloatPtr();
+	const float* inv = invDir.GetAsFloatPtr();
+	const float* bMin = box.mMin.GetAsFloatPtr();
+	const float* bMax = box.mMax.GetAsFloatPtr();
+	for (int i = 0; i < 3; i++)
+	{
+		if (Math::Abs(inv[i]) == Math::Infinity)
+		{
+			// Parallel to this slab, so the start has to be inside it
+			if (s[i] < bMin[i] || s[i] > bMax[i])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float t1 = (bMin[i] - s[i]) * inv[i];
+			float t2 = (bMax[i] - s[i]) * inv[i];
+			tMin = Math::Max(tMin, Math::Min(t1, t2));
+			tMax = Math::Min(tMax, Math::Max(t1, t2));
+			if (tMin > tMax)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
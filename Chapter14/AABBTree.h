@@ -0,0 +1,181 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <utility>
+#include "Collision.h"
+
+// Dynamic bounding volume hierarchy of AABBs.
+// Each leaf (proxy) stores a "fat" box that is slightly larger than
+// the box it was created with, so small movements don't require
+// the leaf to be removed and reinserted.
+class AABBTree
+{
+public:
+	AABBTree(float fatMargin = 5.0f);
+
+	static const int NullNode = -1;
+
+	// Create a proxy for the box and return its ID
+	int CreateProxy(const AABB& box, void* userData);
+	// Remove the proxy from the tree
+	void DestroyProxy(int proxyID);
+	// Update a proxy for a new box. Returns true if the proxy
+	// had to be reinserted (the box escaped the fat box)
+	bool MoveProxy(int proxyID, const AABB& box);
+
+	void* GetUserData(int proxyID) const { return mNodes[proxyID].mUserData; }
+	const AABB& GetFatBox(int proxyID) const { return mNodes[proxyID].mBox; }
+
+	// Calls f(proxyID) for every proxy whose fat box overlaps box.
+	// If f returns false, the query stops early.
+	template <typename Func>
+	void Query(const AABB& box, Func f) const;
+
+	// Calls f(proxyID, maxT) for every proxy whose fat box the
+	// segment might pass through, in rough front to back order.
+	// f returns the new maximum t to consider (return maxT to
+	// keep it unchanged, or a value < 0 to stop the cast).
+	template <typename Func>
+	void SegmentCast(const LineSegment& l, Func f) const;
+
+	// Height of the tree (0 for a single leaf)
+	int GetHeight() const { return mRoot == NullNode ? 0 : mNodes[mRoot].mHeight; }
+	int GetProxyCount() const { return mProxyCount; }
+private:
+	struct Node
+	{
+		// Fat box for leaves, union of children for internal nodes
+		AABB mBox{ Vector3::Zero, Vector3::Zero };
+		void* mUserData = nullptr;
+		// Parent index (doubles as the next index in the free list)
+		int mParent = NullNode;
+		int mChild1 = NullNode;
+		int mChild2 = NullNode;
+		// Leaf = 0, free node = -1
+		int mHeight = -1;
+
+		bool IsLeaf() const { return mChild1 == NullNode; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	// Rebalance the subtree rooted at a, returns new subtree root
+	int Balance(int a);
+
+	// Slab test of segment against box, clipped to [0, maxT]
+	static bool SegmentOverlaps(const Vector3& start, const Vector3& invDir,
+		const AABB& box, float maxT);
+
+	// Scratch stack used by queries (avoids allocating per query).
+	// There's one per thread, so queries can run in parallel.
+	static std::vector<int>& GetQueryStack();
+
+	std::vector<Node> mNodes;
+	// Scratch stack used when searching for where to insert
+	std::vector<std::pair<int, float>> mInsertStack;
+	int mRoot;
+	int mFreeList;
+	int mProxyCount;
+	float mFatMargin;
+};
+
+template <typename Func>
+void AABBTree::Query(const AABB& box, Func f) const
+{
+	if (mRoot == NullNode)
+	{
+		return;
+	}
+	// Queries may be nested, so remember where our part of the stack starts
+	std::vector<int>& stack = GetQueryStack();
+	size_t base = stack.size();
+	stack.emplace_back(mRoot);
+	while (stack.size() > base)
+	{
+		int nodeID = stack.back();
+		stack.pop_back();
+		const Node& node = mNodes[nodeID];
+		if (Intersect(node.mBox, box))
+		{
+			if (node.IsLeaf())
+			{
+				if (!f(nodeID))
+				{
+					stack.resize(base);
+					return;
+				}
+			}
+			else
+			{
+				stack.emplace_back(node.mChild1);
+				stack.emplace_back(node.mChild2);
+			}
+		}
+	}
+}
+
+template <typename Func>
+void AABBTree::SegmentCast(const LineSegment& l, Func f) const
+{
+	if (mRoot == NullNode)
+	{
+		return;
+	}
+	// Precompute reciprocal of direction for slab tests
+	// (division by zero gives infinity, which the slab test handles)
+	Vector3 dir = l.mEnd - l.mStart;
+	Vector3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+	float maxT = 1.0f;
+
+	std::vector<int>& stack = GetQueryStack();
+	size_t base = stack.size();
+	stack.emplace_back(mRoot);
+	while (stack.size() > base)
+	{
+		int nodeID = stack.back();
+		stack.pop_back();
+		const Node& node = mNodes[nodeID];
+		if (!SegmentOverlaps(l.mStart, invDir, node.mBox, maxT))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			maxT = f(nodeID, maxT);
+			if (maxT < 0.0f)
+			{
+				stack.resize(base);
+				return;
+			}
+		}
+		else
+		{
+			// Visit the child closer to the start first (pushed last),
+			// so maxT shrinks quickly and prunes the other child
+			const AABB& b1 = mNodes[node.mChild1].mBox;
+			const AABB& b2 = mNodes[node.mChild2].mBox;
+			float d1 = ((b1.mMin + b1.mMax) * 0.5f - l.mStart).LengthSq();
+			float d2 = ((b2.mMin + b2.mMax) * 0.5f - l.mStart).LengthSq();
+			if (d1 < d2)
+			{
+				stack.emplace_back(node.mChild2);
+				stack.emplace_back(node.mChild1);
+			}
+			else
+			{
+				stack.emplace_back(node.mChild1);
+				stack.emplace_back(node.mChild2);
+			}
+		}
+	}
+}
@@ -10,6 +10,7 @@
 #include "Game.h"
 #include "Component.h"
 #include "LevelLoader.h"
+#include <algorithm>
 
 const char* Actor::TypeNames[NUM_ACTOR_TYPES] = {
 	"Actor",
@@ -26,18 +27,25 @@ Actor::Actor(Game* game)
 	,mScale(1.0f)
 	,mGame(game)
 	,mRecomputeTransform(true)
+	,mPrevPosition(Vector3::Zero)
+	,mPrevRotation(Quaternion::Identity)
+	,mPrevScale(1.0f)
+	,mMovedThisStep(false)
+	,mPrevValid(false)
+	,mRenderAtRest(false)
+	,mComponentsDirty(false)
 {
-	mGame->AddActor(this);
+	mGameHandle = mGame->AddActor(this);
 }
 
 Actor::~Actor()
 {
-	mGame->RemoveActor(this);
+	mGame->RemoveActor(mGameHandle);
 	// Need to delete components
 	// Because ~Component calls RemoveComponent, need a different style loop
-	while (!mComponents.empty())
+	while (!mComponents.Empty())
 	{
-		delete mComponents.back();
+		delete mComponents.GetValues().back();
 	}
 }
 
@@ -45,23 +53,10 @@ void Actor::Update(float deltaTime)
 {
 	if (mState == EActive)
 	{
-		if (mRecomputeTransform)
-		{
-			ComputeWorldTransform();
-		}
-		UpdateComponents(deltaTime);
 		UpdateActor(deltaTime);
 	}
 }
 
-void Actor::UpdateComponents(float deltaTime)
-{
-	for (auto comp : mComponents)
-	{
-		comp->Update(deltaTime);
-	}
-}
-
 void Actor::UpdateActor(float deltaTime)
 {
 }
@@ -71,7 +66,7 @@ void Actor::ProcessInput(const uint8_t* keyState)
 	if (mState == EActive)
 	{
 		// First process input for components
-		for (auto comp : mComponents)
+		for (auto comp : GetSortedComponents())
 		{
 			comp->ProcessInput(keyState);
 		}
@@ -98,6 +93,50 @@ void Actor::ComputeWorldTransform()
 	{
 		comp->OnUpdateWorldTransform();
 	}
+	mRenderAtRest = false;
+}
+
+void Actor::SavePreviousTransform()
+{
+	mPrevPosition = mPosition;
+	mPrevRotation = mRotation;
+	mPrevScale = mScale;
+	mMovedThisStep = false;
+	mPrevValid = true;
+}
+
+void Actor::ComputeRenderTransform(float alpha)
+{
+	if (mMovedThisStep && mPrevValid)
+	{
+		// Scale, then rotate, then translate (same as the world transform)
+		mRenderTransform = Matrix4::CreateScale(Math::Lerp(mPrevScale, mScale, alpha));
+		mRenderTransform *= Matrix4::CreateFromQuaternion(
+			Quaternion::Slerp(mPrevRotation, mRotation, alpha));
+		mRenderTransform *= Matrix4::CreateTranslation(
+			Vector3::Lerp(mPrevPosition, mPosition, alpha));
+		mRenderAtRest = false;
+	}
+	else if (!mRenderAtRest || mRecomputeTransform)
+	{
+		// Didn't move, so it's drawn right where it is
+		if (mRecomputeTransform)
+		{
+			ComputeWorldTransform();
+		}
+		mRenderTransform = mWorldTransform;
+		mRenderAtRest = true;
+	}
+	else
+	{
+		// Nothing changed since last frame
+		return;
+	}
+
+	for (auto comp : mComponents)
+	{
+		comp->OnUpdateRenderTransform();
+	}
 }
 
 void Actor::RotateToNewForward(const Vector3& forward)
@@ -124,33 +163,35 @@ void Actor::RotateToNewForward(const Vector3& forward)
 	}
 }
 
-void Actor::AddComponent(Component* component)
+SlotHandle Actor::AddComponent(Component* component)
 {
-	// Find the insertion point in the sorted vector
-	// (The first element with a order higher than me)
-	int myOrder = component->GetUpdateOrder();
-	auto iter = mComponents.begin();
-	for (;
-		iter != mComponents.end();
-		++iter)
-	{
-		if (myOrder < (*iter)->GetUpdateOrder())
-		{
-			break;
-		}
-	}
+	// Sorted by update order the next time it's needed
+	mComponentsDirty = true;
+	mGame->OnComponentsChanged();
+	return mComponents.Insert(component);
+}
 
-	// Inserts element before position of iterator
-	mComponents.insert(iter, component);
+void Actor::RemoveComponent(SlotHandle handle)
+{
+	if (mComponents.Remove(handle))
+	{
+		mComponentsDirty = true;
+		mGame->OnComponentsChanged();
+	}
 }
 
-void Actor::RemoveComponent(Component* component)
+const std::vector<Component*>& Actor::GetSortedComponents()
 {
-	auto iter = std::find(mComponents.begin(), mComponents.end(), component);
-	if (iter != mComponents.end())
+	if (mComponentsDirty)
 	{
-		mComponents.erase(iter);
+		mSortedComponents = mComponents.GetValues();
+		std::stable_sort(mSortedComponents.begin(), mSortedComponents.end(),
+			[](const Component* a, const Component* b) {
+			return a->GetUpdateOrder() < b->GetUpdateOrder();
+		});
+		mComponentsDirty = false;
 	}
+	return mSortedComponents;
 }
 
 void Actor::LoadProperties(const rapidjson::Value& inObj)
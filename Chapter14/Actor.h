@@ -9,6 +9,8 @@
 #pragma once
 #include <vector>
 #include "Math.h"
+#include "Pool.h"
+#include "SlotMap.h"
 #include <rapidjson/document.h>
 #include "Component.h"
 
@@ -36,12 +38,13 @@ public:
 	};
 
 	Actor(class Game* game);
+	DECLARE_POOLED(Actor)
 	virtual ~Actor();
 
-	// Update function called from Game (not overridable)
+	// Update function called from Game once every component update
+	// phase is done (not overridable; the components themselves are
+	// updated by Game, phase by phase)
 	void Update(float deltaTime);
-	// Updates all the components attached to the actor (not overridable)
-	void UpdateComponents(float deltaTime);
 	// Any actor-specific update code (overridable)
 	virtual void UpdateActor(float deltaTime);
 	// ProcessInput function called from Game (not overridable)
@@ -51,15 +54,26 @@ public:
 
 	// Getters/setters
 	const Vector3& GetPosition() const { return mPosition; }
-	void SetPosition(const Vector3& pos) { mPosition = pos; mRecomputeTransform = true; }
+	void SetPosition(const Vector3& pos) { mPosition = pos; mRecomputeTransform = true; mMovedThisStep = true; }
 	float GetScale() const { return mScale; }
-	void SetScale(float scale) { mScale = scale; mRecomputeTransform = true; }
+	void SetScale(float scale) { mScale = scale; mRecomputeTransform = true; mMovedThisStep = true; }
 	const Quaternion& GetRotation() const { return mRotation; }
-	void SetRotation(const Quaternion& rotation) { mRotation = rotation;   mRecomputeTransform = true; }
+	void SetRotation(const Quaternion& rotation) { mRotation = rotation;   mRecomputeTransform = true; mMovedThisStep = true; }
 	
 	void ComputeWorldTransform();
+	// Only recomputes if the actor moved since the last time
+	void UpdateWorldTransform() { if (mRecomputeTransform) ComputeWorldTransform(); }
 	const Matrix4& GetWorldTransform() const { return mWorldTransform; }
 
+	// Called by Game before each fixed simulation step
+	void SavePreviousTransform();
+	// Blends between the transform before and after the last step,
+	// so rendering is smooth when it runs faster than the simulation
+	void ComputeRenderTransform(float alpha);
+	// The transform to draw with (the world transform is the
+	// simulation's, which can be up to a step ahead)
+	const Matrix4& GetRenderTransform() const { return mRenderTransform; }
+
 	Vector3 GetForward() const { return Vector3::Transform(Vector3::UnitX, mRotation); }
 	Vector3 GetRight() const { return Vector3::Transform(Vector3::UnitY, mRotation); }
 
@@ -71,9 +85,9 @@ public:
 	class Game* GetGame() { return mGame; }
 
 
-	// Add/remove components
-	void AddComponent(class Component* component);
-	void RemoveComponent(class Component* component);
+	// Add/remove components (add returns the handle to remove with)
+	SlotHandle AddComponent(class Component* component);
+	void RemoveComponent(SlotHandle handle);
 
 	// Load/Save
 	virtual void LoadProperties(const rapidjson::Value& inObj);
@@ -108,8 +122,12 @@ public:
 
 	virtual TypeID GetType() const { return TActor; }
 
-	const std::vector<Component*>& GetComponents() const { return mComponents; }
+	// The components, in no particular order
+	const std::vector<Component*>& GetComponents() const { return mComponents.GetValues(); }
+	// The components in update order
+	const std::vector<Component*>& GetSortedComponents();
 private:
+
 	// Actor's state
 	State mState;
 
@@ -120,6 +138,22 @@ private:
 	float mScale;
 	bool mRecomputeTransform;
 
-	std::vector<Component*> mComponents;
+	// Interpolation for rendering
+	Matrix4 mRenderTransform;
+	Vector3 mPrevPosition;
+	Quaternion mPrevRotation;
+	float mPrevScale;
+	// Set when the transform changes during a step
+	bool mMovedThisStep;
+	// False until the first SavePreviousTransform
+	bool mPrevValid;
+	// True while mRenderTransform is just mWorldTransform
+	bool mRenderAtRest;
+
+	SlotMap<Component*> mComponents;
+	// The components in update order
+	std::vector<Component*> mSortedComponents;
+	bool mComponentsDirty;
+	SlotHandle mGameHandle;
 	class Game* mGame;
 };
@@ -11,10 +11,171 @@
 #include <rapidjson/document.h>
 #include <SDL/SDL_log.h>
 #include "LevelLoader.h"
+#include <fstream>
+#include <cstring>
+#include "Profiler.h"
+
+namespace
+{
+	// [header][bone info][keys], sections 16-byte aligned
+	const uint32_t BinaryVersion = 1;
+	const uint32_t SectionAlignment = 16;
+	struct AnimBinHeader
+	{
+		// Signature for file type
+		char mSignature[4];
+		uint32_t mVersion;
+		uint32_t mNumBones;
+		uint32_t mNumFrames;
+		uint32_t mNumTracks;
+		float mDuration;
+		// Byte offsets of each section from the start of the file
+		uint32_t mBonesOffset;
+		uint32_t mKeysOffset;
+		// Total size, to catch truncated files
+		uint32_t mFileSize;
+		uint32_t mPadding;
+	};
+	static_assert(sizeof(AnimBinHeader) == 40, "AnimBinHeader must stay 40 bytes");
+
+	uint32_t AlignSection(uint32_t offset)
+	{
+		return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+
+	// Range of the three smallest quaternion components
+	const float RotRange = 0.70710678f;
+	const float RotMax = 32767.0f;
+	const float TransMax = 65535.0f;
+
+	uint16_t Quantize(float value, float min, float range, float maxValue)
+	{
+		float t = Math::Clamp((value - min) / range, 0.0f, 1.0f);
+		return static_cast<uint16_t>(t * maxValue + 0.5f);
+	}
+}
+
+Animation::Animation()
+	:mNumBones(0)
+	,mNumFrames(0)
+	,mNumTracks(0)
+	,mDuration(0.0f)
+	,mFrameDuration(0.0f)
+	,mBones(nullptr)
+	,mKeys(nullptr)
+	,mDataSize(0)
+{
+}
 
 bool Animation::Load(const std::string& fileName)
 {
+	PROFILE_SCOPE_DETAIL("Animation::Load", fileName.c_str());
 	mFileName = fileName;
+
+	// Baked clips are mapped straight from disk, so only fall back
+	// to parsing the JSON if this clip hasn't been baked
+	if (LoadBinary(fileName + ".bin"))
+	{
+		return true;
+	}
+	return LoadJSON(fileName);
+}
+
+bool Animation::Bake(const std::string& fileName)
+{
+	std::vector<unsigned char> data;
+	if (!Compress(fileName, data))
+	{
+		return false;
+	}
+
+	std::string binName = fileName + ".bin";
+	std::ofstream outFile(binName, std::ios::out
+		| std::ios::binary | std::ios::trunc);
+	if (!outFile.is_open())
+	{
+		SDL_Log("Failed to write animation %s", binName.c_str());
+		return false;
+	}
+	outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return outFile.good();
+}
+
+bool Animation::LoadJSON(const std::string& fileName)
+{
+	if (!Compress(fileName, mData))
+	{
+		return false;
+	}
+	return SetData(mData.data(), mData.size());
+}
+
+bool Animation::LoadBinary(const std::string& fileName)
+{
+	if (!mFile.Open(fileName))
+	{
+		return false;
+	}
+	if (!SetData(mFile.GetData(), mFile.GetSize()))
+	{
+		SDL_Log("Animation %s is corrupt or an old version, rebake it with -bake",
+			fileName.c_str());
+		mFile.Close();
+		return false;
+	}
+	return true;
+}
+
+bool Animation::SetData(const unsigned char* data, size_t size)
+{
+	if (size < sizeof(AnimBinHeader))
+	{
+		return false;
+	}
+	const AnimBinHeader& header = *reinterpret_cast<const AnimBinHeader*>(data);
+	if (memcmp(header.mSignature, "GANM", 4) != 0 ||
+		header.mVersion != BinaryVersion ||
+		header.mFileSize != size ||
+		header.mNumFrames < 2 || header.mNumBones == 0 ||
+		header.mNumTracks > header.mNumBones ||
+		header.mBonesOffset % SectionAlignment != 0 ||
+		header.mKeysOffset % SectionAlignment != 0)
+	{
+		return false;
+	}
+
+	// Make sure both sections are inside the file
+	uint64_t bonesSize = static_cast<uint64_t>(header.mNumBones) * sizeof(BoneInfo);
+	uint64_t keysSize = static_cast<uint64_t>(header.mNumTracks) *
+		header.mNumFrames * sizeof(Key);
+	if (header.mBonesOffset + bonesSize > size ||
+		header.mKeysOffset + keysSize > size)
+	{
+		return false;
+	}
+
+	const BoneInfo* bones = reinterpret_cast<const BoneInfo*>(data + header.mBonesOffset);
+	for (uint32_t i = 0; i < header.mNumBones; i++)
+	{
+		if (bones[i].mTrack >= static_cast<int32_t>(header.mNumTracks))
+		{
+			return false;
+		}
+	}
+
+	mNumBones = header.mNumBones;
+	mNumFrames = header.mNumFrames;
+	mNumTracks = header.mNumTracks;
+	mDuration = header.mDuration;
+	mFrameDuration = mDuration / (mNumFrames - 1);
+	mBones = bones;
+	mKeys = reinterpret_cast<const Key*>(data + header.mKeysOffset);
+	mDataSize = size;
+	return true;
+}
+
+bool Animation::Compress(const std::string& fileName, std::vector<unsigned char>& outData)
+{
 	rapidjson::Document doc;
 	if (!LevelLoader::LoadJSON(fileName, doc))
 	{
@@ -48,12 +209,13 @@ bool Animation::Load(const std::string& fileName)
 		return false;
 	}
 
-	mNumFrames = frames.GetUint();
-	mDuration = length.GetDouble();
-	mNumBones = bonecount.GetUint();
-	mFrameDuration = mDuration / (mNumFrames - 1);
-
-	mTracks.resize(mNumBones);
+	uint32_t numFrames = frames.GetUint();
+	uint32_t numBones = bonecount.GetUint();
+	if (numFrames < 2 || numBones == 0)
+	{
+		SDL_Log("Sequence %s needs at least two frames and one bone.", fileName.c_str());
+		return false;
+	}
 
 	const rapidjson::Value& tracks = sequence["tracks"];
 
@@ -63,6 +225,9 @@ bool Animation::Load(const std::string& fileName)
 		return false;
 	}
 
+	// Read the raw tracks first, since the translation range of
+	// each bone is needed before anything can be quantized
+	std::vector<std::vector<BoneTransform>> rawTracks(numBones);
 	for (rapidjson::SizeType i = 0; i < tracks.Size(); i++)
 	{
 		if (!tracks[i].IsObject())
@@ -72,6 +237,11 @@ bool Animation::Load(const std::string& fileName)
 		}
 
 		size_t boneIndex = tracks[i]["bone"].GetUint();
+		if (boneIndex >= numBones)
+		{
+			SDL_Log("Animation %s: Track element %d has an invalid bone.", fileName.c_str(), i);
+			return false;
+		}
 
 		const rapidjson::Value& transforms = tracks[i]["transforms"];
 		if (!transforms.IsArray())
@@ -82,13 +252,14 @@ bool Animation::Load(const std::string& fileName)
 
 		BoneTransform temp;
 
-		if (transforms.Size() < mNumFrames)
+		if (transforms.Size() < numFrames)
 		{
 			SDL_Log("Animation %s: Track element %d has fewer frames than expected.", fileName.c_str(), i);
 			return false;
 		}
 
-		for (rapidjson::SizeType j = 0; j < transforms.Size(); j++)
+		// (Any frames past the frame count are never sampled)
+		for (rapidjson::SizeType j = 0; j < numFrames; j++)
 		{
 			const rapidjson::Value& rot = transforms[j]["rot"];
 			const rapidjson::Value& trans = transforms[j]["trans"];
@@ -108,14 +279,142 @@ bool Animation::Load(const std::string& fileName)
 			temp.mTranslation.y = trans[1].GetDouble();
 			temp.mTranslation.z = trans[2].GetDouble();
 
-			mTracks[boneIndex].emplace_back(temp);
+			rawTracks[boneIndex].emplace_back(temp);
 		}
 	}
 
+	// Work out the track index and translation range of each bone
+	std::vector<BoneInfo> bones(numBones);
+	uint32_t numTracks = 0;
+	for (uint32_t bone = 0; bone < numBones; bone++)
+	{
+		BoneInfo& info = bones[bone];
+		memset(&info, 0, sizeof(info));
+		const std::vector<BoneTransform>& raw = rawTracks[bone];
+		if (raw.empty())
+		{
+			info.mTrack = -1;
+			continue;
+		}
+		// (A bone listed twice keeps its first track)
+		rawTracks[bone].resize(numFrames);
+		info.mTrack = static_cast<int32_t>(numTracks++);
+
+		Vector3 minTrans = raw[0].mTranslation;
+		Vector3 maxTrans = raw[0].mTranslation;
+		for (const BoneTransform& t : raw)
+		{
+			minTrans.x = Math::Min(minTrans.x, t.mTranslation.x);
+			minTrans.y = Math::Min(minTrans.y, t.mTranslation.y);
+			minTrans.z = Math::Min(minTrans.z, t.mTranslation.z);
+			maxTrans.x = Math::Max(maxTrans.x, t.mTranslation.x);
+			maxTrans.y = Math::Max(maxTrans.y, t.mTranslation.y);
+			maxTrans.z = Math::Max(maxTrans.z, t.mTranslation.z);
+		}
+		Vector3 extent = maxTrans - minTrans;
+		memcpy(info.mTransMin, minTrans.GetAsFloatPtr(), sizeof(info.mTransMin));
+		info.mTransScale[0] = extent.x / TransMax;
+		info.mTransScale[1] = extent.y / TransMax;
+		info.mTransScale[2] = extent.z / TransMax;
+	}
+
+	AnimBinHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mSignature, "GANM", 4);
+	header.mVersion = BinaryVersion;
+	header.mNumBones = numBones;
+	header.mNumFrames = numFrames;
+	header.mNumTracks = numTracks;
+	header.mDuration = static_cast<float>(length.GetDouble());
+	header.mBonesOffset = AlignSection(sizeof(header));
+	header.mKeysOffset = AlignSection(header.mBonesOffset +
+		numBones * static_cast<uint32_t>(sizeof(BoneInfo)));
+	header.mFileSize = header.mKeysOffset +
+		numTracks * numFrames * static_cast<uint32_t>(sizeof(Key));
+
+	outData.assign(header.mFileSize, 0);
+	memcpy(outData.data(), &header, sizeof(header));
+	memcpy(outData.data() + header.mBonesOffset, bones.data(),
+		numBones * sizeof(BoneInfo));
+
+	// Quantize every key into its frame
+	Key* keys = reinterpret_cast<Key*>(outData.data() + header.mKeysOffset);
+	for (uint32_t bone = 0; bone < numBones; bone++)
+	{
+		const BoneInfo& info = bones[bone];
+		if (info.mTrack < 0)
+		{
+			continue;
+		}
+		for (uint32_t frame = 0; frame < numFrames; frame++)
+		{
+			const BoneTransform& t = rawTracks[bone][frame];
+			Key& key = keys[frame * numTracks + info.mTrack];
+
+			// Drop the largest rotation component, flipping the
+			// quaternion so that the dropped one is positive
+			const Quaternion& q = t.mRotation;
+			float comps[4] = { q.x, q.y, q.z, q.w };
+			int largest = 0;
+			for (int i = 1; i < 4; i++)
+			{
+				if (Math::Abs(comps[i]) > Math::Abs(comps[largest]))
+				{
+					largest = i;
+				}
+			}
+			float sign = comps[largest] < 0.0f ? -1.0f : 1.0f;
+			int out = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				if (i != largest)
+				{
+					key.mRot[out++] = Quantize(comps[i] * sign, -RotRange,
+						2.0f * RotRange, RotMax);
+				}
+			}
+			key.mRot[0] |= (largest & 1) << 15;
+			key.mRot[1] |= (largest >> 1) << 15;
+
+			const float* trans = t.mTranslation.GetAsFloatPtr();
+			for (int i = 0; i < 3; i++)
+			{
+				key.mTrans[i] = info.mTransScale[i] > 0.0f ?
+					Quantize(trans[i], info.mTransMin[i],
+						info.mTransScale[i] * TransMax, TransMax) : 0;
+			}
+		}
+	}
 	return true;
 }
 
-void Animation::GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skeleton* inSkeleton, float inTime) const
+BoneTransform Animation::DecodeKey(const BoneInfo& info, const Key& key)
+{
+	int largest = (key.mRot[0] >> 15) | ((key.mRot[1] >> 15) << 1);
+	float comps[4];
+	float sumSq = 0.0f;
+	int in = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		if (i != largest)
+		{
+			float c = (key.mRot[in++] & 0x7FFF) * (2.0f * RotRange / RotMax) - RotRange;
+			comps[i] = c;
+			sumSq += c * c;
+		}
+	}
+	comps[largest] = Math::Sqrt(Math::Max(0.0f, 1.0f - sumSq));
+
+	BoneTransform retVal;
+	retVal.mRotation.Set(comps[0], comps[1], comps[2], comps[3]);
+	retVal.mTranslation.x = info.mTransMin[0] + key.mTrans[0] * info.mTransScale[0];
+	retVal.mTranslation.y = info.mTransMin[1] + key.mTrans[1] * info.mTransScale[1];
+	retVal.mTranslation.z = info.mTransMin[2] + key.mTrans[2] * info.mTransScale[2];
+	return retVal;
+}
+
+void Animation::GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skeleton* inSkeleton, float inTime,
+	size_t maxBones) const
 {
 	if (outPoses.size() != mNumBones)
 	{
@@ -125,35 +424,43 @@ void Animation::GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skelet
 	// Figure out the current frame index and next frame
 	// (This assumes inTime is bounded by [0, AnimDuration]
 	size_t frame = static_cast<size_t>(inTime / mFrameDuration);
+	frame = frame < mNumFrames - 1 ? frame : mNumFrames - 2;
 	size_t nextFrame = frame + 1;
 	// Calculate fractional value between frame and next frame
 	float pct = inTime / mFrameDuration - frame;
 
-	// Setup the pose for the root
-	if (mTracks[0].size() > 0)
-	{
-		// Interpolate between the current frame's pose and the next frame
-		BoneTransform interp = BoneTransform::Interpolate(mTracks[0][frame],
-			mTracks[0][nextFrame], pct);
-		outPoses[0] = interp.ToMatrix();
-	}
-	else
-	{
-		outPoses[0] = Matrix4::Identity;
-	}
+	// Both frames' keys are next to each other in memory
+	const Key* keys = mKeys + frame * mNumTracks;
+	const Key* nextKeys = mKeys + nextFrame * mNumTracks;
 
 	const std::vector<Skeleton::Bone>& bones = inSkeleton->GetBones();
-	// Now setup the poses for the rest
-	for (size_t bone = 1; bone < mNumBones; bone++)
+	const std::vector<size_t>& ranks = inSkeleton->GetBoneRanks();
+	for (size_t bone = 0; bone < mNumBones; bone++)
 	{
 		Matrix4 localMat; // (Defaults to identity)
-		if (mTracks[bone].size() > 0)
+		const BoneInfo& info = mBones[bone];
+		if (ranks[bone] >= maxBones)
+		{
+			// Skipped by LOD
+			localMat = inSkeleton->GetLocalBindPoses()[bone];
+		}
+		else if (info.mTrack >= 0)
 		{
-			BoneTransform interp = BoneTransform::Interpolate(mTracks[bone][frame],
-				mTracks[bone][nextFrame], pct);
+			// Interpolate between the current frame's pose and the next frame
+			BoneTransform interp = BoneTransform::Interpolate(
+				DecodeKey(info, keys[info.mTrack]),
+				DecodeKey(info, nextKeys[info.mTrack]), pct);
 			localMat = interp.ToMatrix();
 		}
 
-		outPoses[bone] = localMat * outPoses[bones[bone].mParent];
+		// The root has no parent
+		if (bone == 0)
+		{
+			outPoses[0] = localMat;
+		}
+		else
+		{
+			outPoses[bone] = localMat * outPoses[bones[bone].mParent];
+		}
 	}
 }
@@ -8,36 +8,82 @@
 
 #pragma once
 #include "BoneTransform.h"
+#include "MappedFile.h"
 #include <vector>
 #include <string>
+#include <cstdint>
 
 class Animation
 {
 public:
+	Animation();
+	// Loads the baked .gpanim.bin if there is one, otherwise the JSON
 	bool Load(const std::string& fileName);
+	// Convert a .gpanim file to the .gpanim.bin next to it
+	static bool Bake(const std::string& fileName);
 
 	size_t GetNumBones() const { return mNumBones; }
 	size_t GetNumFrames() const { return mNumFrames; }
 	float GetDuration() const { return mDuration; }
 	float GetFrameDuration() const { return mFrameDuration; }
+	// Bytes used by the (compressed) clip data
+	size_t GetDataSize() const { return mDataSize; }
 
 	// Fills the provided vector with the global (current) pose matrices for each
 	// bone at the specified time in the animation. It is expected that the time
 	const std::string& GetFileName() const { return mFileName; }
 	// is >= 0.0f and <= mDuration
-	void GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const class Skeleton* inSkeleton, float inTime) const;
+	// Only bones ranked below maxBones (see Skeleton::GetBoneRanks) are
+	// sampled; the rest stay in their bind pose relative to their parent
+	void GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const class Skeleton* inSkeleton, float inTime,
+		size_t maxBones = SIZE_MAX) const;
 private:
+	// One quantized key. The rotation is stored "smallest three":
+	// the largest component is dropped (and rebuilt from the unit
+	// length) and the rest use 15 bits each. The top bits of
+	// mRot[0] and mRot[1] hold the index of the dropped component.
+	// The translation is 16 bits per axis over the bone's range.
+	struct Key
+	{
+		uint16_t mRot[3];
+		uint16_t mTrans[3];
+	};
+	struct BoneInfo
+	{
+		// Index of this bone's key in each frame, or -1 if not animated
+		int32_t mTrack;
+		// Translation = mTransMin + quantized * mTransScale
+		float mTransMin[3];
+		float mTransScale[3];
+	};
+
+	bool LoadJSON(const std::string& fileName);
+	bool LoadBinary(const std::string& fileName);
+	// Validates a .gpanim.bin image and points the tracks at it
+	bool SetData(const unsigned char* data, size_t size);
+	static BoneTransform DecodeKey(const BoneInfo& info, const Key& key);
+	// Builds a .gpanim.bin image from the JSON file
+	static bool Compress(const std::string& fileName, std::vector<unsigned char>& outData);
+
 	// Number of bones for the animation
 	size_t mNumBones;
 	// Number of frames in the animation
 	size_t mNumFrames;
+	// Number of bones with keys
+	size_t mNumTracks;
 	// Duration of the animation in seconds
 	float mDuration;
 	// Duration of each frame in the animation
 	float mFrameDuration;
-	// Transform information for each frame on the track
-	// Each index in the outer vector is a bone, inner vector
-	// is a frame
-	std::vector<std::vector<BoneTransform>> mTracks;
+	// Track info for each bone
+	const BoneInfo* mBones;
+	// Keys for every track, frame-major (all of frame 0's keys,
+	// then frame 1's...) so a sample only touches two frames
+	const Key* mKeys;
+	size_t mDataSize;
+	// The clip data is either mapped from the .bin, or compressed
+	// at load into mData if there's only the JSON
+	MappedFile mFile;
+	std::vector<unsigned char> mData;
 	std::string mFileName;
 };
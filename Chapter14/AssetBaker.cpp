@@ -0,0 +1,120 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AssetBaker.h"
+#include "Mesh.h"
+#include "Animation.h"
+#include "Texture.h"
+#include <SDL/SDL_log.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	bool EndsWith(const std::string& str, const std::string& ext)
+	{
+		return str.length() >= ext.length() &&
+			str.compare(str.length() - ext.length(), ext.length(), ext) == 0;
+	}
+}
+
+bool AssetBaker::BakeDirectory(const std::string& dir, bool compressTextures)
+{
+	bool success = BakeFiles(dir, ".gpmesh", Mesh::Bake);
+	success = BakeFiles(dir, ".gpanim", Animation::Bake) && success;
+	success = BakeFiles(dir, ".png",
+		compressTextures ? Texture::BakeCompressed : Texture::Bake) && success;
+	return success;
+}
+
+bool AssetBaker::BakeFiles(const std::string& dir, const std::string& ext,
+	bool(*bake)(const std::string&))
+{
+	bool success = true;
+	std::vector<std::string> files;
+	FindFiles(dir, ext, files);
+	for (const auto& file : files)
+	{
+		if (bake(file))
+		{
+			SDL_Log("Baked %s", file.c_str());
+		}
+		else
+		{
+			SDL_Log("Failed to bake %s", file.c_str());
+			success = false;
+		}
+	}
+	return success;
+}
+
+void AssetBaker::FindFiles(const std::string& dir, const std::string& ext,
+	std::vector<std::string>& outFiles)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((dir + "/*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	do
+	{
+		std::string name = data.cFileName;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+		std::string path = dir + "/" + name;
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			FindFiles(path, ext, outFiles);
+		}
+		else if (EndsWith(name, ext))
+		{
+			outFiles.emplace_back(path);
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* d = opendir(dir.c_str());
+	if (d == nullptr)
+	{
+		return;
+	}
+	while (dirent* entry = readdir(d))
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+		std::string path = dir + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+		{
+			continue;
+		}
+		if (S_ISDIR(info.st_mode))
+		{
+			FindFiles(path, ext, outFiles);
+		}
+		else if (EndsWith(name, ext))
+		{
+			outFiles.emplace_back(path);
+		}
+	}
+	closedir(d);
+#endif
+}
@@ -0,0 +1,28 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <vector>
+
+// Offline conversion of source assets into the binary formats
+// the game loads at runtime (run with: Game -bake [dir] [-compress])
+class AssetBaker
+{
+public:
+	// Bakes every asset under the directory, returns false if any failed
+	// (compressTextures stores textures block compressed)
+	static bool BakeDirectory(const std::string& dir, bool compressTextures = false);
+	// Recursively find all files under dir with the extension
+	static void FindFiles(const std::string& dir, const std::string& ext,
+		std::vector<std::string>& outFiles);
+private:
+	// Bakes every file under dir with the extension
+	static bool BakeFiles(const std::string& dir, const std::string& ext,
+		bool(*bake)(const std::string&));
+};
@@ -0,0 +1,194 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AssetLoader.h"
+#include "Profiler.h"
+#include <SDL/SDL_timer.h>
+
+AssetLoader::AssetLoader(unsigned numThreads, size_t maxUploads)
+	:mMaxUploads(maxUploads > 0 ? maxUploads : 1)
+	,mReading(0)
+	,mGeneration(0)
+	,mQuit(false)
+{
+	for (unsigned i = 0; i < numThreads; i++)
+	{
+		mThreads.emplace_back(&AssetLoader::ThreadLoop, this);
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+		mReads.clear();
+		mUploads.clear();
+	}
+	mWake.notify_all();
+	mUploadSpace.notify_all();
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+void AssetLoader::Load(const std::string& fileName, ReadFunc read)
+{
+	if (!mPending.emplace(fileName).second)
+	{
+		// Already on its way
+		return;
+	}
+
+	if (mThreads.empty())
+	{
+		// No loader threads, so just do it all now
+		FinishFunc finish = read();
+		mPending.erase(fileName);
+		if (finish)
+		{
+			finish();
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mReads.emplace_back(fileName, std::move(read));
+	}
+	mWake.notify_one();
+}
+
+bool AssetLoader::IsPending(const std::string& fileName) const
+{
+	return mPending.find(fileName) != mPending.end();
+}
+
+void AssetLoader::ProcessUploads(float budgetMs)
+{
+	if (mPending.empty())
+	{
+		return;
+	}
+	PROFILE_SCOPE("AssetLoader::ProcessUploads");
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 budget = static_cast<Uint64>(budgetMs * 0.001f * SDL_GetPerformanceFrequency());
+	while (RunUpload(false))
+	{
+		if (SDL_GetPerformanceCounter() - start >= budget)
+		{
+			break;
+		}
+	}
+}
+
+void AssetLoader::Wait(const std::string& fileName)
+{
+	if (IsPending(fileName))
+	{
+		PROFILE_SCOPE_DETAIL("AssetLoader::Wait", fileName.c_str());
+		// Finish whatever comes first, since this file's finish step
+		// may be behind others in the queue
+		while (IsPending(fileName))
+		{
+			RunUpload(true);
+		}
+	}
+}
+
+void AssetLoader::WaitAll()
+{
+	if (!mPending.empty())
+	{
+		PROFILE_SCOPE("AssetLoader::WaitAll");
+		while (!mPending.empty())
+		{
+			RunUpload(true);
+		}
+	}
+}
+
+void AssetLoader::Cancel()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mReads.clear();
+	mUploads.clear();
+	mGeneration++;
+	mUploadSpace.notify_all();
+	// Reads that were already running finish into the old generation,
+	// so they get thrown away too
+	mUploadSpace.wait(lock, [this] { return mReading == 0; });
+	mPending.clear();
+}
+
+bool AssetLoader::RunUpload(bool wait)
+{
+	Upload upload;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (wait)
+		{
+			mUploadReady.wait(lock, [this] { return !mUploads.empty(); });
+		}
+		else if (mUploads.empty())
+		{
+			return false;
+		}
+		upload = std::move(mUploads.front());
+		mUploads.pop_front();
+	}
+	mUploadSpace.notify_one();
+
+	// The file's done once its finish step runs (reads that
+	// failed don't have one)
+	mPending.erase(upload.mFileName);
+	if (upload.mFinish)
+	{
+		PROFILE_SCOPE_DETAIL("AssetLoader::Finish", upload.mFileName.c_str());
+		upload.mFinish();
+	}
+	return true;
+}
+
+void AssetLoader::ThreadLoop()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mWake.wait(lock, [this] { return mQuit || !mReads.empty(); });
+		if (mQuit)
+		{
+			return;
+		}
+		std::pair<std::string, ReadFunc> read = std::move(mReads.front());
+		mReads.pop_front();
+		unsigned generation = mGeneration;
+		mReading++;
+		lock.unlock();
+
+		FinishFunc finish;
+		{
+			PROFILE_SCOPE_DETAIL("AssetLoader::Read", read.first.c_str());
+			finish = read.second();
+		}
+
+		lock.lock();
+		// Wait for room in the upload queue
+		mUploadSpace.wait(lock, [this, generation] {
+			return mQuit || generation != mGeneration || mUploads.size() < mMaxUploads;
+		});
+		if (!mQuit && generation == mGeneration)
+		{
+			mUploads.emplace_back(Upload{ std::move(read.first), std::move(finish) });
+			mUploadReady.notify_one();
+		}
+		mReading--;
+		mUploadSpace.notify_all();
+	}
+}
@@ -0,0 +1,84 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Loads assets in two steps: the file reading and decoding runs on
+// background threads, and the rest (GL uploads, and making the asset
+// visible to the game) runs on the main thread from a bounded queue,
+// a few milliseconds' worth per frame.
+class AssetLoader
+{
+public:
+	// What's left to do on the main thread once the file's read
+	using FinishFunc = std::function<void()>;
+	// Reads the file (on a loader thread) and returns the finish step
+	using ReadFunc = std::function<FinishFunc()>;
+
+	// maxUploads is how many finished reads can wait for the main
+	// thread (loader threads stall when it's full, which bounds the
+	// memory held by decoded data)
+	AssetLoader(unsigned numThreads = 2, size_t maxUploads = 32);
+	~AssetLoader();
+
+	// Queues a load. fileName is the key for IsPending/Wait, and the
+	// read function shouldn't touch anything but the file.
+	// (Main thread only, like everything below)
+	void Load(const std::string& fileName, ReadFunc read);
+	// Is fileName queued, being read, or waiting for its finish step?
+	bool IsPending(const std::string& fileName) const;
+
+	// Runs finish steps until the queue's empty or budgetMs is used up
+	// (always runs at least one, so loads can't stall)
+	void ProcessUploads(float budgetMs);
+	// Blocks until fileName is done, running finish steps meanwhile
+	void Wait(const std::string& fileName);
+	// Blocks until every queued load is done
+	void WaitAll();
+	// Drops every queued load (before the assets they finish are deleted)
+	void Cancel();
+
+	size_t GetNumPending() const { return mPending.size(); }
+private:
+	void ThreadLoop();
+	// Runs one finish step if there is one (blocks for one if wait)
+	bool RunUpload(bool wait);
+
+	struct Upload
+	{
+		std::string mFileName;
+		FinishFunc mFinish;
+	};
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	// Signaled when there's a read to do (or on shutdown)
+	std::condition_variable mWake;
+	// Signaled when an upload's added
+	std::condition_variable mUploadReady;
+	// Signaled when an upload's removed, or a read finishes
+	std::condition_variable mUploadSpace;
+	std::deque<std::pair<std::string, ReadFunc>> mReads;
+	std::deque<Upload> mUploads;
+	size_t mMaxUploads;
+	// Reads running right now
+	size_t mReading;
+	// Bumped by Cancel, so reads already running throw their result away
+	unsigned mGeneration;
+	bool mQuit;
+	// Every file that isn't finished (only used on the main thread)
+	std::unordered_set<std::string> mPending;
+};
@@ -0,0 +1,220 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AtlasPacker.h"
+#include "LevelLoader.h"
+#include <SOIL/SOIL.h>
+#include <SDL/SDL_log.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/prettywriter.h>
+
+namespace
+{
+	// Has to match the version Renderer::LoadAtlas expects
+	const int AtlasVersion = 1;
+	// Empty pixels around each image, so filtering doesn't pull
+	// in its neighbors
+	const int Padding = 2;
+
+	// The images drawn by UIScreen/HUD (mesh textures can't be in an
+	// atlas, since their texture coordinates span the whole texture)
+	const char* UIImages[] = {
+		"Blip.png",
+		"ButtonBlue.png",
+		"ButtonYellow.png",
+		"Crosshair.png",
+		"CrosshairGreen.png",
+		"CrosshairRed.png",
+		"DialogBG.png",
+		"HealthBar.png",
+		"Radar.png",
+		"RadarArrow.png"
+	};
+
+	struct PackedImage
+	{
+		std::string mFileName;
+		unsigned char* mPixels;
+		int mWidth;
+		int mHeight;
+		int mPage;
+		int mX;
+		int mY;
+	};
+
+	struct Page
+	{
+		std::vector<unsigned char> mPixels;
+		// Bottom of the lowest shelf
+		int mUsedHeight;
+	};
+
+	int NextPowerOfTwo(int value)
+	{
+		int result = 1;
+		while (result < value)
+		{
+			result *= 2;
+		}
+		return result;
+	}
+}
+
+bool AtlasPacker::PackUI(const std::string& dir)
+{
+	std::vector<std::string> images;
+	for (const char* image : UIImages)
+	{
+		images.emplace_back(dir + "/" + image);
+	}
+	return Pack(dir + "/UI.gpatlas", images);
+}
+
+bool AtlasPacker::Pack(const std::string& atlasFile,
+	const std::vector<std::string>& images, int pageSize)
+{
+	std::vector<PackedImage> packed;
+	bool success = true;
+	for (const auto& fileName : images)
+	{
+		PackedImage image{ fileName, nullptr, 0, 0, 0, 0, 0 };
+		int channels = 0;
+		image.mPixels = SOIL_load_image(fileName.c_str(), &image.mWidth,
+			&image.mHeight, &channels, SOIL_LOAD_RGBA);
+		if (image.mPixels == nullptr)
+		{
+			SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
+			success = false;
+			break;
+		}
+		if (image.mWidth + Padding > pageSize || image.mHeight + Padding > pageSize)
+		{
+			SDL_Log("Image %s doesn't fit in a %d page", fileName.c_str(), pageSize);
+			SOIL_free_image_data(image.mPixels);
+			success = false;
+			break;
+		}
+		packed.emplace_back(image);
+	}
+	if (!success)
+	{
+		for (auto& image : packed)
+		{
+			SOIL_free_image_data(image.mPixels);
+		}
+		return false;
+	}
+
+	// Shelf packing: tallest first, left to right along a shelf, and a
+	// new shelf (or page) when one's full
+	std::vector<PackedImage*> order;
+	for (auto& image : packed)
+	{
+		order.emplace_back(&image);
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[](const PackedImage* a, const PackedImage* b) {
+		return a->mHeight > b->mHeight;
+	});
+	std::vector<Page> pages;
+	int x = 0;
+	int y = 0;
+	int shelfHeight = 0;
+	for (PackedImage* image : order)
+	{
+		int width = image->mWidth + Padding;
+		int height = image->mHeight + Padding;
+		if (x + width > pageSize)
+		{
+			x = 0;
+			y += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (pages.empty() || y + height > pageSize)
+		{
+			pages.emplace_back(Page{ std::vector<unsigned char>(pageSize * pageSize * 4, 0), 0 });
+			x = 0;
+			y = 0;
+			shelfHeight = 0;
+		}
+		Page& page = pages.back();
+		image->mPage = static_cast<int>(pages.size() - 1);
+		image->mX = x;
+		image->mY = y;
+		for (int row = 0; row < image->mHeight; row++)
+		{
+			memcpy(&page.mPixels[((y + row) * pageSize + x) * 4],
+				&image->mPixels[row * image->mWidth * 4], image->mWidth * 4);
+		}
+		x += width;
+		shelfHeight = std::max(shelfHeight, height);
+		page.mUsedHeight = std::max(page.mUsedHeight, y + height);
+	}
+
+	// Write each page, cut down to the rows it uses
+	std::string baseName = atlasFile.substr(0, atlasFile.find_last_of('.'));
+	std::vector<std::string> pageFiles;
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		std::string pageFile = baseName + std::to_string(i) + ".tga";
+		int height = NextPowerOfTwo(pages[i].mUsedHeight);
+		if (!SOIL_save_image(pageFile.c_str(), SOIL_SAVE_TYPE_TGA,
+			pageSize, height, 4, pages[i].mPixels.data()))
+		{
+			SDL_Log("Failed to write atlas page %s", pageFile.c_str());
+			success = false;
+		}
+		pageFiles.emplace_back(pageFile);
+	}
+
+	rapidjson::Document doc;
+	doc.SetObject();
+	rapidjson::Document::AllocatorType& alloc = doc.GetAllocator();
+	JsonHelper::AddInt(alloc, doc, "version", AtlasVersion);
+	rapidjson::Value pagesJson(rapidjson::kArrayType);
+	for (const auto& pageFile : pageFiles)
+	{
+		pagesJson.PushBack(rapidjson::Value(pageFile.c_str(), alloc).Move(), alloc);
+	}
+	doc.AddMember("pages", pagesJson, alloc);
+	rapidjson::Value regions(rapidjson::kArrayType);
+	for (auto& image : packed)
+	{
+		rapidjson::Value region(rapidjson::kObjectType);
+		JsonHelper::AddString(alloc, region, "file", image.mFileName);
+		JsonHelper::AddInt(alloc, region, "page", image.mPage);
+		JsonHelper::AddInt(alloc, region, "x", image.mX);
+		JsonHelper::AddInt(alloc, region, "y", image.mY);
+		JsonHelper::AddInt(alloc, region, "width", image.mWidth);
+		JsonHelper::AddInt(alloc, region, "height", image.mHeight);
+		regions.PushBack(region, alloc);
+		SOIL_free_image_data(image.mPixels);
+	}
+	doc.AddMember("regions", regions, alloc);
+	if (!success)
+	{
+		return false;
+	}
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	doc.Accept(writer);
+	std::ofstream outFile(atlasFile);
+	if (!outFile.is_open())
+	{
+		SDL_Log("Failed to write atlas %s", atlasFile.c_str());
+		return false;
+	}
+	outFile << buffer.GetString();
+	SDL_Log("Packed %d images into %d pages for %s", static_cast<int>(packed.size()),
+		static_cast<int>(pages.size()), atlasFile.c_str());
+	return true;
+}
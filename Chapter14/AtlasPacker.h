@@ -0,0 +1,24 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <vector>
+
+// Packs images into atlas pages offline, so 2D drawing can batch
+// quads that used to be separate textures (run with: Game -atlas [dir]).
+// Writes the pages as <atlas name><page>.tga, and the atlas file
+// listing where each image went, which Renderer::LoadAtlas reads.
+class AtlasPacker
+{
+public:
+	// Packs the UI/HUD images in dir into dir/UI.gpatlas
+	static bool PackUI(const std::string& dir);
+	static bool Pack(const std::string& atlasFile,
+		const std::vector<std::string>& images, int pageSize = 1024);
+};
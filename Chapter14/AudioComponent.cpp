@@ -14,6 +14,8 @@
 AudioComponent::AudioComponent(Actor* owner, int updateOrder)
 	:Component(owner, updateOrder)
 {
+	// Talks to FMOD, so it updates on the main thread
+	mUpdatePhase = EPhaseLate;
 }
 
 AudioComponent::~AudioComponent()
@@ -16,6 +16,7 @@ class AudioComponent : public Component
 {
 public:
 	AudioComponent(class Actor* owner, int updateOrder = 200);
+	DECLARE_POOLED(AudioComponent)
 	~AudioComponent();
 
 	void Update(float deltaTime) override;
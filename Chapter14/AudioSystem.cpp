@@ -11,6 +11,7 @@
 #include <fmod_studio.hpp>
 #include <fmod_errors.h>
 #include <vector>
+#include "Profiler.h"
 
 unsigned int AudioSystem::sNextID = 0;
 
@@ -238,6 +239,11 @@ SoundEvent AudioSystem::PlayEvent(const std::string& name)
 
 void AudioSystem::Update(float deltaTime)
 {
+	PROFILE_SCOPE("AudioSystem::Update");
+	if (!mSystem)
+	{
+		return;
+	}
 	// Find any stopped event instances
 	std::vector<unsigned int> done;
 	for (auto& iter : mEventInstances)
@@ -280,9 +286,13 @@ namespace
 
 void AudioSystem::SetListener(const Matrix4& viewMatrix)
 {
+	if (!mSystem)
+	{
+		return;
+	}
 	// Invert the view matrix to get the correct vectors
 	Matrix4 invView = viewMatrix;
-	invView.Invert();
+	invView.InvertAffine();
 	FMOD_3D_ATTRIBUTES listener;
 	// Set position, forward, up
 	listener.position = VecToFMOD(invView.GetTranslation());
@@ -32,6 +32,8 @@ public:
 	AudioSystem(class Game* game);
 	~AudioSystem();
 
+	// (Headless runs don't call Initialize, so there's no FMOD
+	// system, nothing plays and Update does nothing)
 	bool Initialize();
 	void Shutdown();
 
@@ -13,6 +13,7 @@ class BallActor : public Actor
 {
 public:
 	BallActor(class Game* game);
+	DECLARE_POOLED(BallActor)
 
 	void UpdateActor(float deltaTime) override;
 
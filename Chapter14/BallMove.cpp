@@ -16,6 +16,12 @@
 BallMove::BallMove(Actor* owner)
 	:MoveComponent(owner)
 {
+	// Overrides Update, so it can't be batched with plain MoveComponents.
+	// Segment casts only read the physics world, so balls can update
+	// in parallel (after the boxes have moved, see Game::UpdateActors).
+	mUpdateMode = EUpdateInPhase;
+	mUpdatePhase = EPhasePhysics;
+	mParallelSafe = true;
 }
 
 void BallMove::Update(float deltaTime)
@@ -40,7 +46,10 @@ void BallMove::Update(float deltaTime)
 		TargetActor* target = dynamic_cast<TargetActor*>(info.mActor);
 		if (target)
 		{
-			static_cast<BallActor*>(mOwner)->HitTarget();
+			// Playing the sound goes through FMOD, so do it
+			// on the main thread once the phase is done
+			BallActor* ball = static_cast<BallActor*>(mOwner);
+			mOwner->GetGame()->Defer([ball]() { ball->HitTarget(); });
 		}
 	}
 	MoveComponent::Update(deltaTime);
@@ -13,6 +13,7 @@ class BallMove : public MoveComponent
 {
 public:
 	BallMove(class Actor* owner);
+	DECLARE_POOLED(BallMove)
 
 	void Update(float deltaTime) override;
 
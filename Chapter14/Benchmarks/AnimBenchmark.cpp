@@ -0,0 +1,268 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Compares the old way of loading a .gpanim (parse the JSON into a
+// std::vector<BoneTransform> per bone) with the quantized clips
+// Animation now uses:
+//   JSON       - original loader, uncompressed BoneTransforms
+//   Compress   - Animation::Load with no .bin (parse + quantize)
+//   Mapped     - Animation::Load of the baked .gpanim.bin
+// Also reports the memory each uses, the time to sample a full pose
+// and the largest position error of any bone in the global pose.
+// Finally it times a crowd playing the clip with and without the
+// PoseCache.
+
+#include "../Animation.h"
+#include "../Skeleton.h"
+#include "../LevelLoader.h"
+#include "../PoseCache.h"
+#include <SDL/SDL_log.h>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+// Stand-ins so the benchmark doesn't need to link the whole game
+void SDL_Log(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("\n");
+}
+
+bool LevelLoader::LoadJSON(const std::string& fileName, rapidjson::Document& outDoc)
+{
+	std::ifstream file(fileName);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	outDoc.Parse(contents.str().c_str());
+	return outDoc.IsObject();
+}
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// The original Animation::Load/GetGlobalPoseAtTime
+	struct JsonAnimation
+	{
+		size_t mNumBones = 0;
+		size_t mNumFrames = 0;
+		float mFrameDuration = 0.0f;
+		std::vector<std::vector<BoneTransform>> mTracks;
+
+		bool Load(const std::string& fileName)
+		{
+			rapidjson::Document doc;
+			if (!LevelLoader::LoadJSON(fileName, doc))
+			{
+				return false;
+			}
+			const rapidjson::Value& sequence = doc["sequence"];
+			mNumFrames = sequence["frames"].GetUint();
+			mNumBones = sequence["bonecount"].GetUint();
+			mFrameDuration = static_cast<float>(sequence["length"].GetDouble()) / (mNumFrames - 1);
+			mTracks.resize(mNumBones);
+			const rapidjson::Value& tracks = sequence["tracks"];
+			for (rapidjson::SizeType i = 0; i < tracks.Size(); i++)
+			{
+				size_t boneIndex = tracks[i]["bone"].GetUint();
+				const rapidjson::Value& transforms = tracks[i]["transforms"];
+				BoneTransform temp;
+				for (rapidjson::SizeType j = 0; j < transforms.Size(); j++)
+				{
+					const rapidjson::Value& rot = transforms[j]["rot"];
+					const rapidjson::Value& trans = transforms[j]["trans"];
+					temp.mRotation.x = rot[0].GetDouble();
+					temp.mRotation.y = rot[1].GetDouble();
+					temp.mRotation.z = rot[2].GetDouble();
+					temp.mRotation.w = rot[3].GetDouble();
+					temp.mTranslation.x = trans[0].GetDouble();
+					temp.mTranslation.y = trans[1].GetDouble();
+					temp.mTranslation.z = trans[2].GetDouble();
+					mTracks[boneIndex].emplace_back(temp);
+				}
+			}
+			return true;
+		}
+
+		size_t GetDataSize() const
+		{
+			size_t size = mTracks.capacity() * sizeof(std::vector<BoneTransform>);
+			for (const auto& track : mTracks)
+			{
+				size += track.capacity() * sizeof(BoneTransform);
+			}
+			return size;
+		}
+
+		void GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skeleton* inSkeleton, float inTime) const
+		{
+			outPoses.resize(mNumBones);
+			size_t frame = static_cast<size_t>(inTime / mFrameDuration);
+			frame = frame < mNumFrames - 1 ? frame : mNumFrames - 2;
+			float pct = inTime / mFrameDuration - frame;
+			const std::vector<Skeleton::Bone>& bones = inSkeleton->GetBones();
+			for (size_t bone = 0; bone < mNumBones; bone++)
+			{
+				Matrix4 localMat;
+				if (mTracks[bone].size() > 0)
+				{
+					localMat = BoneTransform::Interpolate(mTracks[bone][frame],
+						mTracks[bone][frame + 1], pct).ToMatrix();
+				}
+				outPoses[bone] = bone == 0 ? localMat : localMat * outPoses[bones[bone].mParent];
+			}
+		}
+	};
+
+	const int LoadRuns = 10;
+	const int SampleRuns = 10000;
+	const int CrowdSize = 500;
+	const int CrowdFrames = 120;
+}
+
+int main(int argc, char** argv)
+{
+	std::string animFile = argc > 1 ? argv[1] : "../Assets/CatRunSprint.gpanim";
+	std::string skelFile = argc > 2 ? argv[2] : "../Assets/CatWarrior.gpskel";
+	std::string binFile = animFile + ".bin";
+	std::remove(binFile.c_str());
+
+	Skeleton skel;
+	if (!skel.Load(skelFile))
+	{
+		printf("Failed to load %s\n", skelFile.c_str());
+		return 1;
+	}
+
+	JsonAnimation json;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < LoadRuns; i++)
+	{
+		json = JsonAnimation();
+		json.Load(animFile);
+	}
+	double jsonMs = ElapsedMs(start) / LoadRuns;
+
+	start = Clock::now();
+	for (int i = 0; i < LoadRuns; i++)
+	{
+		Animation anim;
+		anim.Load(animFile);
+	}
+	double compressMs = ElapsedMs(start) / LoadRuns;
+
+	if (!Animation::Bake(animFile))
+	{
+		return 1;
+	}
+	start = Clock::now();
+	for (int i = 0; i < LoadRuns; i++)
+	{
+		Animation anim;
+		anim.Load(animFile);
+	}
+	double mappedMs = ElapsedMs(start) / LoadRuns;
+	Animation mapped;
+	mapped.Load(animFile);
+	std::remove(binFile.c_str());
+
+	printf("%s: %zu bones, %zu frames\n", animFile.c_str(),
+		mapped.GetNumBones(), mapped.GetNumFrames());
+	printf("Load ms  | JSON %8.3f | Compress %8.3f | Mapped %8.4f\n",
+		jsonMs, compressMs, mappedMs);
+	printf("Bytes    | JSON %8zu | Quantized %7zu\n",
+		json.GetDataSize(), mapped.GetDataSize());
+
+	// Sample across the whole clip
+	std::vector<Matrix4> jsonPoses;
+	std::vector<Matrix4> poses;
+	float maxError = 0.0f;
+	start = Clock::now();
+	for (int i = 0; i < SampleRuns; i++)
+	{
+		float t = mapped.GetDuration() * i / (SampleRuns - 1);
+		json.GetGlobalPoseAtTime(jsonPoses, &skel, t);
+	}
+	double jsonSampleUs = ElapsedMs(start) * 1000.0 / SampleRuns;
+	start = Clock::now();
+	for (int i = 0; i < SampleRuns; i++)
+	{
+		float t = mapped.GetDuration() * i / (SampleRuns - 1);
+		mapped.GetGlobalPoseAtTime(poses, &skel, t);
+	}
+	double sampleUs = ElapsedMs(start) * 1000.0 / SampleRuns;
+	for (int i = 0; i < SampleRuns; i += 7)
+	{
+		float t = mapped.GetDuration() * i / (SampleRuns - 1);
+		json.GetGlobalPoseAtTime(jsonPoses, &skel, t);
+		mapped.GetGlobalPoseAtTime(poses, &skel, t);
+		for (size_t b = 0; b < poses.size(); b++)
+		{
+			Vector3 diff = poses[b].GetTranslation() - jsonPoses[b].GetTranslation();
+			maxError = Math::Max(maxError, diff.Length());
+		}
+	}
+	printf("Sample us| JSON %8.3f | Quantized %8.3f | max bone error %f\n",
+		jsonSampleUs, sampleUs, maxError);
+
+	// A crowd with random start times, stepped at 60 FPS
+	std::vector<float> startTimes(CrowdSize);
+	for (int i = 0; i < CrowdSize; i++)
+	{
+		startTimes[i] = mapped.GetDuration() * Math::Fmod(i * 0.618034f, 1.0f);
+	}
+	std::vector<MatrixPalette> palettes(CrowdSize);
+	start = Clock::now();
+	for (int f = 0; f < CrowdFrames; f++)
+	{
+		for (int i = 0; i < CrowdSize; i++)
+		{
+			float t = Math::Fmod(startTimes[i] + f / 60.0f, mapped.GetDuration());
+			mapped.GetGlobalPoseAtTime(poses, &skel, t);
+			Matrix4::MultiplyArray(skel.GetGlobalInvBindPoses().data(), poses.data(),
+				palettes[i].mEntry, skel.GetNumBones());
+		}
+	}
+	double crowdMs = ElapsedMs(start) / CrowdFrames;
+
+	PoseCache cache;
+	std::vector<std::shared_ptr<const MatrixPalette>> shared(CrowdSize);
+	int hits = 0;
+	int misses = 0;
+	start = Clock::now();
+	for (int f = 0; f < CrowdFrames; f++)
+	{
+		cache.BeginFrame();
+		hits += cache.GetHits();
+		misses += cache.GetMisses();
+		for (int i = 0; i < CrowdSize; i++)
+		{
+			float t = Math::Fmod(startTimes[i] + f / 60.0f, mapped.GetDuration());
+			shared[i] = cache.GetPalette(&mapped, &skel, t, SIZE_MAX, poses);
+		}
+	}
+	double cachedMs = ElapsedMs(start) / CrowdFrames;
+	printf("Crowd ms | %d meshes %8.3f | PoseCache %8.3f | hit rate %.1f%%\n",
+		CrowdSize, crowdMs, cachedMs, 100.0 * hits / Math::Max(hits + misses, 1));
+	return 0;
+}
@@ -0,0 +1,137 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Times LightClusters::Build (the CPU side of the clustered lighting
+// pass) for random point lights spread over a level like the ones
+// LevelGenerator makes:
+//   Visible   - lights in at least one cluster
+//   Avg/Max   - lights per non-empty cluster (what a pixel loops over,
+//               versus every light for the per-light path)
+// Times are the average milliseconds per build.
+
+#include "../LightClusters.h"
+#include "../JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	const int Frames = 200;
+	// Same as the Renderer
+	const float NearPlane = 10.0f;
+	const float FarPlane = 10000.0f;
+
+	// Every light whose center is on screen has to be in the
+	// cluster that center is in
+	bool CheckCenters(const LightClusters& clusters, const Matrix4& view,
+		const Matrix4& proj, const std::vector<float>& x, const std::vector<float>& y,
+		const std::vector<float>& z)
+	{
+		const std::vector<uint32_t>& grid = clusters.GetGrid();
+		const std::vector<uint32_t>& indices = clusters.GetIndices();
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			Vector3 v = Vector3::Transform(Vector3(x[i], y[i], z[i]), view);
+			float ndcX = v.x * proj.mat[0][0] / v.z;
+			float ndcY = v.y * proj.mat[1][1] / v.z;
+			if (v.z < NearPlane || v.z > FarPlane ||
+				Math::Abs(ndcX) >= 1.0f || Math::Abs(ndcY) >= 1.0f)
+			{
+				continue;
+			}
+			int cx = static_cast<int>((ndcX * 0.5f + 0.5f) * LightClusters::NumX);
+			int cy = static_cast<int>((ndcY * 0.5f + 0.5f) * LightClusters::NumY);
+			int cz = static_cast<int>(std::log(v.z) * clusters.GetSliceScale() +
+				clusters.GetSliceBias());
+			cz = Math::Clamp(cz, 0, LightClusters::NumZ - 1);
+			int cluster = (cz * LightClusters::NumY + cy) * LightClusters::NumX + cx;
+			auto begin = indices.begin() + grid[cluster * 2];
+			auto end = begin + grid[cluster * 2 + 1];
+			if (std::find(begin, end, static_cast<uint32_t>(i)) == end)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> horizontal(-3000.0f, 3000.0f);
+	std::uniform_real_distribution<float> height(0.0f, 150.0f);
+
+	// The default camera: at the origin (raised a bit), looking down +x
+	Matrix4 view = Matrix4::CreateLookAt(Vector3(0.0f, 0.0f, 100.0f),
+		Vector3(100.0f, 0.0f, 100.0f), Vector3::UnitZ);
+	Matrix4 proj = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
+		1024.0f, 768.0f, NearPlane, FarPlane);
+
+	// The calling thread plus three workers
+	JobSystem jobs(3);
+
+	printf(" Lights | Visible | Avg | Max | 1 thread ms | 4 threads ms | Match\n");
+	for (int count : { 10, 100, 1000, 10000 })
+	{
+		std::vector<float> x, y, z, radius;
+		for (int i = 0; i < count; i++)
+		{
+			x.emplace_back(horizontal(rng));
+			y.emplace_back(horizontal(rng));
+			z.emplace_back(height(rng));
+			radius.emplace_back(300.0f);
+		}
+
+		LightClusters clusters;
+		Clock::time_point start = Clock::now();
+		for (int f = 0; f < Frames; f++)
+		{
+			clusters.Build(view, proj, NearPlane, FarPlane, x.data(), y.data(),
+				z.data(), radius.data(), x.size());
+		}
+		double singleMs = ElapsedMs(start) / Frames;
+		std::vector<uint32_t> singleIndices = clusters.GetIndices();
+
+		start = Clock::now();
+		for (int f = 0; f < Frames; f++)
+		{
+			clusters.Build(view, proj, NearPlane, FarPlane, x.data(), y.data(),
+				z.data(), radius.data(), x.size(), &jobs);
+		}
+		double threadedMs = ElapsedMs(start) / Frames;
+
+		const std::vector<uint32_t>& grid = clusters.GetGrid();
+		int nonEmpty = 0;
+		uint32_t maxLights = 0;
+		for (int c = 0; c < LightClusters::NumClusters; c++)
+		{
+			nonEmpty += grid[c * 2 + 1] > 0 ? 1 : 0;
+			maxLights = std::max(maxLights, grid[c * 2 + 1]);
+		}
+		float avgLights = nonEmpty > 0 ?
+			static_cast<float>(clusters.GetIndices().size()) / nonEmpty : 0.0f;
+		bool match = singleIndices == clusters.GetIndices() &&
+			CheckCenters(clusters, view, proj, x, y, z);
+		printf("%7d | %7d | %3.0f | %3u | %11.4f | %12.4f | %s\n", count,
+			static_cast<int>(clusters.GetNumVisible()), avgLights, maxLights,
+			singleMs, threadedMs, match ? "yes" : "NO");
+	}
+	return 0;
+}
@@ -0,0 +1,162 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Times the Math.h kernels. The Makefile builds this three times
+// so the backends can be compared:
+//   mathbench_scalar - MATH_NO_SIMD
+//   mathbench        - SSE2
+//   mathbench_avx    - AVX
+// Times are nanoseconds per operation.
+
+#include "../Math.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	const size_t Count = 4096;
+	const int Runs = 50;
+	const int Repeats = 7;
+
+	// Best time of several repeats of func (which does ops
+	// operations), in nanoseconds per operation
+	template <typename Func>
+	double BestNs(size_t ops, Func func)
+	{
+		double best = Math::Infinity;
+		for (int i = 0; i < Repeats; i++)
+		{
+			Clock::time_point start = Clock::now();
+			func();
+			double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			best = Math::Min(best, ns / ops);
+		}
+		return best;
+	}
+
+	// Random rotation/scale/translation matrices
+	std::vector<Matrix4> MakeMatrices(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+		std::vector<Matrix4> mats(Count);
+		for (Matrix4& m : mats)
+		{
+			Vector3 axis = Vector3::Normalize(Vector3(dist(rng), dist(rng), dist(rng)));
+			Quaternion q(axis, dist(rng) * Math::Pi);
+			m = Matrix4::CreateScale(1.0f + dist(rng) * 0.5f) *
+				Matrix4::CreateFromQuaternion(q) *
+				Matrix4::CreateTranslation(Vector3(dist(rng), dist(rng), dist(rng)) * 100.0f);
+		}
+		return mats;
+	}
+}
+
+int main(int argc, char** argv)
+{
+#if defined(MATH_SIMD_AVX)
+	const char* backend = "AVX";
+#elif defined(MATH_SIMD_SSE)
+	const char* backend = "SSE2";
+#else
+	const char* backend = "Scalar";
+#endif
+	std::mt19937 rng(1234);
+	std::vector<Matrix4> a = MakeMatrices(rng);
+	std::vector<Matrix4> b = MakeMatrices(rng);
+	std::vector<Matrix4> out(Count);
+	// Summed so the optimizer can't throw the results away
+	float check = 0.0f;
+
+	double mulNs = BestNs(Count * Runs, [&]()
+	{
+		for (int run = 0; run < Runs; run++)
+		{
+			Matrix4::MultiplyArray(a.data(), b.data(), out.data(), Count);
+			check += out[run].mat[3][0];
+		}
+	});
+
+	double invNs = BestNs(Count * Runs, [&]()
+	{
+		for (int run = 0; run < Runs; run++)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				out[i] = a[i];
+				out[i].Invert();
+			}
+			check += out[run].mat[3][0];
+		}
+	});
+
+	double affineNs = BestNs(Count * Runs, [&]()
+	{
+		for (int run = 0; run < Runs; run++)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				out[i] = a[i];
+				out[i].InvertAffine();
+			}
+			check += out[run].mat[3][0];
+		}
+	});
+
+	std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+	std::vector<Vector3> points(Count);
+	for (Vector3& p : points)
+	{
+		p.Set(dist(rng), dist(rng), dist(rng));
+	}
+	std::vector<Vector3> transformed(Count);
+	double transformNs = BestNs(Count * Runs, [&]()
+	{
+		for (int run = 0; run < Runs; run++)
+		{
+			for (size_t i = 0; i < Count; i++)
+			{
+				transformed[i] = Vector3::Transform(points[i], a[run]);
+			}
+			check += transformed[run].x;
+		}
+	});
+
+	double transformArrayNs = BestNs(Count * Runs, [&]()
+	{
+		for (int run = 0; run < Runs; run++)
+		{
+			Vector3::TransformArray(points.data(), transformed.data(), Count, a[run]);
+			check += transformed[run].x;
+		}
+	});
+
+	std::vector<Quaternion> quats(Count);
+	for (Quaternion& q : quats)
+	{
+		q = Quaternion(Vector3::Normalize(Vector3(dist(rng), dist(rng), dist(rng))), dist(rng));
+	}
+	double slerpNs = BestNs((Count - 1) * Runs, [&]()
+	{
+		for (int run = 0; run < Runs; run++)
+		{
+			for (size_t i = 0; i + 1 < Count; i++)
+			{
+				check += Quaternion::Slerp(quats[i], quats[i + 1], 0.3f).w;
+			}
+		}
+	});
+
+	printf("%-6s | Mul %6.2f | Invert %6.2f | InvertAffine %6.2f | Transform %5.2f | "
+		"TransformArray %5.2f | Slerp %6.2f | (%g)\n", backend, mulNs, invNs,
+		affineNs, transformNs, transformArrayNs, slerpNs, check);
+	return 0;
+}
@@ -0,0 +1,351 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Compares broadphase algorithms on a set of slowly moving boxes:
+//   Pairwise      - naive O(n^2) test of every pair
+//   SortAndSweep  - std::sort on min.x every frame, then sweep
+//   AABBTree      - refit the tree, then query it with each box
+//                   (what PhysWorld::TestPairwise does)
+//   IncrementalSAP - persistent three axis sweep and prune (SweepAndPrune)
+//   Churn         - IncrementalSAP with 1% of the boxes destroyed and
+//                   created again every frame (like balls being fired)
+// Times are the average milliseconds per frame. Every method runs the
+// same frames, and the pair counts are from the last one, so they match.
+//
+// Also compares casting segments against every box one at a time
+// (Intersect(LineSegment, AABB)) with the batched SIMD version
+// (Intersect(LineSegment, AABBSoA)) that PhysWorld::SegmentCast uses.
+
+#include "../AABBTree.h"
+#include "../SweepAndPrune.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Body
+	{
+		AABB mBox;
+		Vector3 mVelocity;
+	};
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Boxes are spread out so there are a few overlaps per box
+	std::vector<Body> MakeBodies(size_t count)
+	{
+		std::mt19937 rng(1234);
+		float worldSize = 100.0f * std::cbrt(static_cast<float>(count));
+		std::uniform_real_distribution<float> pos(-worldSize, worldSize);
+		std::uniform_real_distribution<float> size(5.0f, 25.0f);
+		std::uniform_real_distribution<float> vel(-2.0f, 2.0f);
+		std::vector<Body> bodies;
+		bodies.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			Vector3 center(pos(rng), pos(rng), pos(rng));
+			Vector3 extents(size(rng), size(rng), size(rng));
+			bodies.push_back(Body{ AABB(center - extents, center + extents),
+				Vector3(vel(rng), vel(rng), vel(rng)) });
+		}
+		return bodies;
+	}
+
+	void MoveBodies(std::vector<Body>& bodies)
+	{
+		for (Body& b : bodies)
+		{
+			b.mBox.mMin += b.mVelocity;
+			b.mBox.mMax += b.mVelocity;
+		}
+	}
+
+	size_t Pairwise(const std::vector<Body>& bodies)
+	{
+		size_t pairs = 0;
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			for (size_t j = i + 1; j < bodies.size(); j++)
+			{
+				if (Intersect(bodies[i].mBox, bodies[j].mBox))
+				{
+					pairs++;
+				}
+			}
+		}
+		return pairs;
+	}
+
+	size_t SortAndSweep(std::vector<const Body*>& sorted)
+	{
+		std::sort(sorted.begin(), sorted.end(),
+			[](const Body* a, const Body* b) {
+				return a->mBox.mMin.x < b->mBox.mMin.x;
+		});
+		size_t pairs = 0;
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			float max = sorted[i]->mBox.mMax.x;
+			for (size_t j = i + 1; j < sorted.size(); j++)
+			{
+				if (sorted[j]->mBox.mMin.x > max)
+				{
+					break;
+				}
+				else if (Intersect(sorted[i]->mBox, sorted[j]->mBox))
+				{
+					pairs++;
+				}
+			}
+		}
+		return pairs;
+	}
+
+	void RunBenchmark(size_t count, int frames)
+	{
+		std::vector<Body> bodies = MakeBodies(count);
+
+		// Each method starts from the same bodies
+		double pairwiseMs = -1.0;
+		size_t pairwisePairs = 0;
+		// Naive pairwise takes seconds per frame at larger counts,
+		// so only the last frame is tested (and timed) there
+		{
+			std::vector<Body> b = bodies;
+			int n = count > 10000 ? 1 : frames;
+			for (int f = 0; f < frames - n; f++)
+			{
+				MoveBodies(b);
+			}
+			auto start = Clock::now();
+			for (int f = 0; f < n; f++)
+			{
+				MoveBodies(b);
+				pairwisePairs = Pairwise(b);
+			}
+			pairwiseMs = ElapsedMs(start) / n;
+		}
+
+		double sortMs = 0.0;
+		size_t sortPairs = 0;
+		{
+			std::vector<Body> b = bodies;
+			std::vector<const Body*> sorted;
+			for (const Body& body : b)
+			{
+				sorted.emplace_back(&body);
+			}
+			auto start = Clock::now();
+			for (int f = 0; f < frames; f++)
+			{
+				MoveBodies(b);
+				sortPairs = SortAndSweep(sorted);
+			}
+			sortMs = ElapsedMs(start) / frames;
+		}
+
+		double treeMs = 0.0;
+		size_t treePairs = 0;
+		{
+			std::vector<Body> b = bodies;
+			AABBTree tree;
+			std::vector<int> proxies;
+			for (size_t i = 0; i < b.size(); i++)
+			{
+				proxies.emplace_back(tree.CreateProxy(b[i].mBox,
+					reinterpret_cast<void*>(i)));
+			}
+			auto start = Clock::now();
+			for (int f = 0; f < frames; f++)
+			{
+				MoveBodies(b);
+				treePairs = 0;
+				for (size_t i = 0; i < b.size(); i++)
+				{
+					tree.MoveProxy(proxies[i], b[i].mBox);
+				}
+				for (size_t i = 0; i < b.size(); i++)
+				{
+					int proxyA = proxies[i];
+					const AABB& boxA = b[i].mBox;
+					tree.Query(boxA, [&](int proxyB) {
+						if (proxyB > proxyA)
+						{
+							size_t j = reinterpret_cast<size_t>(tree.GetUserData(proxyB));
+							if (Intersect(boxA, b[j].mBox))
+							{
+								treePairs++;
+							}
+						}
+						return true;
+					});
+				}
+			}
+			treeMs = ElapsedMs(start) / frames;
+		}
+
+		double sapMs = 0.0;
+		double sapFirstMs = 0.0;
+		size_t sapPairs = 0;
+		{
+			std::vector<Body> b = bodies;
+			SweepAndPrune sap;
+			std::vector<int> proxies;
+			for (size_t i = 0; i < b.size(); i++)
+			{
+				proxies.emplace_back(sap.CreateProxy(b[i].mBox, nullptr));
+			}
+			// The first update sorts from scratch
+			auto first = Clock::now();
+			sap.Update();
+			sapFirstMs = ElapsedMs(first);
+			auto start = Clock::now();
+			for (int f = 0; f < frames; f++)
+			{
+				MoveBodies(b);
+				for (size_t i = 0; i < b.size(); i++)
+				{
+					sap.SetBox(proxies[i], b[i].mBox);
+				}
+				sap.Update();
+			}
+			sapMs = ElapsedMs(start) / frames;
+			sapPairs = sap.GetNumOverlaps();
+		}
+
+		double churnMs = 0.0;
+		size_t churnPairs = 0;
+		{
+			std::vector<Body> b = bodies;
+			SweepAndPrune sap;
+			std::vector<int> proxies;
+			for (size_t i = 0; i < b.size(); i++)
+			{
+				proxies.emplace_back(sap.CreateProxy(b[i].mBox, nullptr));
+			}
+			sap.Update();
+			// Respawned boxes come back where they were, so the
+			// pairs still match the other methods
+			size_t perFrame = Math::Max<size_t>(1, count / 100);
+			size_t next = 0;
+			auto start = Clock::now();
+			for (int f = 0; f < frames; f++)
+			{
+				MoveBodies(b);
+				for (size_t i = 0; i < perFrame; i++)
+				{
+					size_t index = next;
+					next = (next + 1) % count;
+					sap.DestroyProxy(proxies[index]);
+					proxies[index] = sap.CreateProxy(b[index].mBox, nullptr);
+				}
+				for (size_t i = 0; i < b.size(); i++)
+				{
+					sap.SetBox(proxies[i], b[i].mBox);
+				}
+				sap.Update();
+			}
+			churnMs = ElapsedMs(start) / frames;
+			churnPairs = sap.GetNumOverlaps();
+		}
+
+		printf("%7zu boxes | Pairwise %9.3f | SortAndSweep %8.3f | AABBTree %8.3f | "
+			"IncrementalSAP %8.3f (initial sort %8.3f) | Churn %8.3f | "
+			"pairs %zu %zu %zu %zu %zu\n",
+			count, pairwiseMs, sortMs, treeMs, sapMs, sapFirstMs, churnMs,
+			pairwisePairs, sortPairs, treePairs, sapPairs, churnPairs);
+	}
+
+	void RunSegmentBenchmark(size_t count, int casts)
+	{
+		std::vector<Body> bodies = MakeBodies(count);
+		std::vector<float> soa[6];
+		for (const Body& b : bodies)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				soa[i].emplace_back(b.mBox.mMin.GetAsFloatPtr()[i]);
+				soa[i + 3].emplace_back(b.mBox.mMax.GetAsFloatPtr()[i]);
+			}
+		}
+		AABBSoA boxes{ soa[0].data(), soa[1].data(), soa[2].data(),
+			soa[3].data(), soa[4].data(), soa[5].data(), count };
+
+		std::mt19937 rng(5678);
+		float worldSize = 100.0f * std::cbrt(static_cast<float>(count));
+		std::uniform_real_distribution<float> pos(-worldSize, worldSize);
+		std::vector<LineSegment> segments;
+		for (int i = 0; i < casts; i++)
+		{
+			segments.emplace_back(Vector3(pos(rng), pos(rng), pos(rng)),
+				Vector3(pos(rng), pos(rng), pos(rng)));
+		}
+
+		int scalarHits = 0;
+		auto start = Clock::now();
+		for (const LineSegment& l : segments)
+		{
+			float closestT = Math::Infinity;
+			float t;
+			Vector3 norm;
+			for (const Body& b : bodies)
+			{
+				if (Intersect(l, b.mBox, t, norm) && t < closestT)
+				{
+					closestT = t;
+				}
+			}
+			scalarHits += closestT <= 1.0f ? 1 : 0;
+		}
+		double scalarMs = ElapsedMs(start) / casts;
+
+		int batchHits = 0;
+		start = Clock::now();
+		for (const LineSegment& l : segments)
+		{
+			float t;
+			Vector3 norm;
+			size_t index;
+			batchHits += Intersect(l, boxes, 1.0f, t, norm, index) ? 1 : 0;
+		}
+		double batchMs = ElapsedMs(start) / casts;
+
+		printf("%7zu boxes | Scalar %8.4f | Batched %8.4f | hits %d %d\n",
+			count, scalarMs, batchMs, scalarHits, batchHits);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 20;
+	if (argc > 1)
+	{
+		frames = Math::Max(1, atoi(argv[1]));
+	}
+	printf("Average ms per frame over %d frames\n", frames);
+	const size_t counts[] = { 1000, 10000, 50000 };
+	for (size_t count : counts)
+	{
+		RunBenchmark(count, frames);
+	}
+	printf("Average ms per segment cast against every box\n");
+	for (size_t count : counts)
+	{
+		RunSegmentBenchmark(count, 100);
+	}
+	return 0;
+}
@@ -0,0 +1,137 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Compares updating components that were each allocated with new
+// (after the heap has been churned by other allocations, like a level
+// that's been running a while) with the same components in a Pool:
+//   Heap      - walk a vector of pointers, virtual Update on each
+//   Pool      - Pool::ForEach over the same type
+// Times are the average milliseconds per update of every component.
+
+#include "../Pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Roughly the shape of a MoveComponent
+	class Component
+	{
+	public:
+		virtual ~Component() { }
+		virtual void Update(float deltaTime) = 0;
+	};
+
+	class MoveComponent : public Component
+	{
+	public:
+		DECLARE_POOLED(MoveComponent)
+		void Update(float deltaTime) override
+		{
+			mAngle += mAngularSpeed * deltaTime;
+			mPos[0] += mForwardSpeed * deltaTime;
+			mPos[1] += mStrafeSpeed * deltaTime;
+		}
+		float mPos[3] = { 0.0f, 0.0f, 0.0f };
+		float mAngle = 0.0f;
+		float mAngularSpeed = 1.0f;
+		float mForwardSpeed = 2.0f;
+		float mStrafeSpeed = 0.5f;
+		void* mOwner = nullptr;
+	};
+
+	// The same component, but from the heap
+	class HeapMoveComponent : public Component
+	{
+	public:
+		void Update(float deltaTime) override
+		{
+			mAngle += mAngularSpeed * deltaTime;
+			mPos[0] += mForwardSpeed * deltaTime;
+			mPos[1] += mStrafeSpeed * deltaTime;
+		}
+		float mPos[3] = { 0.0f, 0.0f, 0.0f };
+		float mAngle = 0.0f;
+		float mAngularSpeed = 1.0f;
+		float mForwardSpeed = 2.0f;
+		float mStrafeSpeed = 0.5f;
+		void* mOwner = nullptr;
+	};
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	const int Frames = 200;
+}
+
+int main()
+{
+	std::mt19937 rng(1234);
+	printf("  Count |   Heap ms |   Pool ms\n");
+	for (int count : { 1000, 10000, 50000 })
+	{
+		// Interleave the components with other allocations of
+		// random sizes, then free those, so the heap is fragmented
+		std::vector<Component*> heap;
+		std::vector<MoveComponent*> pooled;
+		std::vector<char*> junk;
+		std::uniform_int_distribution<int> junkSize(16, 512);
+		for (int i = 0; i < count; i++)
+		{
+			heap.emplace_back(new HeapMoveComponent());
+			pooled.emplace_back(new MoveComponent());
+			for (int j = 0; j < 4; j++)
+			{
+				junk.emplace_back(new char[junkSize(rng)]);
+			}
+		}
+		for (char* c : junk)
+		{
+			delete[] c;
+		}
+		// Actors get spawned and destroyed in any order
+		std::shuffle(heap.begin(), heap.end(), rng);
+
+		Clock::time_point start = Clock::now();
+		for (int f = 0; f < Frames; f++)
+		{
+			for (Component* c : heap)
+			{
+				c->Update(0.016f);
+			}
+		}
+		double heapMs = ElapsedMs(start) / Frames;
+
+		start = Clock::now();
+		for (int f = 0; f < Frames; f++)
+		{
+			Pool<MoveComponent>::Get().ForEach([](MoveComponent* mc) {
+				mc->MoveComponent::Update(0.016f);
+			});
+		}
+		double poolMs = ElapsedMs(start) / Frames;
+		printf("%7d | %9.4f | %9.4f\n", count, heapMs, poolMs);
+
+		for (Component* c : heap)
+		{
+			delete c;
+		}
+		for (MoveComponent* mc : pooled)
+		{
+			delete mc;
+		}
+	}
+	return 0;
+}
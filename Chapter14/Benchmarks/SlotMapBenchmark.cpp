@@ -0,0 +1,193 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+//
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Spawn/destroy stress test of the registries an actor goes in,
+// modeled on spawning balls: each one is in the game's actor list,
+// the renderer's mesh list and its own actor's sorted components.
+//   Vector    - the old registries: std::find then erase (and a
+//               linear sorted insert for the components)
+//   SlotMap   - SlotMap with generational handles and swap-remove,
+//               sorting the components lazily before they update
+// Each frame destroys and respawns Churn random entries, then
+// iterates everything once. Times are the average ms per frame.
+
+#include "../SlotMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Object
+	{
+		int mUpdateOrder;
+		// Handles for the SlotMap version
+		SlotHandle mActorHandle;
+		SlotHandle mMeshHandle;
+	};
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	const int Frames = 100;
+	const int Churn = 1000;
+	const int ComponentsPerActor = 3;
+
+	// Something to do with each entry so iterating isn't optimized out
+	int sSum = 0;
+
+	double RunVector(int count, std::mt19937& rng)
+	{
+		std::vector<Object*> actors;
+		std::vector<Object*> meshes;
+		std::vector<std::vector<Object*>> components;
+		std::vector<Object*> live;
+		auto spawn = [&](Object* o) {
+			actors.emplace_back(o);
+			meshes.emplace_back(o);
+			std::vector<Object*> comps;
+			for (int c = 0; c < ComponentsPerActor; c++)
+			{
+				auto iter = comps.begin();
+				while (iter != comps.end() && (*iter)->mUpdateOrder <= o->mUpdateOrder)
+				{
+					++iter;
+				}
+				comps.insert(iter, o);
+			}
+			components.emplace_back(comps);
+			live.emplace_back(o);
+		};
+		std::vector<Object> storage(count);
+		for (int i = 0; i < count; i++)
+		{
+			storage[i].mUpdateOrder = i % 7;
+			spawn(&storage[i]);
+		}
+
+		Clock::time_point start = Clock::now();
+		for (int f = 0; f < Frames; f++)
+		{
+			for (int i = 0; i < Churn; i++)
+			{
+				size_t index = rng() % live.size();
+				Object* o = live[index];
+				live[index] = live.back();
+				live.pop_back();
+				auto iter = std::find(actors.begin(), actors.end(), o);
+				size_t actorIndex = iter - actors.begin();
+				std::iter_swap(iter, actors.end() - 1);
+				actors.pop_back();
+				std::iter_swap(components.begin() + actorIndex, components.end() - 1);
+				components.pop_back();
+				meshes.erase(std::find(meshes.begin(), meshes.end(), o));
+				spawn(o);
+			}
+			for (auto& comps : components)
+			{
+				for (Object* o : comps)
+				{
+					sSum += o->mUpdateOrder;
+				}
+			}
+			for (Object* o : meshes)
+			{
+				sSum += o->mUpdateOrder;
+			}
+		}
+		return ElapsedMs(start) / Frames;
+	}
+
+	double RunSlotMap(int count, std::mt19937& rng)
+	{
+		SlotMap<Object*> actors;
+		SlotMap<Object*> meshes;
+		struct Components
+		{
+			SlotMap<Object*> mMap;
+			std::vector<Object*> mSorted;
+			bool mDirty = false;
+		};
+		std::vector<Components> components(count);
+		std::vector<Object*> live;
+		std::vector<Object> storage(count);
+		auto spawn = [&](Object* o) {
+			o->mActorHandle = actors.Insert(o);
+			o->mMeshHandle = meshes.Insert(o);
+			Components& comps = components[o - storage.data()];
+			for (int c = 0; c < ComponentsPerActor; c++)
+			{
+				comps.mMap.Insert(o);
+			}
+			comps.mDirty = true;
+			live.emplace_back(o);
+		};
+		for (int i = 0; i < count; i++)
+		{
+			storage[i].mUpdateOrder = i % 7;
+			spawn(&storage[i]);
+		}
+
+		Clock::time_point start = Clock::now();
+		for (int f = 0; f < Frames; f++)
+		{
+			for (int i = 0; i < Churn; i++)
+			{
+				size_t index = rng() % live.size();
+				Object* o = live[index];
+				live[index] = live.back();
+				live.pop_back();
+				actors.Remove(o->mActorHandle);
+				meshes.Remove(o->mMeshHandle);
+				components[o - storage.data()].mMap.Clear();
+				spawn(o);
+			}
+			for (Object* a : actors)
+			{
+				Components& comps = components[a - storage.data()];
+				if (comps.mDirty)
+				{
+					comps.mSorted = comps.mMap.GetValues();
+					std::stable_sort(comps.mSorted.begin(), comps.mSorted.end(),
+						[](const Object* x, const Object* y) {
+						return x->mUpdateOrder < y->mUpdateOrder;
+					});
+					comps.mDirty = false;
+				}
+				for (Object* o : comps.mSorted)
+				{
+					sSum += o->mUpdateOrder;
+				}
+			}
+			for (Object* o : meshes)
+			{
+				sSum += o->mUpdateOrder;
+			}
+		}
+		return ElapsedMs(start) / Frames;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1234);
+	printf("  Count | Vector ms | SlotMap ms   (%d spawned/destroyed per frame)\n", Churn);
+	for (int count : { 2000, 10000, 50000 })
+	{
+		double vectorMs = RunVector(count, rng);
+		double slotMs = RunSlotMap(count, rng);
+		printf("%7d | %9.3f | %10.3f\n", count, vectorMs, slotMs);
+	}
+	return sSum == 42 ? 1 : 0;
+}
@@ -16,8 +16,11 @@ BoxComponent::BoxComponent(Actor* owner, int updateOrder)
 	:Component(owner, updateOrder)
 	,mObjectBox(Vector3::Zero, Vector3::Zero)
 	,mWorldBox(Vector3::Zero, Vector3::Zero)
+	,mTreeProxyID(-1)
 	,mShouldRotate(true)
 {
+	// Nothing to do per frame
+	mUpdateMode = ENoUpdate;
 	mOwner->GetGame()->GetPhysWorld()->AddBox(this);
 }
 
@@ -41,6 +44,9 @@ void BoxComponent::OnUpdateWorldTransform()
 	// Translate
 	mWorldBox.mMin += mOwner->GetPosition();
 	mWorldBox.mMax += mOwner->GetPosition();
+
+	// Let the physics world refit the tree
+	mOwner->GetGame()->GetPhysWorld()->UpdateBox(this);
 }
 
 void BoxComponent::LoadProperties(const rapidjson::Value& inObj)
@@ -52,6 +58,7 @@ void BoxComponent::LoadProperties(const rapidjson::Value& inObj)
 	JsonHelper::GetVector3(inObj, "worldMin", mWorldBox.mMin);
 	JsonHelper::GetVector3(inObj, "worldMax", mWorldBox.mMax);
 	JsonHelper::GetBool(inObj, "shouldRotate", mShouldRotate);
+	mOwner->GetGame()->GetPhysWorld()->UpdateBox(this);
 }
 
 void BoxComponent::SaveProperties(rapidjson::Document::AllocatorType & alloc, rapidjson::Value & inObj) const
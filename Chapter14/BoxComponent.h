@@ -14,6 +14,7 @@ class BoxComponent : public Component
 {
 public:
 	BoxComponent(class Actor* owner, int updateOrder = 100);
+	DECLARE_POOLED(BoxComponent)
 	~BoxComponent();
 
 	void OnUpdateWorldTransform() override;
@@ -27,8 +28,13 @@ public:
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
 	void SetShouldRotate(bool value) { mShouldRotate = value; }
+
+	// ID of this box in the PhysWorld's AABB tree
+	int GetTreeProxyID() const { return mTreeProxyID; }
+	void SetTreeProxyID(int id) { mTreeProxyID = id; }
 private:
 	AABB mObjectBox;
 	AABB mWorldBox;
+	int mTreeProxyID;
 	bool mShouldRotate;
 };
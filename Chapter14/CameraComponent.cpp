@@ -15,6 +15,9 @@
 CameraComponent::CameraComponent(Actor* owner, int updateOrder)
 	:Component(owner, updateOrder)
 {
+	// Follows wherever the owner ended up this step, and sets the
+	// view on the renderer and audio system (so not in parallel)
+	mUpdatePhase = EPhaseLate;
 }
 
 void CameraComponent::SetViewMatrix(const Matrix4& view)
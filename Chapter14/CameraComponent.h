@@ -14,6 +14,7 @@ class CameraComponent : public Component
 {
 public:
 	CameraComponent(class Actor* owner, int updateOrder = 200);
+	DECLARE_POOLED(CameraComponent)
 
 	TypeID GetType() const override { return TCameraComponent; }
 protected:
@@ -18,6 +18,16 @@
 #include <algorithm>
 #include <array>
 
+// Pick the widest SIMD the compiler is targeting
+// (the scalar code is used for anything else)
+#if defined(__AVX__)
+#define COLLISION_SIMD_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLLISION_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
 LineSegment::LineSegment(const Vector3& start, const Vector3& end)
 	:mStart(start)
 	,mEnd(end)
@@ -388,73 +398,296 @@ bool Intersect(const LineSegment& l, const Plane& p, float& outT)
 	}
 }
 
-bool TestSidePlane(float start, float end, float negd, const Vector3& norm,
-	std::vector<std::pair<float, Vector3>>& out)
+// Segment set up for slab tests against many boxes
+struct SlabSegment
 {
-	float denom = end - start;
-	if (Math::NearZero(denom))
+	SlabSegment(const LineSegment& l)
 	{
-		return false;
+		Vector3 dir = l.mEnd - l.mStart;
+		const float* start = l.mStart.GetAsFloatPtr();
+		const float* d = dir.GetAsFloatPtr();
+		mAllParallel = true;
+		for (int i = 0; i < 3; i++)
+		{
+			mStart[i] = start[i];
+			// Same threshold the plane tests have always used
+			mParallel[i] = Math::NearZero(d[i]);
+			mPositive[i] = d[i] > 0.0f;
+			mInvDir[i] = mParallel[i] ? 0.0f : 1.0f / d[i];
+			mAllParallel = mAllParallel && mParallel[i];
+		}
 	}
-	else
+
+	float mStart[3];
+	float mInvDir[3];
+	bool mParallel[3];
+	bool mPositive[3];
+	// Zero length segment, which can't cross any planes
+	bool mAllParallel;
+};
+
+// Slab test for one box. The segment enters the box at tEnter
+// and leaves at tExit. If it starts inside the box, the first
+// plane it crosses is the one it leaves through.
+// outAxis is the axis of the plane crossed, and outEntering
+// whether that was the entry.
+bool SlabTest(const SlabSegment& s, const float* bMin, const float* bMax,
+	float maxT, float& outT, int& outAxis, bool& outEntering)
+{
+	float tEnter = Math::NegInfinity;
+	float tExit = Math::Infinity;
+	int enterAxis = 0;
+	int exitAxis = 0;
+	for (int i = 0; i < 3; i++)
 	{
-		float numer = -start + negd;
-		float t = numer / denom;
-		// Test that t is within bounds
-		if (t >= 0.0f && t <= 1.0f)
+		if (s.mParallel[i])
 		{
-			out.emplace_back(t, norm);
-			return true;
+			// Parallel to these planes, so has to be between them
+			if (s.mStart[i] < bMin[i] || s.mStart[i] > bMax[i])
+			{
+				return false;
+			}
 		}
 		else
 		{
-			return false;
+			float tNear = ((s.mPositive[i] ? bMin[i] : bMax[i]) - s.mStart[i]) * s.mInvDir[i];
+			float tFar = ((s.mPositive[i] ? bMax[i] : bMin[i]) - s.mStart[i]) * s.mInvDir[i];
+			if (tNear > tEnter)
+			{
+				tEnter = tNear;
+				enterAxis = i;
+			}
+			if (tFar < tExit)
+			{
+				tExit = tFar;
+				exitAxis = i;
+			}
 		}
 	}
+
+	if (s.mAllParallel || tEnter > tExit)
+	{
+		return false;
+	}
+	outEntering = tEnter >= 0.0f;
+	outT = outEntering ? tEnter : tExit;
+	outAxis = outEntering ? enterAxis : exitAxis;
+	return outT >= 0.0f && outT <= maxT;
+}
+
+// Normal of the plane found by SlabTest
+Vector3 SlabNormal(const SlabSegment& s, int axis, bool entering)
+{
+	// Moving in +axis enters through the min plane (facing -axis)
+	// and leaves through the max plane (facing +axis)
+	bool facesPositive = s.mPositive[axis] != entering;
+	switch (axis)
+	{
+	case 0:
+		return facesPositive ? Vector3::UnitX : Vector3::NegUnitX;
+	case 1:
+		return facesPositive ? Vector3::UnitY : Vector3::NegUnitY;
+	default:
+		return facesPositive ? Vector3::UnitZ : Vector3::NegUnitZ;
+	}
 }
 
 bool Intersect(const LineSegment& l, const AABB& b, float& outT,
 	Vector3& outNorm)
 {
-	// Vector to save all possible t values, and normals for those sides
-	std::vector<std::pair<float, Vector3>> tValues;
-	// Test the x planes
-	TestSidePlane(l.mStart.x, l.mEnd.x, b.mMin.x, Vector3::NegUnitX,
-		tValues);
-	TestSidePlane(l.mStart.x, l.mEnd.x, b.mMax.x, Vector3::UnitX,
-		tValues);
-	// Test the y planes
-	TestSidePlane(l.mStart.y, l.mEnd.y, b.mMin.y, Vector3::NegUnitY,
-		tValues);
-	TestSidePlane(l.mStart.y, l.mEnd.y, b.mMax.y, Vector3::UnitY,
-		tValues);
-	// Test the z planes
-	TestSidePlane(l.mStart.z, l.mEnd.z, b.mMin.z, Vector3::NegUnitZ,
-		tValues);
-	TestSidePlane(l.mStart.z, l.mEnd.z, b.mMax.z, Vector3::UnitZ,
-		tValues);
-	
-	// Sort the t values in ascending order
-	std::sort(tValues.begin(), tValues.end(), [](
-		const std::pair<float, Vector3>& a,
-		const std::pair<float, Vector3>& b) {
-		return a.first < b.first;
-	});
-	// Test if the box contains any of these points of intersection
-	Vector3 point;
-	for (auto& t : tValues)
+	SlabSegment s(l);
+	int axis;
+	bool entering;
+	if (SlabTest(s, b.mMin.GetAsFloatPtr(), b.mMax.GetAsFloatPtr(), 1.0f,
+		outT, axis, entering))
 	{
-		point = l.PointOnSegment(t.first);
-		if (b.Contains(point))
+		outNorm = SlabNormal(s, axis, entering);
+		return true;
+	}
+	return false;
+}
+
+// Closest hit of the segment against boxes [start, end), without SIMD
+void SegmentBoxesScalar(const SlabSegment& s, const AABBSoA& boxes,
+	size_t start, size_t end, float& bestT, size_t& bestIndex)
+{
+	float bMin[3];
+	float bMax[3];
+	float t;
+	int axis;
+	bool entering;
+	for (size_t i = start; i < end; i++)
+	{
+		bMin[0] = boxes.mMinX[i];
+		bMin[1] = boxes.mMinY[i];
+		bMin[2] = boxes.mMinZ[i];
+		bMax[0] = boxes.mMaxX[i];
+		bMax[1] = boxes.mMaxY[i];
+		bMax[2] = boxes.mMaxZ[i];
+		if (SlabTest(s, bMin, bMax, bestT, t, axis, entering) && t < bestT)
 		{
-			outT = t.first;
-			outNorm = t.second;
-			return true;
+			bestT = t;
+			bestIndex = i;
+		}
+	}
+}
+
+#if defined(COLLISION_SIMD_AVX)
+// Eight boxes at a time. Every lane uses the same segment,
+// so which plane is near/far on each axis is the same for
+// all of them, and parallel axes are a single branch.
+size_t SegmentBoxesSIMD(const SlabSegment& s, const AABBSoA& boxes,
+	float& bestT, size_t& bestIndex)
+{
+	const float* mins[3] = { boxes.mMinX, boxes.mMinY, boxes.mMinZ };
+	const float* maxs[3] = { boxes.mMaxX, boxes.mMaxY, boxes.mMaxZ };
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 inf = _mm256_set1_ps(Math::Infinity);
+	const __m256 allOnes = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	alignas(32) float laneT[8];
+	size_t i = 0;
+	for (; i + 8 <= boxes.mCount; i += 8)
+	{
+		__m256 tEnter = _mm256_set1_ps(Math::NegInfinity);
+		__m256 tExit = inf;
+		__m256 valid = allOnes;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m256 bMin = _mm256_loadu_ps(mins[axis] + i);
+			__m256 bMax = _mm256_loadu_ps(maxs[axis] + i);
+			__m256 start = _mm256_set1_ps(s.mStart[axis]);
+			if (s.mParallel[axis])
+			{
+				valid = _mm256_and_ps(valid, _mm256_cmp_ps(bMin, start, _CMP_LE_OQ));
+				valid = _mm256_and_ps(valid, _mm256_cmp_ps(start, bMax, _CMP_LE_OQ));
+			}
+			else
+			{
+				__m256 inv = _mm256_set1_ps(s.mInvDir[axis]);
+				__m256 nearPlane = s.mPositive[axis] ? bMin : bMax;
+				__m256 farPlane = s.mPositive[axis] ? bMax : bMin;
+				tEnter = _mm256_max_ps(tEnter, _mm256_mul_ps(_mm256_sub_ps(nearPlane, start), inv));
+				tExit = _mm256_min_ps(tExit, _mm256_mul_ps(_mm256_sub_ps(farPlane, start), inv));
+			}
+		}
+		// Use the exit if the segment starts inside the box
+		__m256 entering = _mm256_cmp_ps(tEnter, zero, _CMP_GE_OQ);
+		__m256 t = _mm256_blendv_ps(tExit, tEnter, entering);
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(tEnter, tExit, _CMP_LE_OQ));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, _mm256_set1_ps(bestT), _CMP_LT_OQ));
+		int mask = _mm256_movemask_ps(valid);
+		if (mask != 0)
+		{
+			_mm256_store_ps(laneT, t);
+			for (int lane = 0; lane < 8; lane++)
+			{
+				if ((mask & (1 << lane)) && laneT[lane] < bestT)
+				{
+					bestT = laneT[lane];
+					bestIndex = i + lane;
+				}
+			}
 		}
 	}
+	return i;
+}
+#elif defined(COLLISION_SIMD_SSE)
+// Four boxes at a time (see the AVX version above)
+size_t SegmentBoxesSIMD(const SlabSegment& s, const AABBSoA& boxes,
+	float& bestT, size_t& bestIndex)
+{
+	const float* mins[3] = { boxes.mMinX, boxes.mMinY, boxes.mMinZ };
+	const float* maxs[3] = { boxes.mMaxX, boxes.mMaxY, boxes.mMaxZ };
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 inf = _mm_set1_ps(Math::Infinity);
+	const __m128 allOnes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	alignas(16) float laneT[4];
+	size_t i = 0;
+	for (; i + 4 <= boxes.mCount; i += 4)
+	{
+		__m128 tEnter = _mm_set1_ps(Math::NegInfinity);
+		__m128 tExit = inf;
+		__m128 valid = allOnes;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 bMin = _mm_loadu_ps(mins[axis] + i);
+			__m128 bMax = _mm_loadu_ps(maxs[axis] + i);
+			__m128 start = _mm_set1_ps(s.mStart[axis]);
+			if (s.mParallel[axis])
+			{
+				valid = _mm_and_ps(valid, _mm_cmple_ps(bMin, start));
+				valid = _mm_and_ps(valid, _mm_cmple_ps(start, bMax));
+			}
+			else
+			{
+				__m128 inv = _mm_set1_ps(s.mInvDir[axis]);
+				__m128 nearPlane = s.mPositive[axis] ? bMin : bMax;
+				__m128 farPlane = s.mPositive[axis] ? bMax : bMin;
+				tEnter = _mm_max_ps(tEnter, _mm_mul_ps(_mm_sub_ps(nearPlane, start), inv));
+				tExit = _mm_min_ps(tExit, _mm_mul_ps(_mm_sub_ps(farPlane, start), inv));
+			}
+		}
+		// Use the exit if the segment starts inside the box
+		// (SSE2 has no blend, so select with and/andnot)
+		__m128 entering = _mm_cmpge_ps(tEnter, zero);
+		__m128 t = _mm_or_ps(_mm_and_ps(entering, tEnter),
+			_mm_andnot_ps(entering, tExit));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(tEnter, tExit));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(t, zero));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(bestT)));
+		int mask = _mm_movemask_ps(valid);
+		if (mask != 0)
+		{
+			_mm_store_ps(laneT, t);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if ((mask & (1 << lane)) && laneT[lane] < bestT)
+				{
+					bestT = laneT[lane];
+					bestIndex = i + lane;
+				}
+			}
+		}
+	}
+	return i;
+}
+#endif
 
-	//None of the intersections are within bounds of box
-	return false;
+bool Intersect(const LineSegment& l, const AABBSoA& boxes, float maxT,
+	float& outT, Vector3& outNorm, size_t& outIndex)
+{
+	SlabSegment s(l);
+	if (s.mAllParallel)
+	{
+		return false;
+	}
+
+	// Lanes only accept t < bestT, so start just past maxT
+	// to still allow hits exactly at maxT
+	float bestT = std::nextafter(Math::Min(maxT, 1.0f), Math::Infinity);
+	size_t bestIndex = boxes.mCount;
+	size_t done = 0;
+#if defined(COLLISION_SIMD_AVX) || defined(COLLISION_SIMD_SSE)
+	done = SegmentBoxesSIMD(s, boxes, bestT, bestIndex);
+#endif
+	// Whatever didn't fill a whole SIMD register
+	SegmentBoxesScalar(s, boxes, done, boxes.mCount, bestT, bestIndex);
+
+	if (bestIndex == boxes.mCount)
+	{
+		return false;
+	}
+
+	// Redo the winning box to find which plane was hit
+	float bMin[3] = { boxes.mMinX[bestIndex], boxes.mMinY[bestIndex], boxes.mMinZ[bestIndex] };
+	float bMax[3] = { boxes.mMaxX[bestIndex], boxes.mMaxY[bestIndex], boxes.mMaxZ[bestIndex] };
+	int axis = 0;
+	bool entering = false;
+	SlabTest(s, bMin, bMax, Math::Infinity, outT, axis, entering);
+	outNorm = SlabNormal(s, axis, entering);
+	outIndex = bestIndex;
+	return true;
 }
 
 bool SweptSphere(const Sphere& P0, const Sphere& P1,
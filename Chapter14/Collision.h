@@ -60,6 +60,20 @@ struct AABB
 	Vector3 mMax;
 };
 
+// Boxes stored as separate arrays for each component
+// (structure of arrays), so several boxes can be loaded
+// into SIMD registers at once. Doesn't own the arrays.
+struct AABBSoA
+{
+	const float* mMinX;
+	const float* mMinY;
+	const float* mMinZ;
+	const float* mMaxX;
+	const float* mMaxY;
+	const float* mMaxZ;
+	size_t mCount;
+};
+
 struct OBB
 {
 	Vector3 mCenter;
@@ -95,6 +109,12 @@ bool Intersect(const LineSegment& l, const Sphere& s, float& outT);
 bool Intersect(const LineSegment& l, const Plane& p, float& outT);
 bool Intersect(const LineSegment& l, const AABB& b, float& outT,
 	Vector3& outNorm);
+// Batched version, which tests the segment against every box
+// (with SSE/AVX where available). Only hits with t <= maxT count.
+// Returns true if any box was hit, with outIndex set to the
+// closest box.
+bool Intersect(const LineSegment& l, const AABBSoA& boxes, float maxT,
+	float& outT, Vector3& outNorm, size_t& outIndex);
 
 bool SweptSphere(const Sphere& P0, const Sphere& P1,
 	const Sphere& Q0, const Sphere& Q1, float& t);
@@ -26,17 +26,29 @@ const char* Component::TypeNames[NUM_COMPONENT_TYPES] = {
 	"TargetComponent"
 };
 
+const char* Component::UpdatePhaseNames[NUM_UPDATE_PHASES] = {
+	"InputPhase",
+	"PrePhysicsPhase",
+	"PhysicsPhase",
+	"PostPhysicsPhase",
+	"AnimationPhase",
+	"LatePhase"
+};
+
 Component::Component(Actor* owner, int updateOrder)
 	:mOwner(owner)
 	,mUpdateOrder(updateOrder)
+	,mUpdateMode(EUpdateInPhase)
+	,mUpdatePhase(EPhasePrePhysics)
+	,mParallelSafe(false)
 {
 	// Add to actor's vector of components
-	mOwner->AddComponent(this);
+	mActorHandle = mOwner->AddComponent(this);
 }
 
 Component::~Component()
 {
-	mOwner->RemoveComponent(this);
+	mOwner->RemoveComponent(mActorHandle);
 }
 
 void Component::Update(float deltaTime)
@@ -8,6 +8,8 @@
 
 #pragma once
 #include "Math.h"
+#include "Pool.h"
+#include "SlotMap.h"
 #include <rapidjson/document.h>
 
 class Component
@@ -34,6 +36,34 @@ public:
 
 	static const char* TypeNames[NUM_COMPONENT_TYPES];
 
+	// Who calls Update on this component
+	enum UpdateMode
+	{
+		// Game, during the component's update phase
+		// (in update order within each actor)
+		EUpdateInPhase,
+		// Game, in one loop over every component of the type
+		EUpdateBatched,
+		// Nobody, since Update does nothing
+		ENoUpdate
+	};
+
+	// When in each simulation step the component updates.
+	// Game runs the phases in this order, each over every actor.
+	enum UpdatePhase
+	{
+		EPhaseInput,
+		EPhasePrePhysics,
+		EPhasePhysics,
+		EPhasePostPhysics,
+		EPhaseAnimation,
+		EPhaseLate,
+
+		NUM_UPDATE_PHASES
+	};
+
+	static const char* UpdatePhaseNames[NUM_UPDATE_PHASES];
+
 	// Constructor
 	// (the lower the update order, the earlier the component updates)
 	Component(class Actor* owner, int updateOrder = 100);
@@ -45,9 +75,14 @@ public:
 	virtual void ProcessInput(const uint8_t* keyState) {}
 	// Called when world transform changes
 	virtual void OnUpdateWorldTransform();
+	// Called when the (interpolated) render transform changes
+	virtual void OnUpdateRenderTransform() {}
 
 	class Actor* GetOwner() { return mOwner; }
 	int GetUpdateOrder() const { return mUpdateOrder; }
+	UpdateMode GetUpdateMode() const { return mUpdateMode; }
+	UpdatePhase GetUpdatePhase() const { return mUpdatePhase; }
+	bool IsParallelSafe() const { return mParallelSafe; }
 
 	virtual TypeID GetType() const = 0;
 
@@ -71,4 +106,12 @@ protected:
 	class Actor* mOwner;
 	// Update order of component
 	int mUpdateOrder;
+	// Entry in the owner's components
+	SlotHandle mActorHandle;
+	UpdateMode mUpdateMode;
+	UpdatePhase mUpdatePhase;
+	// True if Update only writes to this component and its owner, and
+	// only reads things nothing else writes during the phase. Then
+	// different actors' components can update on different threads.
+	bool mParallelSafe;
 };
@@ -13,6 +13,7 @@ class FollowActor : public Actor
 {
 public:
 	FollowActor(class Game* game);
+	DECLARE_POOLED(FollowActor)
 
 	void ActorInput(const uint8_t* keys) override;
 
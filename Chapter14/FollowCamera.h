@@ -13,6 +13,7 @@ class FollowCamera : public CameraComponent
 {
 public:
 	FollowCamera(class Actor* owner);
+	DECLARE_POOLED(FollowCamera)
 
 	void Update(float deltaTime) override;
 	
@@ -8,88 +8,261 @@
 
 #include "Font.h"
 #include "Texture.h"
+#include "SpriteBatch.h"
 #include <vector>
 #include "Game.h"
+#include "Renderer.h"
+#include "Profiler.h"
+
+namespace
+{
+	// Glyphs are small, so one page holds a lot of them
+	const int AtlasPageSize = 512;
+	// Empty pixels between glyphs, so filtering doesn't pull
+	// in their neighbors
+	const int GlyphPadding = 1;
+	// Opened on load, so a bad font file fails right away
+	const int DefaultPointSize = 30;
+
+	// Reads the character at index in UTF-8 text, and moves index past
+	// it. SDL_ttf glyphs are UCS-2, so anything bigger becomes '?'.
+	uint16_t NextChar(const std::string& text, size_t& index)
+	{
+		unsigned char lead = static_cast<unsigned char>(text[index++]);
+		uint32_t ch = lead;
+		int extra = 0;
+		if (lead >= 0xF0) { ch = lead & 0x07; extra = 3; }
+		else if (lead >= 0xE0) { ch = lead & 0x0F; extra = 2; }
+		else if (lead >= 0xC0) { ch = lead & 0x1F; extra = 1; }
+		for (int i = 0; i < extra && index < text.size(); i++)
+		{
+			ch = (ch << 6) | (static_cast<unsigned char>(text[index++]) & 0x3F);
+		}
+		return ch > 0xFFFF ? '?' : static_cast<uint16_t>(ch);
+	}
+}
+
+Text::Text()
+	:mColor(Color::White)
+	,mWidth(0.0f)
+	,mHeight(0.0f)
+{
+}
+
+void Text::Draw(SpriteBatch* batch, const Vector2& pos) const
+{
+	for (const GlyphQuad& quad : mGlyphs)
+	{
+		batch->Draw(quad.mPage, pos + quad.mCenter, quad.mSize,
+			quad.mUVMin, quad.mUVMax, mColor);
+	}
+}
+
+void Text::Clear()
+{
+	// (Keeps the capacity for the next layout)
+	mGlyphs.clear();
+	mWidth = 0.0f;
+	mHeight = 0.0f;
+}
 
 Font::Font(class Game* game)
-	:mGame(game)
+	:mShelfX(0)
+	,mShelfY(0)
+	,mShelfHeight(0)
+	,mUsedPixels(0)
+	,mGame(game)
 {
-	
+
 }
 
 Font::~Font()
 {
-	
+
 }
 
 bool Font::Load(const std::string& fileName)
 {
-	// We support these font sizes
-	std::vector<int> fontSizes = {
-		8, 9,
-		10, 11, 12, 14, 16, 18,
-		20, 22, 24, 26, 28,
-		30, 32, 34, 36, 38,
-		40, 42, 44, 46, 48,
-		52, 56,
-		60, 64, 68,
-		72
-	};
-	
-	for (auto& size : fontSizes)
-	{
-		TTF_Font* font = TTF_OpenFont(fileName.c_str(), size);
-		if (font == nullptr)
+	PROFILE_SCOPE_DETAIL("Font::Load", fileName.c_str());
+	// Other point sizes are opened the first time they're used
+	mFileName = fileName;
+	return GetFontData(DefaultPointSize) != nullptr;
+}
+
+void Font::Unload()
+{
+	for (auto& font : mFontData)
+	{
+		if (font.second)
 		{
-			SDL_Log("Failed to load font %s in size %d", fileName.c_str(), size);
-			return false;
+			TTF_CloseFont(font.second);
 		}
-		mFontData.emplace(size, font);
 	}
-	return true;
+	mFontData.clear();
+	for (auto page : mPages)
+	{
+		page->Unload();
+		delete page;
+	}
+	mPages.clear();
+	mGlyphs.clear();
+	mShelfX = 0;
+	mShelfY = 0;
+	mShelfHeight = 0;
+	mUsedPixels = 0;
 }
 
-void Font::Unload()
+void Font::LayoutText(Text& outText, const std::string& textKey,
+					  const Vector3& color /*= Color::White*/,
+					  int pointSize /*= 30*/)
 {
-	for (auto& font : mFontData)
+	outText.Clear();
+	outText.mColor = color;
+
+	TTF_Font* font = GetFontData(pointSize);
+	if (font == nullptr)
+	{
+		return;
+	}
+	const std::string& actualText = mGame->GetText(textKey);
+
+	// Place each glyph relative to the top left, on the baseline
+	int ascent = TTF_FontAscent(font);
+	int penX = 0;
+	size_t index = 0;
+	while (index < actualText.size())
+	{
+		uint16_t ch = NextChar(actualText, index);
+		const Glyph* glyph = GetGlyph(font, pointSize, ch);
+		if (glyph->mPage)
+		{
+			Text::GlyphQuad quad;
+			quad.mPage = glyph->mPage;
+			quad.mSize = Vector2(static_cast<float>(glyph->mWidth),
+				static_cast<float>(glyph->mHeight));
+			quad.mCenter = Vector2(penX + glyph->mMinX + quad.mSize.x * 0.5f,
+				ascent - glyph->mMaxY + quad.mSize.y * 0.5f);
+			float pageSize = static_cast<float>(AtlasPageSize);
+			quad.mUVMin = Vector2(glyph->mX / pageSize, glyph->mY / pageSize);
+			quad.mUVMax = Vector2((glyph->mX + glyph->mWidth) / pageSize,
+				(glyph->mY + glyph->mHeight) / pageSize);
+			outText.mGlyphs.emplace_back(quad);
+		}
+		penX += glyph->mAdvance;
+	}
+	outText.mWidth = static_cast<float>(penX);
+	outText.mHeight = static_cast<float>(TTF_FontHeight(font));
+
+	// Now that the size is known, make it relative to the center
+	// (with +y up, like the rest of the UI)
+	for (Text::GlyphQuad& quad : outText.mGlyphs)
+	{
+		quad.mCenter.x -= outText.mWidth * 0.5f;
+		quad.mCenter.y = outText.mHeight * 0.5f - quad.mCenter.y;
+	}
+}
+
+float Font::GetAtlasOccupancy() const
+{
+	if (mPages.empty())
 	{
-		TTF_CloseFont(font.second);
+		return 0.0f;
 	}
+	float pagePixels = static_cast<float>(AtlasPageSize * AtlasPageSize);
+	return mUsedPixels / (pagePixels * mPages.size());
 }
 
-Texture* Font::RenderText(const std::string& textKey,
-						  const Vector3& color /*= Color::White*/,
-						  int pointSize /*= 24*/)
+TTF_Font* Font::GetFontData(int pointSize)
 {
-	Texture* texture = nullptr;
-	
-	// Convert to SDL_Color
-	SDL_Color sdlColor;
-	sdlColor.r = static_cast<Uint8>(color.x * 255);
-	sdlColor.g = static_cast<Uint8>(color.y * 255);
-	sdlColor.b = static_cast<Uint8>(color.z * 255);
-	sdlColor.a = 255;
-	
-	// Find the font data for this point size
 	auto iter = mFontData.find(pointSize);
 	if (iter != mFontData.end())
 	{
-		TTF_Font* font = iter->second;
-		const std::string& actualText = mGame->GetText(textKey);
-		// Draw this to a surface (blended for alpha)
-		SDL_Surface* surf = TTF_RenderUTF8_Blended(font, actualText.c_str(), sdlColor);
+		return iter->second;
+	}
+
+	PROFILE_SCOPE_DETAIL("Font::OpenSize", mFileName.c_str());
+	TTF_Font* font = TTF_OpenFont(mFileName.c_str(), pointSize);
+	if (font == nullptr)
+	{
+		SDL_Log("Failed to load font %s in size %d", mFileName.c_str(), pointSize);
+	}
+	// Remember failures too, so they're only reported once
+	mFontData.emplace(pointSize, font);
+	return font;
+}
+
+const Font::Glyph* Font::GetGlyph(TTF_Font* font, int pointSize, uint16_t ch)
+{
+	uint32_t key = static_cast<uint32_t>(pointSize) << 16 | ch;
+	auto iter = mGlyphs.find(key);
+	if (iter != mGlyphs.end())
+	{
+		return &iter->second;
+	}
+
+	Glyph glyph{ nullptr, 0, 0, 0, 0, 0, 0, 0 };
+	int maxX = 0;
+	int minY = 0;
+	if (TTF_GlyphMetrics(font, ch, &glyph.mMinX, &maxX, &minY,
+		&glyph.mMaxY, &glyph.mAdvance) == 0 &&
+		!mGame->GetRenderer()->IsHeadless())
+	{
+		// Drawn in white, since the text color is applied when drawing
+		SDL_Color white = { 255, 255, 255, 255 };
+		SDL_Surface* surf = TTF_RenderGlyph_Blended(font, ch, white);
 		if (surf != nullptr)
 		{
-			// Convert from surface to texture
-			texture = new Texture();
-			texture->CreateFromSurface(surf);
+			if (surf->w > 0 && surf->h > 0)
+			{
+				AddToAtlas(surf, glyph);
+			}
 			SDL_FreeSurface(surf);
 		}
 	}
-	else
+	return &mGlyphs.emplace(key, glyph).first->second;
+}
+
+bool Font::AddToAtlas(SDL_Surface* surface, Glyph& glyph)
+{
+	int width = surface->w + GlyphPadding;
+	int height = surface->h + GlyphPadding;
+	if (width > AtlasPageSize || height > AtlasPageSize)
 	{
-		SDL_Log("Point size %d is unsupported", pointSize);
+		SDL_Log("Glyph is too big for the font atlas (%dx%d)", surface->w, surface->h);
+		return false;
 	}
-	
-	return texture;
+
+	// Shelf packing: left to right along a shelf, then a new shelf
+	// below it, then a new page
+	if (mShelfX + width > AtlasPageSize)
+	{
+		mShelfX = 0;
+		mShelfY += mShelfHeight;
+		mShelfHeight = 0;
+	}
+	if (mPages.empty() || mShelfY + height > AtlasPageSize)
+	{
+		PROFILE_SCOPE("Font::AddAtlasPage");
+		Texture* page = new Texture();
+		page->CreateDynamic(AtlasPageSize, AtlasPageSize);
+		mPages.emplace_back(page);
+		mShelfX = 0;
+		mShelfY = 0;
+		mShelfHeight = 0;
+	}
+
+	glyph.mPage = mPages.back();
+	glyph.mX = mShelfX;
+	glyph.mY = mShelfY;
+	glyph.mWidth = surface->w;
+	glyph.mHeight = surface->h;
+	glyph.mPage->UpdateFromSurface(glyph.mX, glyph.mY, surface);
+
+	mShelfX += width;
+	if (height > mShelfHeight)
+	{
+		mShelfHeight = height;
+	}
+	mUsedPixels += surface->w * surface->h;
+	return true;
 }
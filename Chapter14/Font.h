@@ -7,27 +7,97 @@
 // ----------------------------------------------------------------
 
 #pragma once
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <SDL/SDL_ttf.h>
 #include "Math.h"
 
+// A string laid out by Font::LayoutText, as quads of glyphs in the
+// font's atlas. Laying it out again reuses the same memory, so
+// changing the text doesn't create any textures.
+class Text
+{
+public:
+	Text();
+
+	// Adds the glyph quads to the batch, centered on pos
+	void Draw(class SpriteBatch* batch, const Vector2& pos) const;
+	void Clear();
+	bool IsEmpty() const { return mGlyphs.empty(); }
+
+	float GetWidth() const { return mWidth; }
+	float GetHeight() const { return mHeight; }
+private:
+	friend class Font;
+	struct GlyphQuad
+	{
+		class Texture* mPage;
+		// Relative to the center of the text
+		Vector2 mCenter;
+		Vector2 mSize;
+		Vector2 mUVMin;
+		Vector2 mUVMax;
+	};
+	std::vector<GlyphQuad> mGlyphs;
+	Vector3 mColor;
+	float mWidth;
+	float mHeight;
+};
+
 class Font
 {
 public:
 	Font(class Game* game);
 	~Font();
-	
+
 	// Load/unload from a file
 	bool Load(const std::string& fileName);
 	void Unload();
-	
-	// Given string and this font, draw to a texture
-	class Texture* RenderText(const std::string& textKey,
-							  const Vector3& color = Color::White,
-							  int pointSize = 30);
+
+	// Given string and this font, lay it out into outText (each glyph
+	// is drawn into the atlas the first time it's used)
+	void LayoutText(Text& outText, const std::string& textKey,
+					const Vector3& color = Color::White,
+					int pointSize = 30);
+
+	// Atlas use
+	int GetNumGlyphs() const { return static_cast<int>(mGlyphs.size()); }
+	int GetNumAtlasPages() const { return static_cast<int>(mPages.size()); }
+	// Fraction of the atlas pages covered by glyphs
+	float GetAtlasOccupancy() const;
 private:
-	// Map of point sizes to font data
+	struct Glyph
+	{
+		// Null if the glyph has nothing to draw (like a space)
+		class Texture* mPage;
+		int mX;
+		int mY;
+		int mWidth;
+		int mHeight;
+		// From TTF_GlyphMetrics
+		int mMinX;
+		int mMaxY;
+		int mAdvance;
+	};
+	// Opens the point size the first time it's asked for
+	TTF_Font* GetFontData(int pointSize);
+	const Glyph* GetGlyph(TTF_Font* font, int pointSize, uint16_t ch);
+	// Finds room for the surface in the atlas and copies it there
+	bool AddToAtlas(struct SDL_Surface* surface, Glyph& glyph);
+
+	std::string mFileName;
+	// Map of point sizes to font data (null if it failed to open)
 	std::unordered_map<int, TTF_Font*> mFontData;
+	// Map of (point size << 16 | character) to glyph
+	std::unordered_map<uint32_t, Glyph> mGlyphs;
+	std::vector<class Texture*> mPages;
+	// Where the next glyph goes on the last page
+	int mShelfX;
+	int mShelfY;
+	int mShelfHeight;
+	// Pixels covered by glyphs, over all the pages
+	int mUsedPixels;
 	class Game* mGame;
 };
@@ -0,0 +1,117 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "FrameScheduler.h"
+#include <SDL/SDL_timer.h>
+#include <algorithm>
+
+namespace
+{
+	// Frames kept for the stats
+	const size_t StatsFrames = 240;
+	// Longest frame the simulation catches up on
+	const float MaxFrameTime = 0.05f;
+	// SDL_Delay can oversleep by about a millisecond, so stop
+	// sleeping this far from the target and spin the rest
+	const float SpinTime = 0.002f;
+}
+
+FrameScheduler::FrameScheduler()
+	:mNextFrameTime(0)
+	,mStatsDirty(true)
+	,mFrequency(SDL_GetPerformanceFrequency())
+	,mLastFrame(SDL_GetPerformanceCounter())
+	,mTargetFPS(60.0f)
+	,mFixedStep(1.0f / 60.0f)
+	,mAccumulator(0.0f)
+{
+	mFrameTimes.reserve(StatsFrames);
+}
+
+float FrameScheduler::BeginFrame()
+{
+	if (mTargetFPS > 0.0f)
+	{
+		Uint64 frameCounts = static_cast<Uint64>(mFrequency / mTargetFPS);
+		WaitUntil(mLastFrame + frameCounts);
+	}
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	float frameTime = ToSeconds(now - mLastFrame);
+	mLastFrame = now;
+
+	// Record it for the stats
+	if (mFrameTimes.size() < StatsFrames)
+	{
+		mFrameTimes.emplace_back(frameTime);
+	}
+	else
+	{
+		mFrameTimes[mNextFrameTime] = frameTime;
+	}
+	mNextFrameTime = (mNextFrameTime + 1) % StatsFrames;
+	mStatsDirty = true;
+
+	float deltaTime = std::min(frameTime, MaxFrameTime);
+	mAccumulator += deltaTime;
+	return deltaTime;
+}
+
+bool FrameScheduler::StepSimulation()
+{
+	if (mAccumulator >= mFixedStep)
+	{
+		mAccumulator -= mFixedStep;
+		return true;
+	}
+	return false;
+}
+
+const FrameStats& FrameScheduler::GetStats()
+{
+	if (mStatsDirty && !mFrameTimes.empty())
+	{
+		std::vector<float> sorted(mFrameTimes);
+		std::sort(sorted.begin(), sorted.end());
+		float total = 0.0f;
+		for (float t : sorted)
+		{
+			total += t;
+		}
+		float average = total / sorted.size();
+		mStats.mAverage = average * 1000.0f;
+		mStats.mMin = sorted.front() * 1000.0f;
+		mStats.mMax = sorted.back() * 1000.0f;
+		mStats.mP99 = sorted[(sorted.size() - 1) * 99 / 100] * 1000.0f;
+		mStats.mFPS = average > 0.0f ? 1.0f / average : 0.0f;
+		mStatsDirty = false;
+	}
+	return mStats;
+}
+
+void FrameScheduler::WaitUntil(Uint64 target)
+{
+	Uint64 spinCounts = static_cast<Uint64>(mFrequency * SpinTime);
+	Uint64 now = SDL_GetPerformanceCounter();
+	// Sleep in whole milliseconds while there's plenty of time left
+	while (now + spinCounts < target)
+	{
+		Uint32 ms = static_cast<Uint32>((target - now - spinCounts) * 1000 / mFrequency);
+		if (ms == 0)
+		{
+			break;
+		}
+		SDL_Delay(ms);
+		now = SDL_GetPerformanceCounter();
+	}
+	// Then spin for the last bit
+	while (now < target)
+	{
+		now = SDL_GetPerformanceCounter();
+	}
+}
@@ -0,0 +1,71 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <SDL/SDL_stdinc.h>
+#include <vector>
+
+// Frame times (in milliseconds) over the last few seconds
+struct FrameStats
+{
+	float mAverage = 0.0f;
+	float mMin = 0.0f;
+	float mMax = 0.0f;
+	// 99th percentile, to show hitches the average hides
+	float mP99 = 0.0f;
+	float mFPS = 0.0f;
+};
+
+// Paces frames to a target rate with the high resolution timer, and
+// hands out fixed simulation steps from an accumulator
+class FrameScheduler
+{
+public:
+	FrameScheduler();
+
+	// Waits until it's time for the next frame and returns the
+	// seconds since the last one (clamped, so a long hitch doesn't
+	// make the simulation spiral). Adds that time to the accumulator.
+	float BeginFrame();
+
+	// Returns true (and uses up one fixed step) while the simulation
+	// is behind real time. Call in a loop after BeginFrame.
+	bool StepSimulation();
+	// How far between the last two steps rendering is, in [0, 1)
+	float GetAlpha() const { return mAccumulator / mFixedStep; }
+	// Drops leftover time, e.g. while the simulation is paused
+	void ResetAccumulator() { mAccumulator = 0.0f; }
+
+	// Frames per second to wait for (0 is uncapped)
+	void SetTargetFPS(float fps) { mTargetFPS = fps; }
+	float GetTargetFPS() const { return mTargetFPS; }
+	// Simulation step in seconds
+	void SetFixedStep(float step) { mFixedStep = step; }
+	float GetFixedStep() const { return mFixedStep; }
+
+	const FrameStats& GetStats();
+private:
+	// Sleeps for most of the time left, then spins for the rest
+	void WaitUntil(Uint64 target);
+	float ToSeconds(Uint64 counts) const
+	{
+		return static_cast<float>(static_cast<double>(counts) / mFrequency);
+	}
+
+	// Recent frame times in seconds (ring buffer)
+	std::vector<float> mFrameTimes;
+	size_t mNextFrameTime;
+	FrameStats mStats;
+	bool mStatsDirty;
+
+	Uint64 mFrequency;
+	Uint64 mLastFrame;
+	float mTargetFPS;
+	float mFixedStep;
+	float mAccumulator;
+};
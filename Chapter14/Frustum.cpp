@@ -0,0 +1,114 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Frustum.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+Frustum::Frustum(const Matrix4& viewProj)
+{
+	// Points are row vectors (v * M), so clip space x/y/z/w
+	// are dot products with the columns of the matrix.
+	// Inside means -w <= x <= w, -w <= y <= w, and 0 <= z <= w
+	// (CreatePerspectiveFOV maps depth to [0, 1])
+	float col[4][4];
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			col[c][r] = viewProj.mat[r][c];
+		}
+	}
+
+	float planes[6][4];
+	for (int i = 0; i < 4; i++)
+	{
+		// Left and right
+		planes[0][i] = col[3][i] + col[0][i];
+		planes[1][i] = col[3][i] - col[0][i];
+		// Bottom and top
+		planes[2][i] = col[3][i] + col[1][i];
+		planes[3][i] = col[3][i] - col[1][i];
+		// Near and far
+		planes[4][i] = col[2][i];
+		planes[5][i] = col[3][i] - col[2][i];
+	}
+
+	// Normalize so distances to the planes are in world units
+	for (int p = 0; p < 6; p++)
+	{
+		Vector3 normal(planes[p][0], planes[p][1], planes[p][2]);
+		float invLength = 1.0f / normal.Length();
+		mNormalX[p] = planes[p][0] * invLength;
+		mNormalY[p] = planes[p][1] * invLength;
+		mNormalZ[p] = planes[p][2] * invLength;
+		mD[p] = planes[p][3] * invLength;
+	}
+}
+
+bool Frustum::ContainsSphere(const Vector3& center, float radius) const
+{
+	for (int p = 0; p < 6; p++)
+	{
+		float dist = mNormalX[p] * center.x + mNormalY[p] * center.y +
+			mNormalZ[p] * center.z + mD[p];
+		// Entirely behind this plane
+		if (dist < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t Frustum::CullSpheres(const float* centerX, const float* centerY,
+	const float* centerZ, const float* radius, size_t count,
+	uint8_t* outVisible) const
+{
+	size_t numVisible = 0;
+	size_t i = 0;
+#ifdef FRUSTUM_SIMD_SSE
+	// Four spheres against one plane at a time
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+		// Bits are set for spheres that are outside any plane
+		int outside = 0;
+		for (int p = 0; p < 6; p++)
+		{
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mNormalX[p])),
+					_mm_mul_ps(y, _mm_set1_ps(mNormalY[p]))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(mNormalZ[p])),
+					_mm_set1_ps(mD[p])));
+			outside |= _mm_movemask_ps(_mm_cmplt_ps(dist, negRadius));
+		}
+		for (int lane = 0; lane < 4; lane++)
+		{
+			uint8_t visible = (outside & (1 << lane)) ? 0 : 1;
+			outVisible[i + lane] = visible;
+			numVisible += visible;
+		}
+	}
+#endif
+	// Anything left over (or everything, without SSE)
+	for (; i < count; i++)
+	{
+		bool visible = ContainsSphere(Vector3(centerX[i], centerY[i], centerZ[i]),
+			radius[i]);
+		outVisible[i] = visible ? 1 : 0;
+		numVisible += visible ? 1 : 0;
+	}
+	return numVisible;
+}
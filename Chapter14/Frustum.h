@@ -0,0 +1,40 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "Math.h"
+
+// The six planes of a view frustum, used to cull objects
+// that are off screen before drawing them
+class Frustum
+{
+public:
+	// Extract the planes from a view-projection matrix
+	Frustum(const Matrix4& viewProj);
+
+	// Bounding spheres stored as separate arrays for each component
+	// (structure of arrays), so four can be tested at once with SSE.
+	// Sets outVisible[i] to 1 if sphere i is at least partly inside
+	// the frustum, and 0 if it's entirely outside.
+	// Returns the number of visible spheres.
+	size_t CullSpheres(const float* centerX, const float* centerY,
+		const float* centerZ, const float* radius, size_t count,
+		uint8_t* outVisible) const;
+
+	// Test a single sphere
+	bool ContainsSphere(const Vector3& center, float radius) const;
+private:
+	// Plane i is mNormalX[i] * x + mNormalY[i] * y + mNormalZ[i] * z + mD[i],
+	// with normals facing into the frustum
+	float mNormalX[6];
+	float mNormalY[6];
+	float mNormalZ[6];
+	float mD[6];
+};
@@ -12,6 +12,8 @@
 
 GBuffer::GBuffer()
 	:mBufferID(0)
+	,mDepthBuffer(0)
+	,mCompact(true)
 {
 	
 }
@@ -21,36 +23,50 @@ GBuffer::~GBuffer()
 	
 }
 
-bool GBuffer::Create(int width, int height)
+bool GBuffer::Create(int width, int height, bool compact)
 {
+	mCompact = compact;
 	// Create the framebuffer object
 	glGenFramebuffers(1, &mBufferID);
 	glBindFramebuffer(GL_FRAMEBUFFER, mBufferID);
 	
-	// Add a depth buffer to this target
-	GLuint depthBuffer;
-	glGenRenderbuffers(1, &depthBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
-						  width, height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-							  GL_RENDERBUFFER, depthBuffer);
-	
 	// Create textures for each output in the G-buffer
+	// (12 bytes a pixel for each, or 4 in the compact layout)
+	const GLenum fullFormats[NUM_GBUFFER_TEXTURES] = {
+		GL_RGB32F, GL_RGB32F, GL_RGB32F
+	};
+	const GLenum compactFormats[NUM_GBUFFER_TEXTURES] = {
+		GL_RGBA8, GL_RG16F, GL_DEPTH_COMPONENT24
+	};
+	int numColors = mCompact ? 2 : NUM_GBUFFER_TEXTURES;
 	for (int i = 0; i < NUM_GBUFFER_TEXTURES; i++)
 	{
 		Texture* tex = new Texture();
-		// We want three 32-bit float components for each texture
-		tex->CreateForRendering(width, height, GL_RGB32F);
+		tex->CreateForRendering(width, height,
+			mCompact ? compactFormats[i] : fullFormats[i]);
 		mTextures.emplace_back(tex);
-		// Attach this texture to a color output
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+		// Attach this texture to a color output (or as the depth
+		// buffer, for the compact world position)
+		GLenum attachment = i < numColors ? GL_COLOR_ATTACHMENT0 + i :
+			GL_DEPTH_ATTACHMENT;
+		glFramebufferTexture(GL_FRAMEBUFFER, attachment,
 							 tex->GetTextureID(), 0);
 	}
+
+	if (!mCompact)
+	{
+		// Add a depth buffer to this target
+		glGenRenderbuffers(1, &mDepthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT,
+							  width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+								  GL_RENDERBUFFER, mDepthBuffer);
+	}
 	
 	// Create a vector of the color attachments
 	std::vector<GLenum> attachments;
-	for (int i = 0; i < NUM_GBUFFER_TEXTURES; i++)
+	for (int i = 0; i < numColors; i++)
 	{
 		attachments.emplace_back(GL_COLOR_ATTACHMENT0 + i);
 	}
@@ -72,11 +88,15 @@ bool GBuffer::Create(int width, int height)
 void GBuffer::Destroy()
 {
 	glDeleteFramebuffers(1, &mBufferID);
+	glDeleteRenderbuffers(1, &mDepthBuffer);
+	mBufferID = 0;
+	mDepthBuffer = 0;
 	for (Texture* t : mTextures)
 	{
 		t->Unload();
 		delete t;
 	}
+	mTextures.clear();
 }
 
 Texture* GBuffer::GetTexture(Type type)
@@ -17,6 +17,7 @@ public:
 	{
 		EDiffuse = 0,
 		ENormal,
+		// The depth buffer, in the compact layout
 		EWorldPos,
 		NUM_GBUFFER_TEXTURES
 	};
@@ -24,9 +25,12 @@ public:
 	GBuffer();
 	~GBuffer();
 
-	// Create/destroy the G-buffer
-	bool Create(int width, int height);
+	// Create/destroy the G-buffer. The compact layout is RGBA8
+	// diffuse, octahedral normals in RG16F, and world positions
+	// rebuilt from the depth buffer. Otherwise all three are RGB32F.
+	bool Create(int width, int height, bool compact = true);
 	void Destroy();
+	bool IsCompact() const { return mCompact; }
 	
 	// Get the texture for a specific type of data
 	class Texture* GetTexture(Type type);
@@ -39,4 +43,7 @@ private:
 	std::vector<class Texture*> mTextures;
 	// Frame buffer object ID
 	unsigned int mBufferID;
+	// Depth renderbuffer (for the full layout)
+	unsigned int mDepthBuffer;
+	bool mCompact;
 };
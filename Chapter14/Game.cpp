@@ -15,6 +15,7 @@
 #include "UIScreen.h"
 #include "HUD.h"
 #include "MeshComponent.h"
+#include "MoveComponent.h"
 #include "FollowActor.h"
 #include "PlaneActor.h"
 #include "TargetActor.h"
@@ -28,28 +29,75 @@
 #include "Animation.h"
 #include "PointLightComponent.h"
 #include "LevelLoader.h"
+#include "JobSystem.h"
+#include "AssetLoader.h"
+#include "SkeletalMeshComponent.h"
+#include "Frustum.h"
+#include "PoseCache.h"
+#include "FrameScheduler.h"
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/prettywriter.h>
+#include <cstdio>
+#include "Profiler.h"
+
+namespace
+{
+	// Blends two view matrices through the camera's position and
+	// axes, rebuilding with CreateLookAt so it stays orthonormal
+	Matrix4 BlendView(const Matrix4& from, const Matrix4& to, float alpha)
+	{
+		Matrix4 camFrom = from;
+		camFrom.InvertAffine();
+		Matrix4 camTo = to;
+		camTo.InvertAffine();
+		Vector3 eye = Vector3::Lerp(camFrom.GetTranslation(), camTo.GetTranslation(), alpha);
+		Vector3 forward = Vector3::Lerp(camFrom.GetZAxis(), camTo.GetZAxis(), alpha);
+		Vector3 up = Vector3::Lerp(camFrom.GetYAxis(), camTo.GetYAxis(), alpha);
+		return Matrix4::CreateLookAt(eye, eye + forward, up);
+	}
+}
 
 Game::Game()
 :mRenderer(nullptr)
 ,mAudioSystem(nullptr)
 ,mPhysWorld(nullptr)
+,mJobSystem(nullptr)
+,mAssetLoader(nullptr)
+,mPoseCache(nullptr)
+,mFrameScheduler(nullptr)
 ,mGameState(EGameplay)
 ,mUpdatingActors(false)
+,mPhasesDirty(true)
+,mHeadless(false)
+,mLevelFile("Assets/Level3.gplevel")
 {
-	
+	for (auto& ticks : mPhaseTicks)
+	{
+		ticks = 0;
+	}
 }
 
-bool Game::Initialize()
+bool Game::Initialize(bool headless)
 {
-	if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_AUDIO) != 0)
+	mHeadless = headless;
+	// Headless runs only need the timer
+	Uint32 sdlFlags = mHeadless ? SDL_INIT_TIMER : SDL_INIT_VIDEO | SDL_INIT_AUDIO;
+	if (SDL_Init(sdlFlags) != 0)
 	{
 		SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
 		return false;
 	}
 
+	// Start the asset loading threads (the renderer loads through them)
+	mAssetLoader = new AssetLoader();
+
 	// Create the renderer
 	mRenderer = new Renderer(this);
-	if (!mRenderer->Initialize(1024.0f, 768.0f))
+	if (mHeadless)
+	{
+		mRenderer->InitializeHeadless(1024.0f, 768.0f);
+	}
+	else if (!mRenderer->Initialize(1024.0f, 768.0f))
 	{
 		SDL_Log("Failed to initialize renderer");
 		delete mRenderer;
@@ -57,9 +105,10 @@ bool Game::Initialize()
 		return false;
 	}
 
-	// Create the audio system
+	// Create the audio system (left uninitialized if headless,
+	// so it plays nothing)
 	mAudioSystem = new AudioSystem(this);
-	if (!mAudioSystem->Initialize())
+	if (!mHeadless && !mAudioSystem->Initialize())
 	{
 		SDL_Log("Failed to initialize audio system");
 		mAudioSystem->Shutdown();
@@ -70,6 +119,10 @@ bool Game::Initialize()
 
 	// Create the physics world
 	mPhysWorld = new PhysWorld(this);
+
+	// Start the worker threads
+	mJobSystem = new JobSystem();
+	mPoseCache = new PoseCache();
 	
 	// Initialize SDL_ttf
 	if (TTF_Init() != 0)
@@ -80,7 +133,10 @@ bool Game::Initialize()
 
 	LoadData();
 
-	mTicksCount = SDL_GetTicks();
+	// Nothing to interpolate from yet
+	mPrevView = mRenderer->GetViewMatrix();
+	mSimView = mPrevView;
+	mFrameScheduler = new FrameScheduler();
 	
 	return true;
 }
@@ -89,14 +145,115 @@ void Game::RunLoop()
 {
 	while (mGameState != EQuit)
 	{
+		Profiler::Get().BeginFrame();
 		ProcessInput();
 		UpdateGame();
 		GenerateOutput();
+		Profiler::Get().EndFrame();
 	}
 }
 
+void Game::RunHeadless(int numFrames)
+{
+	// Finish loading before timing anything
+	mAssetLoader->WaitAll();
+
+	// Each frame is one fixed step, straight after the last
+	float step = mFrameScheduler->GetFixedStep();
+	Uint64 simTicks = 0;
+	Uint64 renderTransformTicks = 0;
+	Uint64 animTicks = 0;
+	Uint64 audioTicks = 0;
+	Uint64 drawTicks = 0;
+	for (auto& ticks : mPhaseTicks)
+	{
+		ticks = 0;
+	}
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < numFrames; i++)
+	{
+		Profiler::Get().BeginFrame();
+		Uint64 t0 = SDL_GetPerformanceCounter();
+		UpdateActors(step);
+		Uint64 t1 = SDL_GetPerformanceCounter();
+		for (auto actor : mActors)
+		{
+			actor->ComputeRenderTransform(1.0f);
+		}
+		mRenderer->SetViewMatrix(mSimView);
+		Uint64 t2 = SDL_GetPerformanceCounter();
+		UpdateAnimations();
+		Uint64 t3 = SDL_GetPerformanceCounter();
+		mAudioSystem->Update(step);
+		Uint64 t4 = SDL_GetPerformanceCounter();
+		mRenderer->Draw();
+		Uint64 t5 = SDL_GetPerformanceCounter();
+		Profiler::Get().EndFrame();
+
+		simTicks += t1 - t0;
+		renderTransformTicks += t2 - t1;
+		animTicks += t3 - t2;
+		audioTicks += t4 - t3;
+		drawTicks += t5 - t4;
+	}
+	Uint64 totalTicks = SDL_GetPerformanceCounter() - start;
+
+	// Averages in milliseconds per frame
+	double freq = static_cast<double>(SDL_GetPerformanceFrequency());
+	double frames = static_cast<double>(Math::Max(numFrames, 1));
+	auto toMs = [freq, frames](Uint64 ticks) {
+		return ticks * 1000.0 / freq / frames;
+	};
+	double seconds = totalTicks / freq;
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("level");
+	writer.String(mLevelFile.c_str());
+	writer.Key("frames");
+	writer.Int(numFrames);
+	writer.Key("actors");
+	writer.Int(static_cast<int>(mActors.Size()));
+	writer.Key("pointLights");
+	writer.Int(static_cast<int>(mRenderer->GetPointLights().size()));
+	writer.Key("skeletalMeshes");
+	writer.Int(static_cast<int>(mRenderer->GetSkeletalMeshes().size()));
+	writer.Key("workers");
+	writer.Int(static_cast<int>(mJobSystem->GetNumWorkers()));
+	writer.Key("seconds");
+	writer.Double(seconds);
+	writer.Key("fps");
+	writer.Double(seconds > 0.0 ? numFrames / seconds : 0.0);
+	writer.Key("msPerFrame");
+	writer.StartObject();
+	writer.Key("total");
+	writer.Double(toMs(totalTicks));
+	writer.Key("simulation");
+	writer.Double(toMs(simTicks));
+	writer.Key("renderTransforms");
+	writer.Double(toMs(renderTransformTicks));
+	writer.Key("animation");
+	writer.Double(toMs(animTicks));
+	writer.Key("audio");
+	writer.Double(toMs(audioTicks));
+	writer.Key("renderer");
+	writer.Double(toMs(drawTicks));
+	// The simulation's update phases
+	for (int i = 0; i < Component::NUM_UPDATE_PHASES; i++)
+	{
+		writer.Key(Component::UpdatePhaseNames[i]);
+		writer.Double(toMs(mPhaseTicks[i]));
+	}
+	writer.EndObject();
+	writer.EndObject();
+	printf("%s\n", buffer.GetString());
+}
+
 void Game::ProcessInput()
 {
+	PROFILE_SCOPE("Game::ProcessInput");
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
 	{
@@ -195,6 +352,69 @@ void Game::HandleKeyPress(int key)
 		LevelLoader::SaveLevel(this, "Assets/Saved.gplevel");
 		break;
 	}
+	case 'c':
+	{
+		// Log how many meshes were drawn/culled last frame
+		const RenderStats& stats = mRenderer->GetStats();
+		SDL_Log("Meshes drawn: %d, culled: %d",
+			stats.mMeshesDrawn, stats.mMeshesCulled);
+		SDL_Log("Draw calls: %d, shader changes: %d, texture changes: %d, "
+			"vertex array changes: %d", stats.mDrawCalls, stats.mShaderChanges,
+			stats.mTextureChanges, stats.mVertexArrayChanges);
+		SDL_Log("Sprite quads: %d, sprite draw calls: %d",
+			stats.mSpriteQuads, stats.mSpriteDrawCalls);
+		SDL_Log("Point lights: %d (%s), cluster light indices: %d", stats.mPointLights,
+			mRenderer->GetClusteredLights() ? "clustered" : "per-light",
+			stats.mClusterLightIndices);
+		for (auto f : mFonts)
+		{
+			SDL_Log("Font %s: %d glyphs, %d atlas pages, %.1f%% used", f.first.c_str(),
+				f.second->GetNumGlyphs(), f.second->GetNumAtlasPages(),
+				f.second->GetAtlasOccupancy() * 100.0f);
+		}
+		SDL_Log("Pose cache hits: %d, misses: %d",
+			mPoseCache->GetHits(), mPoseCache->GetMisses());
+		const FrameStats& frame = mFrameScheduler->GetStats();
+		SDL_Log("Frame ms avg: %.2f, min: %.2f, max: %.2f, 99%%: %.2f (%.1f FPS)",
+			frame.mAverage, frame.mMin, frame.mMax, frame.mP99, frame.mFPS);
+		break;
+	}
+	case 'p':
+	{
+		// Capture a trace of the next couple of seconds
+		Profiler::Get().StartCapture(120, "profile.json");
+		break;
+	}
+	case 'g':
+	{
+		// Toggle the compact G-buffer layout
+		mRenderer->SetCompactGBuffer(!mRenderer->GetCompactGBuffer());
+		SDL_Log("G-buffer %s", mRenderer->GetCompactGBuffer() ? "compact" : "full");
+		break;
+	}
+	case 'i':
+	{
+		// Toggle instancing
+		mRenderer->SetInstancing(!mRenderer->GetInstancing());
+		SDL_Log("Instancing %s", mRenderer->GetInstancing() ? "on" : "off");
+		break;
+	}
+	case 'l':
+	{
+		// Toggle clustered point lights
+		mRenderer->SetClusteredLights(!mRenderer->GetClusteredLights());
+		SDL_Log("Point lights %s",
+			mRenderer->GetClusteredLights() ? "clustered" : "per-light");
+		break;
+	}
+	case 'v':
+	{
+		// Toggle sorting the render queue
+		mRenderer->SetSortRenderQueue(!mRenderer->GetSortRenderQueue());
+		SDL_Log("Render queue sorting %s",
+			mRenderer->GetSortRenderQueue() ? "on" : "off");
+		break;
+	}
 	case SDL_BUTTON_LEFT:
 	{
 		break;
@@ -206,51 +426,40 @@ void Game::HandleKeyPress(int key)
 
 void Game::UpdateGame()
 {
-	// Compute delta time
-	// Wait until 16ms has elapsed since last frame
-	while (!SDL_TICKS_PASSED(SDL_GetTicks(), mTicksCount + 16))
-		;
-
-	float deltaTime = (SDL_GetTicks() - mTicksCount) / 1000.0f;
-	if (deltaTime > 0.05f)
+	// Wait for the next frame (this sleeps for most of the wait
+	// rather than spinning)
+	float deltaTime = 0.0f;
 	{
-		deltaTime = 0.05f;
+		PROFILE_SCOPE("FrameScheduler::BeginFrame");
+		deltaTime = mFrameScheduler->BeginFrame();
 	}
-	mTicksCount = SDL_GetTicks();
+	PROFILE_SCOPE("Game::UpdateGame");
+
+	// Finish a couple of milliseconds' worth of streamed assets
+	mAssetLoader->ProcessUploads(2.0f);
 
 	if (mGameState == EGameplay)
 	{
-		// Update all actors
-		mUpdatingActors = true;
-		for (auto actor : mActors)
-		{
-			actor->Update(deltaTime);
-		}
-		mUpdatingActors = false;
-
-		// Move any pending actors to mActors
-		for (auto pending : mPendingActors)
+		// Run as many fixed steps as it takes to catch up
+		while (mFrameScheduler->StepSimulation())
 		{
-			pending->ComputeWorldTransform();
-			mActors.emplace_back(pending);
+			UpdateActors(mFrameScheduler->GetFixedStep());
 		}
-		mPendingActors.clear();
 
-		// Add any dead actors to a temp vector
-		std::vector<Actor*> deadActors;
+		// Draw partway between the last two steps
+		float alpha = mFrameScheduler->GetAlpha();
 		for (auto actor : mActors)
 		{
-			if (actor->GetState() == Actor::EDead)
-			{
-				deadActors.emplace_back(actor);
-			}
+			actor->ComputeRenderTransform(alpha);
 		}
+		mRenderer->SetViewMatrix(BlendView(mPrevView, mSimView, alpha));
 
-		// Delete dead actors (which removes them from mActors)
-		for (auto actor : deadActors)
-		{
-			delete actor;
-		}
+		UpdateAnimations();
+	}
+	else
+	{
+		// Don't try to catch up on time spent paused
+		mFrameScheduler->ResetAccumulator();
 	}
 	
 	// Update audio system
@@ -280,6 +489,271 @@ void Game::UpdateGame()
 	}
 }
 
+void Game::UpdateActors(float deltaTime)
+{
+	PROFILE_SCOPE("Game::UpdateActors");
+	// Remember where everything was for interpolation
+	mPrevView = mSimView;
+	for (auto actor : mActors)
+	{
+		actor->SavePreviousTransform();
+		actor->UpdateWorldTransform();
+	}
+
+	if (mPhasesDirty)
+	{
+		BuildUpdatePhases();
+	}
+
+	// Update the components phase by phase, then the actors themselves
+	mUpdatingActors = true;
+	for (int phase = 0; phase < Component::NUM_UPDATE_PHASES; phase++)
+	{
+		RunUpdatePhase(static_cast<Component::UpdatePhase>(phase), deltaTime);
+	}
+	// An actor's update can destroy other actors, which moves the
+	// last actor into the hole, so go through the handles instead
+	// (actors that these updates add wait until the next step)
+	mUpdateHandles.clear();
+	for (size_t i = 0; i < mActors.Size(); i++)
+	{
+		mUpdateHandles.emplace_back(mActors.GetHandle(i));
+	}
+	for (SlotHandle handle : mUpdateHandles)
+	{
+		// (Skip any that were destroyed)
+		Actor** actor = mActors.Get(handle);
+		if (actor)
+		{
+			(*actor)->Update(deltaTime);
+		}
+	}
+	RunDeferred();
+	mUpdatingActors = false;
+
+	// Pending actors are ready for the next step
+	for (SlotHandle handle : mPendingActors)
+	{
+		// (Unless they were already destroyed)
+		Actor** pending = mActors.Get(handle);
+		if (pending)
+		{
+			(*pending)->ComputeWorldTransform();
+			(*pending)->SavePreviousTransform();
+		}
+	}
+	mPendingActors.clear();
+
+	// Add any dead actors to a temp vector
+	std::vector<Actor*> deadActors;
+	for (auto actor : mActors)
+	{
+		if (actor->GetState() == Actor::EDead)
+		{
+			deadActors.emplace_back(actor);
+		}
+	}
+
+	// Delete dead actors (which removes them from mActors)
+	for (auto actor : deadActors)
+	{
+		delete actor;
+	}
+
+	// The camera components set the view during the update
+	mSimView = mRenderer->GetViewMatrix();
+}
+
+void Game::BuildUpdatePhases()
+{
+	PROFILE_SCOPE("Game::BuildUpdatePhases");
+	for (auto& phase : mPhases)
+	{
+		phase.mParallel.clear();
+		phase.mParallelStarts.clear();
+		phase.mSerial.clear();
+	}
+
+	for (auto actor : mActors)
+	{
+		// Where this actor's run starts in each phase
+		size_t starts[Component::NUM_UPDATE_PHASES];
+		for (int i = 0; i < Component::NUM_UPDATE_PHASES; i++)
+		{
+			starts[i] = mPhases[i].mParallel.size();
+		}
+
+		for (auto comp : actor->GetSortedComponents())
+		{
+			if (comp->GetUpdateMode() != Component::EUpdateInPhase)
+			{
+				continue;
+			}
+			PhaseComponents& phase = mPhases[comp->GetUpdatePhase()];
+			if (comp->IsParallelSafe())
+			{
+				phase.mParallel.emplace_back(comp);
+			}
+			else
+			{
+				phase.mSerial.emplace_back(comp);
+			}
+		}
+
+		for (int i = 0; i < Component::NUM_UPDATE_PHASES; i++)
+		{
+			if (mPhases[i].mParallel.size() > starts[i])
+			{
+				mPhases[i].mParallelStarts.emplace_back(starts[i]);
+			}
+		}
+	}
+
+	// End of the last run
+	for (auto& phase : mPhases)
+	{
+		phase.mParallelStarts.emplace_back(phase.mParallel.size());
+	}
+	mPhasesDirty = false;
+}
+
+void Game::RunUpdatePhase(Component::UpdatePhase phase, float deltaTime)
+{
+	PROFILE_SCOPE(Component::UpdatePhaseNames[phase]);
+	Uint64 headlessStart = mHeadless ? SDL_GetPerformanceCounter() : 0;
+	// Boxes (and so the physics world) and cameras need to see
+	// where actors moved to in the earlier phases
+	if (phase == Component::EPhasePhysics || phase == Component::EPhaseLate)
+	{
+		for (auto actor : mActors)
+		{
+			actor->UpdateWorldTransform();
+		}
+	}
+
+	// Plain MoveComponents are pooled, so they're updated in one pass
+	if (phase == Component::EPhasePrePhysics)
+	{
+		PROFILE_SCOPE("MoveComponent::UpdateAll");
+		MoveComponent::UpdateAll(deltaTime, mJobSystem);
+	}
+
+	// While profiling, add up the time each component type takes
+	bool profiling = Profiler::Get().IsCapturing();
+	uint64_t phaseStart = profiling ? Profiler::GetTime() : 0;
+	std::atomic<uint64_t> typeTicks[Component::NUM_COMPONENT_TYPES] = {};
+	auto update = [deltaTime, profiling, &typeTicks](Component* comp)
+	{
+		if (comp->GetOwner()->GetState() != Actor::EActive)
+		{
+			return;
+		}
+		if (profiling)
+		{
+			uint64_t start = Profiler::GetTime();
+			comp->Update(deltaTime);
+			typeTicks[comp->GetType()] += Profiler::GetTime() - start;
+		}
+		else
+		{
+			comp->Update(deltaTime);
+		}
+	};
+
+	PhaseComponents& comps = mPhases[phase];
+	if (comps.mParallelStarts.size() > 1)
+	{
+		size_t numRuns = comps.mParallelStarts.size() - 1;
+		mJobSystem->ParallelFor(numRuns, 16, [&comps, &update](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				for (size_t j = comps.mParallelStarts[i]; j < comps.mParallelStarts[i + 1]; j++)
+				{
+					update(comps.mParallel[j]);
+				}
+			}
+		});
+	}
+
+	for (auto comp : comps.mSerial)
+	{
+		update(comp);
+	}
+
+	RunDeferred();
+
+	if (mHeadless)
+	{
+		mPhaseTicks[phase] += SDL_GetPerformanceCounter() - headlessStart;
+	}
+
+	// Lay the totals out back to back from the start of the phase
+	if (profiling)
+	{
+		uint64_t start = phaseStart;
+		for (int i = 0; i < Component::NUM_COMPONENT_TYPES; i++)
+		{
+			uint64_t ticks = typeTicks[i];
+			if (ticks > 0)
+			{
+				Profiler::Get().AddTrackEvent(Profiler::TotalsTrack,
+					Component::TypeNames[i], start, start + ticks);
+				start += ticks;
+			}
+		}
+	}
+}
+
+void Game::Defer(std::function<void()> func)
+{
+	std::lock_guard<std::mutex> lock(mDeferredMutex);
+	mDeferred.emplace_back(std::move(func));
+}
+
+void Game::RunDeferred()
+{
+	std::vector<std::function<void()>> deferred;
+	{
+		std::lock_guard<std::mutex> lock(mDeferredMutex);
+		deferred.swap(mDeferred);
+	}
+	// (Anything these defer runs after the next phase)
+	for (auto& func : deferred)
+	{
+		func();
+	}
+}
+
+void Game::UpdateAnimations()
+{
+	PROFILE_SCOPE("Game::UpdateAnimations");
+	mPoseCache->BeginFrame();
+
+	// Camera for the animation LOD (this frame's view, which is
+	// the one the renderer is about to draw with)
+	const Matrix4& proj = mRenderer->GetProjectionMatrix();
+	Matrix4 view = mRenderer->GetViewMatrix();
+	Frustum frustum(view * proj);
+	view.InvertAffine();
+	AnimLODCamera camera;
+	camera.mFrustum = &frustum;
+	camera.mPosition = view.GetTranslation();
+	camera.mProjScale = proj.mat[1][1];
+
+	// Each component only writes its own palette, so they can be
+	// split across the workers. This returns once they're all done,
+	// so the renderer always sees finished palettes.
+	const std::vector<SkeletalMeshComponent*>& meshes = mRenderer->GetSkeletalMeshes();
+	mJobSystem->ParallelFor(meshes.size(), 4, [&meshes, &camera](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			meshes[i]->UpdatePalette(camera);
+		}
+	});
+}
+
 void Game::GenerateOutput()
 {
 	mRenderer->Draw();
@@ -293,24 +767,31 @@ void Game::LoadData()
 	mHUD = new HUD(this);
 
 	// Load the level from file
-	LevelLoader::LoadLevel(this, "Assets/Level3.gplevel");
+	LevelLoader::LoadLevel(this, mLevelFile);
 	
 	// Start music
 	mMusicEvent = mAudioSystem->PlayEvent("event:/Music");
 
-	// Enable relative mouse mode for camera look
-	SDL_SetRelativeMouseMode(SDL_TRUE);
-	// Make an initial call to get relative to clear out
-	SDL_GetRelativeMouseState(nullptr, nullptr);
+	if (!mHeadless)
+	{
+		// Enable relative mouse mode for camera look
+		SDL_SetRelativeMouseMode(SDL_TRUE);
+		// Make an initial call to get relative to clear out
+		SDL_GetRelativeMouseState(nullptr, nullptr);
+	}
 }
 
 void Game::UnloadData()
 {
+	// Drop any loads still in flight, since they fill in assets
+	// that are about to be deleted
+	mAssetLoader->Cancel();
+
 	// Delete actors
 	// Because ~Actor calls RemoveActor, have to use a different style loop
-	while (!mActors.empty())
+	while (!mActors.Empty())
 	{
-		delete mActors.back();
+		delete mActors.GetValues().back();
 	}
 
 	// Clear the UI stack
@@ -350,6 +831,10 @@ void Game::Shutdown()
 	UnloadData();
 	TTF_Quit();
 	delete mPhysWorld;
+	delete mJobSystem;
+	delete mAssetLoader;
+	delete mPoseCache;
+	delete mFrameScheduler;
 	if (mRenderer)
 	{
 		mRenderer->Shutdown();
@@ -361,38 +846,20 @@ void Game::Shutdown()
 	SDL_Quit();
 }
 
-void Game::AddActor(Actor* actor)
+SlotHandle Game::AddActor(Actor* actor)
 {
-	// If we're updating actors, need to add to pending
+	SlotHandle handle = mActors.Insert(actor);
+	// If we're updating actors, it waits until the update's done
 	if (mUpdatingActors)
 	{
-		mPendingActors.emplace_back(actor);
-	}
-	else
-	{
-		mActors.emplace_back(actor);
+		mPendingActors.emplace_back(handle);
 	}
+	return handle;
 }
 
-void Game::RemoveActor(Actor* actor)
+void Game::RemoveActor(SlotHandle handle)
 {
-	// Is it in pending actors?
-	auto iter = std::find(mPendingActors.begin(), mPendingActors.end(), actor);
-	if (iter != mPendingActors.end())
-	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mPendingActors.end() - 1);
-		mPendingActors.pop_back();
-	}
-
-	// Is it in actors?
-	iter = std::find(mActors.begin(), mActors.end(), actor);
-	if (iter != mActors.end())
-	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mActors.end() - 1);
-		mActors.pop_back();
-	}
+	mActors.Remove(handle);
 }
 
 void Game::PushUI(UIScreen* screen)
@@ -466,6 +933,8 @@ const std::string& Game::GetText(const std::string& key)
 
 Skeleton* Game::GetSkeleton(const std::string& fileName)
 {
+	// Let a preloading skeleton finish first
+	mAssetLoader->Wait(fileName);
 	auto iter = mSkeletons.find(fileName);
 	if (iter != mSkeletons.end())
 	{
@@ -489,6 +958,8 @@ Skeleton* Game::GetSkeleton(const std::string& fileName)
 
 Animation* Game::GetAnimation(const std::string& fileName)
 {
+	// Let a preloading animation finish first
+	mAssetLoader->Wait(fileName);
 	auto iter = mAnims.find(fileName);
 	if (iter != mAnims.end())
 	{
@@ -509,3 +980,47 @@ Animation* Game::GetAnimation(const std::string& fileName)
 		return anim;
 	}
 }
+
+void Game::PreloadSkeleton(const std::string& fileName)
+{
+	if (mSkeletons.find(fileName) != mSkeletons.end())
+	{
+		return;
+	}
+	// It's in the map right away, but nothing looks at it until
+	// the load's done (GetSkeleton waits)
+	Skeleton* sk = new Skeleton();
+	mSkeletons.emplace(fileName, sk);
+	mAssetLoader->Load(fileName, [this, fileName, sk]() -> AssetLoader::FinishFunc {
+		if (sk->Load(fileName))
+		{
+			return nullptr;
+		}
+		// Take it back out, on the main thread
+		return [this, fileName, sk]() {
+			mSkeletons.erase(fileName);
+			delete sk;
+		};
+	});
+}
+
+void Game::PreloadAnimation(const std::string& fileName)
+{
+	if (mAnims.find(fileName) != mAnims.end())
+	{
+		return;
+	}
+	// Same as PreloadSkeleton
+	Animation* anim = new Animation();
+	mAnims.emplace(fileName, anim);
+	mAssetLoader->Load(fileName, [this, fileName, anim]() -> AssetLoader::FinishFunc {
+		if (anim->Load(fileName))
+		{
+			return nullptr;
+		}
+		return [this, fileName, anim]() {
+			mAnims.erase(fileName);
+			delete anim;
+		};
+	});
+}
@@ -7,27 +7,51 @@
 // ----------------------------------------------------------------
 
 #pragma once
+#include <functional>
+#include <mutex>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include "Math.h"
 #include "SoundEvent.h"
+#include "SlotMap.h"
+#include "Component.h"
 #include <SDL/SDL_types.h>
 
 class Game
 {
 public:
 	Game();
-	bool Initialize();
+	// Headless runs have no window, OpenGL or audio (see RunHeadless)
+	bool Initialize(bool headless = false);
 	void RunLoop();
+	// Runs numFrames frames (one simulation step each) as fast as
+	// possible, then prints the timings as JSON to stdout
+	void RunHeadless(int numFrames);
 	void Shutdown();
 
-	void AddActor(class Actor* actor);
-	void RemoveActor(class Actor* actor);
+	// Level loaded by Initialize
+	void SetLevelFile(const std::string& fileName) { mLevelFile = fileName; }
+
+	// Returns the handle to remove the actor with
+	SlotHandle AddActor(class Actor* actor);
+	void RemoveActor(SlotHandle handle);
+
+	// Queues func to run on the main thread once the current update
+	// phase is done. Safe to call from any thread, so components that
+	// update in parallel use it for anything that isn't, like creating
+	// actors or playing sounds. (To destroy an actor, set it to EDead.)
+	void Defer(std::function<void()> func);
+	// Called by actors when they gain or lose a component
+	void OnComponentsChanged() { mPhasesDirty = true; }
 
 	class Renderer* GetRenderer() { return mRenderer; }
 	class AudioSystem* GetAudioSystem() { return mAudioSystem; }
 	class PhysWorld* GetPhysWorld() { return mPhysWorld; }
+	class JobSystem* GetJobSystem() { return mJobSystem; }
+	class AssetLoader* GetAssetLoader() { return mAssetLoader; }
+	class PoseCache* GetPoseCache() { return mPoseCache; }
+	class FrameScheduler* GetFrameScheduler() { return mFrameScheduler; }
 	class HUD* GetHUD() { return mHUD; }
 	
 	// Manage UI stack
@@ -55,18 +79,34 @@ public:
 
 	class Animation* GetAnimation(const std::string& fileName);
 
-	const std::vector<class Actor*>& GetActors() const { return mActors; }
+	// Start loading on the AssetLoader, so a later GetSkeleton or
+	// GetAnimation only waits for whatever's left
+	void PreloadSkeleton(const std::string& fileName);
+	void PreloadAnimation(const std::string& fileName);
+
+	const std::vector<class Actor*>& GetActors() const { return mActors.GetValues(); }
 	void SetFollowActor(class FollowActor* actor) { mFollowActor = actor; }
 private:
 	void ProcessInput();
 	void HandleKeyPress(int key);
 	void UpdateGame();
+	// One fixed simulation step of every actor
+	void UpdateActors(float deltaTime);
+	// Sorts the components into the phases they update in
+	void BuildUpdatePhases();
+	// Updates the components in one phase (the parallel-safe ones
+	// on the workers, then the rest in order on this thread)
+	void RunUpdatePhase(Component::UpdatePhase phase, float deltaTime);
+	// Runs everything queued with Defer
+	void RunDeferred();
+	// Compute the matrix palettes of every skeletal mesh on the workers
+	void UpdateAnimations();
 	void GenerateOutput();
 	void LoadData();
 	void UnloadData();
 	
 	// All the actors in the game
-	std::vector<class Actor*> mActors;
+	SlotMap<class Actor*> mActors;
 	std::vector<class UIScreen*> mUIStack;
 	// Map for fonts
 	std::unordered_map<std::string, class Font*> mFonts;
@@ -77,18 +117,49 @@ private:
 
 	// Map for text localization
 	std::unordered_map<std::string, std::string> mText;
-	// Any pending actors
-	std::vector<class Actor*> mPendingActors;
+	// Actors added during the update (they're in mActors, but
+	// don't update until the next step)
+	std::vector<SlotHandle> mPendingActors;
+	// Handles of the actors to update this step (reused every step)
+	std::vector<SlotHandle> mUpdateHandles;
+
+	// The components that update in one phase
+	struct PhaseComponents
+	{
+		// Parallel-safe components, grouped by actor. Actor i's run is
+		// [mParallelStarts[i], mParallelStarts[i + 1]), and a run is
+		// always updated in order by one thread.
+		std::vector<class Component*> mParallel;
+		std::vector<size_t> mParallelStarts;
+		// Everything else, in actor order
+		std::vector<class Component*> mSerial;
+	};
+	PhaseComponents mPhases[Component::NUM_UPDATE_PHASES];
+	// Functions queued by Defer
+	std::vector<std::function<void()>> mDeferred;
+	std::mutex mDeferredMutex;
 
 	class Renderer* mRenderer;
 	class AudioSystem* mAudioSystem;
 	class PhysWorld* mPhysWorld;
+	class JobSystem* mJobSystem;
+	class AssetLoader* mAssetLoader;
+	class PoseCache* mPoseCache;
+	class FrameScheduler* mFrameScheduler;
 	class HUD* mHUD;
 
-	Uint32 mTicksCount;
+	// Camera view before and after the last simulation step
+	Matrix4 mPrevView;
+	Matrix4 mSimView;
 	GameState mGameState;
 	// Track if we're updating actors right now
 	bool mUpdatingActors;
+	// Set when mPhases needs rebuilding
+	bool mPhasesDirty;
+	bool mHeadless;
+	std::string mLevelFile;
+	// Time spent in each phase (only tracked when headless)
+	Uint64 mPhaseTicks[Component::NUM_UPDATE_PHASES];
 
 	// Game-specific code
 	class FollowActor* mFollowActor;
@@ -8,7 +8,7 @@
 
 #include "HUD.h"
 #include "Texture.h"
-#include "Shader.h"
+#include "SpriteBatch.h"
 #include "Game.h"
 #include "Renderer.h"
 #include "PhysWorld.h"
@@ -44,42 +44,40 @@ void HUD::Update(float deltaTime)
 	UpdateRadar(deltaTime);
 }
 
-void HUD::Draw(Shader* shader)
+void HUD::Draw(SpriteBatch* batch)
 {
 	// Crosshair
 	//Texture* cross = mTargetEnemy ? mCrosshairEnemy : mCrosshair;
-	//DrawTexture(shader, cross, Vector2::Zero, 2.0f);
+	//DrawTexture(batch, cross, Vector2::Zero, 2.0f);
 	
 	// Radar
 	const Vector2 cRadarPos(-390.0f, 275.0f);
-	DrawTexture(shader, mRadar, cRadarPos, 1.0f);
+	DrawTexture(batch, mRadar, cRadarPos, 1.0f);
 	// Blips
 	for (Vector2& blip : mBlips)
 	{
-		DrawTexture(shader, mBlipTex, cRadarPos + blip, 1.0f);
+		DrawTexture(batch, mBlipTex, cRadarPos + blip, 1.0f);
 	}
 	// Radar arrow
-	DrawTexture(shader, mRadarArrow, cRadarPos);
+	DrawTexture(batch, mRadarArrow, cRadarPos);
 	
 	//// Health bar
-	//DrawTexture(shader, mHealthBar, Vector2(-350.0f, -350.0f));
+	//DrawTexture(batch, mHealthBar, Vector2(-350.0f, -350.0f));
 	// Draw the mirror (bottom left)
 	//Texture* mirror = mGame->GetRenderer()->GetMirrorTexture();
-	//DrawTexture(shader, mirror, Vector2(-350.0f, -250.0f), 1.0f, true);
+	//DrawTexture(batch, mirror, Vector2(-350.0f, -250.0f), 1.0f, true);
 	//Texture* tex = mGame->GetRenderer()->GetGBuffer()->GetTexture(GBuffer::EDiffuse);
-	//DrawTexture(shader, tex, Vector2::Zero, 1.0f, true);
+	//DrawTexture(batch, tex, Vector2::Zero, 1.0f, true);
 }
 
-void HUD::AddTargetComponent(TargetComponent* tc)
+SlotHandle HUD::AddTargetComponent(TargetComponent* tc)
 {
-	mTargetComps.emplace_back(tc);
+	return mTargetComps.Insert(tc);
 }
 
-void HUD::RemoveTargetComponent(TargetComponent* tc)
+void HUD::RemoveTargetComponent(SlotHandle handle)
 {
-	auto iter = std::find(mTargetComps.begin(), mTargetComps.end(),
-		tc);
-	mTargetComps.erase(iter);
+	mTargetComps.Remove(handle);
 }
 
 void HUD::UpdateCrosshair(float deltaTime)
@@ -8,6 +8,7 @@
 
 #pragma once
 #include "UIScreen.h"
+#include "SlotMap.h"
 #include <vector>
 
 class HUD : public UIScreen
@@ -18,10 +19,11 @@ public:
 	~HUD();
 
 	void Update(float deltaTime) override;
-	void Draw(class Shader* shader) override;
+	void Draw(class SpriteBatch* batch) override;
 	
-	void AddTargetComponent(class TargetComponent* tc);
-	void RemoveTargetComponent(class TargetComponent* tc);
+	// Returns the handle to remove the component with
+	SlotHandle AddTargetComponent(class TargetComponent* tc);
+	void RemoveTargetComponent(SlotHandle handle);
 protected:
 	void UpdateCrosshair(float deltaTime);
 	void UpdateRadar(float deltaTime);
@@ -34,7 +36,7 @@ protected:
 	class Texture* mRadarArrow;
 	
 	// All the target components in the game
-	std::vector<class TargetComponent*> mTargetComps;
+	SlotMap<class TargetComponent*> mTargetComps;
 	// 2D offsets of blips relative to radar
 	std::vector<Vector2> mBlips;
 	// Adjust range of radar and radius
@@ -0,0 +1,203 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "InstanceBatch.h"
+#include "Mesh.h"
+#include "MeshComponent.h"
+#include "Actor.h"
+#include "VertexArray.h"
+#include "Frustum.h"
+#include <GL/glew.h>
+
+InstanceBatch::InstanceBatch(Mesh* mesh, size_t textureIndex)
+	:mMesh(mesh)
+	,mTextureIndex(textureIndex)
+	,mInstanceBuffer(0)
+	,mCapacity(0)
+	,mDirtyMin(0)
+	,mDirtyMax(0)
+	,mBufferHasAll(true)
+	,mNumVisible(0)
+	,mCenter(Vector3::Zero)
+{
+	glGenBuffers(1, &mInstanceBuffer);
+}
+
+InstanceBatch::~InstanceBatch()
+{
+	// Anything still in the batch goes back to drawing on its own
+	for (MeshComponent* mc : mInstances)
+	{
+		mc->SetInstanceBatch(nullptr, -1);
+	}
+	glDeleteBuffers(1, &mInstanceBuffer);
+}
+
+Texture* InstanceBatch::GetTexture() const
+{
+	return mMesh->GetTexture(mTextureIndex);
+}
+
+void InstanceBatch::AddInstance(MeshComponent* mc)
+{
+	int slot = static_cast<int>(mInstances.size());
+	mInstances.emplace_back(mc);
+	mTransforms.emplace_back(mc->GetOwner()->GetRenderTransform());
+	mCenterX.emplace_back(0.0f);
+	mCenterY.emplace_back(0.0f);
+	mCenterZ.emplace_back(0.0f);
+	mRadius.emplace_back(0.0f);
+	SetBounds(slot, mTransforms[slot]);
+	mc->SetInstanceBatch(this, slot);
+	MarkDirty(slot);
+}
+
+void InstanceBatch::RemoveInstance(MeshComponent* mc)
+{
+	size_t slot = static_cast<size_t>(mc->GetInstanceSlot());
+	size_t last = mInstances.size() - 1;
+	if (slot != last)
+	{
+		// Swap the last instance into this slot
+		mInstances[slot] = mInstances[last];
+		mTransforms[slot] = mTransforms[last];
+		mCenterX[slot] = mCenterX[last];
+		mCenterY[slot] = mCenterY[last];
+		mCenterZ[slot] = mCenterZ[last];
+		mRadius[slot] = mRadius[last];
+		mInstances[slot]->SetInstanceBatch(this, static_cast<int>(slot));
+		MarkDirty(slot);
+	}
+	mInstances.pop_back();
+	mTransforms.pop_back();
+	mCenterX.pop_back();
+	mCenterY.pop_back();
+	mCenterZ.pop_back();
+	mRadius.pop_back();
+	mc->SetInstanceBatch(nullptr, -1);
+	// Nothing past the end needs uploading
+	mDirtyMax = Math::Min(mDirtyMax, mInstances.size());
+	mDirtyMin = Math::Min(mDirtyMin, mDirtyMax);
+}
+
+void InstanceBatch::SetTransform(int slot, const Matrix4& transform)
+{
+	mTransforms[slot] = transform;
+	SetBounds(static_cast<size_t>(slot), transform);
+	MarkDirty(static_cast<size_t>(slot));
+}
+
+void InstanceBatch::MarkDirty(size_t slot)
+{
+	if (mDirtyMin == mDirtyMax)
+	{
+		mDirtyMin = slot;
+		mDirtyMax = slot + 1;
+	}
+	else
+	{
+		mDirtyMin = Math::Min(mDirtyMin, slot);
+		mDirtyMax = Math::Max(mDirtyMax, slot + 1);
+	}
+}
+
+void InstanceBatch::SetBounds(size_t slot, const Matrix4& transform)
+{
+	// The mesh radius is from the object space origin,
+	// so scale it by the largest axis of the transform
+	Vector3 center = transform.GetTranslation();
+	Vector3 scale = transform.GetScale();
+	mCenterX[slot] = center.x;
+	mCenterY[slot] = center.y;
+	mCenterZ[slot] = center.z;
+	mRadius[slot] = mMesh->GetRadius() * Math::Max(scale.x, Math::Max(scale.y, scale.z));
+}
+
+size_t InstanceBatch::Cull(const Frustum* frustum)
+{
+	size_t count = mInstances.size();
+	mNumVisible = count;
+	if (frustum)
+	{
+		mVisible.resize(count);
+		mNumVisible = frustum->CullSpheres(mCenterX.data(), mCenterY.data(),
+			mCenterZ.data(), mRadius.data(), count, mVisible.data());
+	}
+
+	bool grow = count > mCapacity;
+	if (grow)
+	{
+		// Grow the buffer (doubling so adding instances one at a
+		// time doesn't reallocate every frame)
+		mCapacity = Math::Max(count, mCapacity * 2);
+		glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(Matrix4), nullptr,
+			GL_DYNAMIC_DRAW);
+	}
+
+	Vector3 sum = Vector3::Zero;
+	if (mNumVisible == count)
+	{
+		if (grow || !mBufferHasAll)
+		{
+			// Upload them all
+			glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Matrix4),
+				mTransforms.data());
+		}
+		else if (mDirtyMax > mDirtyMin)
+		{
+			// Only the instances that changed
+			glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+			glBufferSubData(GL_ARRAY_BUFFER, mDirtyMin * sizeof(Matrix4),
+				(mDirtyMax - mDirtyMin) * sizeof(Matrix4), &mTransforms[mDirtyMin]);
+		}
+		mBufferHasAll = true;
+		for (size_t i = 0; i < count; i++)
+		{
+			sum += Vector3(mCenterX[i], mCenterY[i], mCenterZ[i]);
+		}
+	}
+	else
+	{
+		// Pack the visible transforms at the start of the buffer
+		mVisibleTransforms.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (mVisible[i])
+			{
+				mVisibleTransforms.emplace_back(mTransforms[i]);
+				sum += Vector3(mCenterX[i], mCenterY[i], mCenterZ[i]);
+			}
+		}
+		if (mNumVisible > 0)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, mNumVisible * sizeof(Matrix4),
+				mVisibleTransforms.data());
+		}
+		mBufferHasAll = false;
+	}
+	mDirtyMin = mDirtyMax = 0;
+
+	if (mNumVisible > 0)
+	{
+		mCenter = sum * (1.0f / static_cast<float>(mNumVisible));
+	}
+	return mNumVisible;
+}
+
+void InstanceBatch::Draw()
+{
+	VertexArray* va = mMesh->GetVertexArray();
+	// The vertex array may be shared by several batches (with
+	// different textures), so point it at this batch's buffer
+	va->SetInstanceBuffer(mInstanceBuffer);
+	glDrawElementsInstanced(GL_TRIANGLES, va->GetNumIndices(), GL_UNSIGNED_INT,
+		nullptr, static_cast<GLsizei>(mNumVisible));
+}
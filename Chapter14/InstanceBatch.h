@@ -0,0 +1,79 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Math.h"
+
+// All the mesh components that use the same mesh and texture,
+// drawn with a single instanced draw call. The world transforms
+// are kept in a per-instance vertex buffer. While every instance
+// is on screen only the ones that changed get uploaded again,
+// otherwise the visible ones are packed together and uploaded.
+class InstanceBatch
+{
+public:
+	InstanceBatch(class Mesh* mesh, size_t textureIndex);
+	~InstanceBatch();
+
+	// Add/remove a mesh component. Removing moves the last
+	// instance into the empty slot
+	void AddInstance(class MeshComponent* mc);
+	void RemoveInstance(class MeshComponent* mc);
+	// Called when an instance's world transform changes
+	void SetTransform(int slot, const Matrix4& transform);
+
+	// Cull each instance against the frustum (or draw them all if
+	// it's null), and upload the transforms of the visible ones.
+	// Returns the number of visible instances.
+	size_t Cull(const class Frustum* frustum);
+	// Draw the visible instances (the shader and the mesh's
+	// vertex array need to be active)
+	void Draw();
+
+	class Mesh* GetMesh() const { return mMesh; }
+	size_t GetTextureIndex() const { return mTextureIndex; }
+	class Texture* GetTexture() const;
+	size_t GetNumInstances() const { return mInstances.size(); }
+
+	// Average position of the visible instances (updated by Cull)
+	const Vector3& GetCenter() const { return mCenter; }
+private:
+	void MarkDirty(size_t slot);
+	// Bounding sphere of the instance in the slot
+	void SetBounds(size_t slot, const Matrix4& transform);
+
+	class Mesh* mMesh;
+	size_t mTextureIndex;
+	std::vector<class MeshComponent*> mInstances;
+	// CPU copy of the per-instance buffer
+	std::vector<Matrix4> mTransforms;
+	// OpenGL ID of the per-instance vertex buffer
+	unsigned int mInstanceBuffer;
+	// Number of instances the GPU buffer has room for
+	size_t mCapacity;
+	// Range of slots that need uploading ([min, max))
+	size_t mDirtyMin;
+	size_t mDirtyMax;
+	// Whether the GPU buffer has every transform in slot order
+	// (false after only the visible ones were uploaded)
+	bool mBufferHasAll;
+	// Bounding spheres of the instances, as separate arrays
+	// for Frustum::CullSpheres
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;
+	std::vector<uint8_t> mVisible;
+	// The visible transforms, packed together for uploading
+	std::vector<Matrix4> mVisibleTransforms;
+	size_t mNumVisible;
+	Vector3 mCenter;
+};
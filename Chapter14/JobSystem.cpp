@@ -0,0 +1,121 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "JobSystem.h"
+
+JobSystem::JobSystem(unsigned numWorkers)
+	:mFunc(nullptr)
+	,mCount(0)
+	,mRange(1)
+	,mNext(0)
+	,mActive(0)
+	,mGeneration(0)
+	,mQuit(false)
+{
+	if (numWorkers == 0)
+	{
+		unsigned hardware = std::thread::hardware_concurrency();
+		numWorkers = hardware > 1 ? hardware - 1 : 0;
+	}
+	for (unsigned i = 0; i < numWorkers; i++)
+	{
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t minRange,
+	const std::function<void(size_t, size_t)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// A few ranges per thread, so threads that finish early
+	// can pick up more work
+	size_t numThreads = mWorkers.size() + 1;
+	size_t range = (count + numThreads * 4 - 1) / (numThreads * 4);
+	range = range > minRange ? range : (minRange > 0 ? minRange : 1);
+
+	// Not worth waking the workers for a single range
+	if (mWorkers.empty() || range >= count)
+	{
+		func(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFunc = &func;
+		mCount = count;
+		mRange = range;
+		mNext = 0;
+		mActive = mWorkers.size();
+		mGeneration++;
+	}
+	mWake.notify_all();
+
+	RunRanges();
+
+	// Every worker has to check in, so none of them are still
+	// looking at this job when the next one starts
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [this] { return mActive == 0; });
+	mFunc = nullptr;
+}
+
+void JobSystem::WorkerLoop()
+{
+	uint64_t generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this, generation] {
+				return mQuit || mGeneration != generation;
+			});
+			if (mQuit)
+			{
+				return;
+			}
+			generation = mGeneration;
+		}
+
+		RunRanges();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (--mActive == 0)
+		{
+			mDone.notify_one();
+		}
+	}
+}
+
+void JobSystem::RunRanges()
+{
+	size_t begin = mNext.fetch_add(mRange);
+	while (begin < mCount)
+	{
+		size_t end = begin + mRange < mCount ? begin + mRange : mCount;
+		(*mFunc)(begin, end);
+		begin = mNext.fetch_add(mRange);
+	}
+}
@@ -0,0 +1,56 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting loops over data
+// (threads are started once, instead of every frame)
+class JobSystem
+{
+public:
+	// 0 workers means one less than the number of hardware threads
+	JobSystem(unsigned numWorkers = 0);
+	~JobSystem();
+
+	// Calls func(begin, end) over ranges covering [0, count), on the
+	// workers and the calling thread. Ranges have at least minRange
+	// items. Returns once every range is done.
+	// (Only call from one thread at a time, and not from inside a job)
+	void ParallelFor(size_t count, size_t minRange,
+		const std::function<void(size_t, size_t)>& func);
+
+	size_t GetNumWorkers() const { return mWorkers.size(); }
+private:
+	void WorkerLoop();
+	// Runs ranges of the current job until there are none left
+	void RunRanges();
+
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	// Signaled when there's a new job (or on shutdown)
+	std::condition_variable mWake;
+	// Signaled when the last worker finishes the job
+	std::condition_variable mDone;
+	// Current job
+	const std::function<void(size_t, size_t)>* mFunc;
+	size_t mCount;
+	size_t mRange;
+	std::atomic<size_t> mNext;
+	// Workers still running the current job
+	size_t mActive;
+	// Bumped for each job so workers know to wake up
+	uint64_t mGeneration;
+	bool mQuit;
+};
@@ -0,0 +1,163 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "LevelGenerator.h"
+#include "LevelLoader.h"
+#include <fstream>
+#include <random>
+#include <SDL/SDL_log.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/prettywriter.h>
+
+namespace
+{
+	// Has to match the version LevelLoader expects
+	const int LevelVersion = 1;
+
+	class ActorWriter
+	{
+	public:
+		ActorWriter(rapidjson::Document& doc, std::mt19937& rng, float worldSize)
+			:mAlloc(doc.GetAllocator())
+			,mRng(rng)
+			,mHalfSize(worldSize * 0.5f)
+		{
+		}
+
+		// Starts an actor at a random spot on the ground
+		rapidjson::Value Begin(const char* type, float z, float scale)
+		{
+			rapidjson::Value actor(rapidjson::kObjectType);
+			JsonHelper::AddString(mAlloc, actor, "type", type);
+
+			rapidjson::Value props(rapidjson::kObjectType);
+			Vector3 pos(Random(-mHalfSize, mHalfSize), Random(-mHalfSize, mHalfSize), z);
+			Quaternion rot(Vector3::UnitZ, Random(0.0f, Math::TwoPi));
+			JsonHelper::AddString(mAlloc, props, "state", "active");
+			JsonHelper::AddVector3(mAlloc, props, "position", pos);
+			JsonHelper::AddQuaternion(mAlloc, props, "rotation", rot);
+			JsonHelper::AddFloat(mAlloc, props, "scale", scale);
+			actor.AddMember("properties", props, mAlloc);
+			actor.AddMember("components", rapidjson::Value(rapidjson::kArrayType), mAlloc);
+			return actor;
+		}
+
+		void AddComponent(rapidjson::Value& actor, const char* type, rapidjson::Value& props)
+		{
+			rapidjson::Value comp(rapidjson::kObjectType);
+			JsonHelper::AddString(mAlloc, comp, "type", type);
+			comp.AddMember("properties", props, mAlloc);
+			actor["components"].PushBack(comp, mAlloc);
+		}
+
+		float Random(float min, float max)
+		{
+			std::uniform_real_distribution<float> dist(min, max);
+			return dist(mRng);
+		}
+
+	private:
+		rapidjson::Document::AllocatorType& mAlloc;
+		std::mt19937& mRng;
+		float mHalfSize;
+	};
+}
+
+bool LevelGenerator::Generate(const std::string& fileName, const LevelGenParams& params)
+{
+	std::mt19937 rng(params.mSeed);
+	rapidjson::Document doc;
+	doc.SetObject();
+	JsonHelper::AddInt(doc.GetAllocator(), doc, "version", LevelVersion);
+	ActorWriter writer(doc, rng, params.mWorldSize);
+	rapidjson::Document::AllocatorType& alloc = doc.GetAllocator();
+
+	// Same lighting as the hand made levels
+	rapidjson::Value globals(rapidjson::kObjectType);
+	JsonHelper::AddVector3(alloc, globals, "ambientLight", Vector3(0.4f, 0.4f, 0.4f));
+	rapidjson::Value dirLight(rapidjson::kObjectType);
+	JsonHelper::AddVector3(alloc, dirLight, "direction", Vector3(0.0f, -0.707f, -0.707f));
+	JsonHelper::AddVector3(alloc, dirLight, "color", Vector3(0.78f, 0.88f, 1.0f));
+	globals.AddMember("directionalLight", dirLight, alloc);
+	doc.AddMember("globalProperties", globals, alloc);
+
+	rapidjson::Value actors(rapidjson::kArrayType);
+	for (int i = 0; i < params.mMovers; i++)
+	{
+		rapidjson::Value actor = writer.Begin("Actor", 0.0f, 1.0f);
+		rapidjson::Value mesh(rapidjson::kObjectType);
+		JsonHelper::AddString(alloc, mesh, "meshFile", "Assets/Sphere.gpmesh");
+		writer.AddComponent(actor, "MeshComponent", mesh);
+		rapidjson::Value move(rapidjson::kObjectType);
+		JsonHelper::AddFloat(alloc, move, "forwardSpeed", writer.Random(50.0f, 300.0f));
+		JsonHelper::AddFloat(alloc, move, "angularSpeed", writer.Random(-1.0f, 1.0f));
+		writer.AddComponent(actor, "MoveComponent", move);
+		actors.PushBack(actor, alloc);
+	}
+
+	for (int i = 0; i < params.mBoxes; i++)
+	{
+		rapidjson::Value actor = writer.Begin("Actor", 0.0f, writer.Random(50.0f, 200.0f));
+		rapidjson::Value mesh(rapidjson::kObjectType);
+		JsonHelper::AddString(alloc, mesh, "meshFile", "Assets/Cube.gpmesh");
+		writer.AddComponent(actor, "MeshComponent", mesh);
+		// The cube mesh is one unit across
+		rapidjson::Value box(rapidjson::kObjectType);
+		JsonHelper::AddVector3(alloc, box, "objectMin", Vector3(-0.5f, -0.5f, -0.5f));
+		JsonHelper::AddVector3(alloc, box, "objectMax", Vector3(0.5f, 0.5f, 0.5f));
+		writer.AddComponent(actor, "BoxComponent", box);
+		actors.PushBack(actor, alloc);
+	}
+
+	for (int i = 0; i < params.mLights; i++)
+	{
+		rapidjson::Value actor = writer.Begin("Actor", 50.0f, 1.0f);
+		rapidjson::Value light(rapidjson::kObjectType);
+		Vector3 color(writer.Random(0.2f, 1.0f), writer.Random(0.2f, 1.0f), writer.Random(0.2f, 1.0f));
+		JsonHelper::AddVector3(alloc, light, "color", color);
+		JsonHelper::AddFloat(alloc, light, "innerRadius", 100.0f);
+		JsonHelper::AddFloat(alloc, light, "outerRadius", 300.0f);
+		writer.AddComponent(actor, "PointLightComponent", light);
+		actors.PushBack(actor, alloc);
+	}
+
+	const char* anims[] = {
+		"Assets/CatActionIdle.gpanim",
+		"Assets/CatRunSprint.gpanim",
+		"Assets/CatRunMOBA.gpanim"
+	};
+	for (int i = 0; i < params.mSkeletalMeshes; i++)
+	{
+		rapidjson::Value actor = writer.Begin("Actor", -100.0f, 1.0f);
+		rapidjson::Value mesh(rapidjson::kObjectType);
+		JsonHelper::AddString(alloc, mesh, "meshFile", "Assets/CatWarrior.gpmesh");
+		JsonHelper::AddBool(alloc, mesh, "isSkeletal", true);
+		JsonHelper::AddString(alloc, mesh, "skelFile", "Assets/CatWarrior.gpskel");
+		JsonHelper::AddString(alloc, mesh, "animFile", anims[i % 3]);
+		JsonHelper::AddFloat(alloc, mesh, "animTime", writer.Random(0.0f, 1.0f));
+		writer.AddComponent(actor, "SkeletalMeshComponent", mesh);
+		actors.PushBack(actor, alloc);
+	}
+	doc.AddMember("actors", actors, alloc);
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> jsonWriter(buffer);
+	doc.Accept(jsonWriter);
+
+	std::ofstream outFile(fileName);
+	if (!outFile.is_open())
+	{
+		SDL_Log("Failed to write level %s", fileName.c_str());
+		return false;
+	}
+	outFile << buffer.GetString();
+	SDL_Log("Wrote %s (%d movers, %d boxes, %d lights, %d skeletal meshes)",
+		fileName.c_str(), params.mMovers, params.mBoxes, params.mLights,
+		params.mSkeletalMeshes);
+	return true;
+}
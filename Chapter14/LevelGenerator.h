@@ -0,0 +1,35 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+
+// How many of each kind of actor to generate
+struct LevelGenParams
+{
+	// Spheres driven by a MoveComponent
+	int mMovers = 1000;
+	// Static cubes with a BoxComponent (fills the physics world)
+	int mBoxes = 1000;
+	// Point lights
+	int mLights = 100;
+	// Animated skeletal meshes
+	int mSkeletalMeshes = 100;
+	// Everything's scattered over a square this wide
+	float mWorldSize = 10000.0f;
+	unsigned int mSeed = 1;
+};
+
+// Writes synthetic levels for stress testing, in the same format
+// LevelLoader reads (run with: Game -genlevel file [-movers N]
+// [-boxes N] [-lights N] [-skeletal N] [-seed N])
+class LevelGenerator
+{
+public:
+	static bool Generate(const std::string& fileName, const LevelGenParams& params);
+};
@@ -12,6 +12,7 @@
 #include <SDL/SDL.h>
 #include "Game.h"
 #include "Renderer.h"
+#include "PoseCache.h"
 #include "Actor.h"
 #include "BallActor.h"
 #include "FollowActor.h"
@@ -32,6 +33,7 @@
 #include "TargetComponent.h"
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
+#include "Profiler.h"
 
 const int LevelVersion = 1;
 
@@ -63,6 +65,7 @@ std::unordered_map<std::string, std::pair<int, ComponentFunc>> LevelLoader::sCom
 
 bool LevelLoader::LoadLevel(Game* game, const std::string& fileName)
 {
+	PROFILE_SCOPE_DETAIL("LevelLoader::LoadLevel", fileName.c_str());
 	rapidjson::Document doc;
 	if (!LoadJSON(fileName, doc))
 	{
@@ -89,11 +92,53 @@ bool LevelLoader::LoadLevel(Game* game, const std::string& fileName)
 	const rapidjson::Value& actors = doc["actors"];
 	if (actors.IsArray())
 	{
+		PreloadAssets(game, actors);
 		LoadActors(game, actors);
 	}
 	return true;
 }
 
+void LevelLoader::PreloadAssets(Game* game, const rapidjson::Value& inArray)
+{
+	Renderer* renderer = game->GetRenderer();
+	for (rapidjson::SizeType i = 0; i < inArray.Size(); i++)
+	{
+		const rapidjson::Value& actorObj = inArray[i];
+		if (!actorObj.IsObject() || !actorObj.HasMember("components") ||
+			!actorObj["components"].IsArray())
+		{
+			continue;
+		}
+		const rapidjson::Value& components = actorObj["components"];
+		for (rapidjson::SizeType j = 0; j < components.Size(); j++)
+		{
+			const rapidjson::Value& compObj = components[j];
+			if (!compObj.IsObject() || !compObj.HasMember("properties"))
+			{
+				continue;
+			}
+			const rapidjson::Value& props = compObj["properties"];
+			std::string file;
+			if (JsonHelper::GetString(props, "meshFile", file))
+			{
+				renderer->GetMeshAsync(file);
+			}
+			if (JsonHelper::GetString(props, "textureFile", file))
+			{
+				renderer->GetTextureAsync(file);
+			}
+			if (JsonHelper::GetString(props, "skelFile", file))
+			{
+				game->PreloadSkeleton(file);
+			}
+			if (JsonHelper::GetString(props, "animFile", file))
+			{
+				game->PreloadAnimation(file);
+			}
+		}
+	}
+}
+
 bool LevelLoader::LoadJSON(const std::string& fileName, rapidjson::Document& outDoc)
 {
 	// Load the file from disk into an ifstream in binary mode,
@@ -179,6 +224,13 @@ void LevelLoader::LoadGlobalProperties(Game* game, const rapidjson::Value& inObj
 		JsonHelper::GetVector3(dirObj, "direction", light.mDirection);
 		JsonHelper::GetVector3(dirObj, "color", light.mDiffuseColor);
 	}
+
+	// Pose cache time tolerance (0 turns it off)
+	float poseTolerance = 0.0f;
+	if (JsonHelper::GetFloat(inObject, "poseCacheTolerance", poseTolerance))
+	{
+		game->GetPoseCache()->SetTolerance(poseTolerance);
+	}
 }
 
 void LevelLoader::LoadActors(Game* game, const rapidjson::Value& inArray)
@@ -270,6 +322,9 @@ void LevelLoader::SaveGlobalProperties(rapidjson::Document::AllocatorType& alloc
 	JsonHelper::AddVector3(alloc, dirObj, "direction", dirLight.mDirection);
 	JsonHelper::AddVector3(alloc, dirObj, "color", dirLight.mDiffuseColor);
 	inObject.AddMember("directionalLight", dirObj, alloc);
+
+	JsonHelper::AddFloat(alloc, inObject, "poseCacheTolerance",
+		game->GetPoseCache()->GetTolerance());
 }
 
 void LevelLoader::SaveActors(rapidjson::Document::AllocatorType& alloc, 
@@ -30,6 +30,9 @@ public:
 protected:
 	// Helper to load global properties
 	static void LoadGlobalProperties(class Game* game, const rapidjson::Value& inObject);
+	// Starts loading every asset the actors use in the background, so
+	// the file reads overlap each other and making the actors
+	static void PreloadAssets(class Game* game, const rapidjson::Value& inArray);
 	// Helper to load in actors
 	static void LoadActors(class Game* game, const rapidjson::Value& inArray);
 	// Helper to load in components
@@ -0,0 +1,282 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "LightClusters.h"
+#include "JobSystem.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTS_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Waking the workers isn't worth it for a few lights
+	const size_t MinLightsForThreads = 256;
+
+	// The sphere's view space box projects furthest out on screen at
+	// its near depth if that edge is on the outward side of the view
+	// direction, and at its far depth if not
+	float ProjectMin(float edge, float nearZ, float farZ)
+	{
+		return edge / (edge < 0.0f ? nearZ : farZ);
+	}
+
+	float ProjectMax(float edge, float nearZ, float farZ)
+	{
+		return edge / (edge > 0.0f ? nearZ : farZ);
+	}
+
+	// From [-1, 1] on screen to a tile in [0, num - 1]
+	int32_t ToTile(float ndc, int num)
+	{
+		float tile = (ndc * 0.5f + 0.5f) * num;
+		return static_cast<int32_t>(Math::Clamp(tile, 0.0f, num - 1.0f));
+	}
+
+#ifdef LIGHTS_SIMD_SSE
+	__m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	__m128 ProjectMin(__m128 edge, __m128 nearZ, __m128 farZ)
+	{
+		__m128 outward = _mm_cmplt_ps(edge, _mm_setzero_ps());
+		return _mm_div_ps(edge, Select(outward, nearZ, farZ));
+	}
+
+	__m128 ProjectMax(__m128 edge, __m128 nearZ, __m128 farZ)
+	{
+		__m128 outward = _mm_cmpgt_ps(edge, _mm_setzero_ps());
+		return _mm_div_ps(edge, Select(outward, nearZ, farZ));
+	}
+
+	__m128i ToTile(__m128 ndc, int num)
+	{
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 tile = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndc, half), half),
+			_mm_set1_ps(static_cast<float>(num)));
+		tile = _mm_min_ps(_mm_max_ps(tile, _mm_setzero_ps()),
+			_mm_set1_ps(num - 1.0f));
+		// (Truncating is the same as floor, since it's not negative)
+		return _mm_cvttps_epi32(tile);
+	}
+#endif
+}
+
+// (Math::Min/Max take references, so these need definitions)
+const int LightClusters::NumX;
+const int LightClusters::NumY;
+const int LightClusters::NumZ;
+const int LightClusters::NumClusters;
+
+LightClusters::LightClusters()
+	:mNumLights(0)
+	,mNumVisible(0)
+	,mMaxIndices(SIZE_MAX)
+	,mSliceScale(0.0f)
+	,mSliceBias(0.0f)
+{
+}
+
+void LightClusters::Build(const Matrix4& view, const Matrix4& proj, float nearPlane, float farPlane,
+	const float* centerX, const float* centerY, const float* centerZ,
+	const float* radius, size_t count, JobSystem* jobs)
+{
+	// Slices are evenly spaced in log(depth), so near slices are thin
+	float logRatio = std::log(farPlane / nearPlane);
+	mSliceScale = NumZ / logRatio;
+	mSliceBias = -NumZ * std::log(nearPlane) / logRatio;
+
+	mNumLights = count;
+	ComputeBounds(view, proj, nearPlane, farPlane, centerX, centerY, centerZ, radius, count);
+	mNumVisible = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		mNumVisible += mMinZ[i] <= mMaxZ[i] ? 1 : 0;
+	}
+
+	// Count the lights in each cluster, so each cluster's list
+	// can go right after the one before it
+	mCounts.assign(NumClusters, 0);
+	RunSlices(false, jobs);
+	mGrid.resize(NumClusters * 2);
+	size_t offset = 0;
+	for (int c = 0; c < NumClusters; c++)
+	{
+		size_t clusterCount = mCounts[c];
+		if (offset + clusterCount > mMaxIndices)
+		{
+			clusterCount = mMaxIndices - offset;
+		}
+		mGrid[c * 2] = static_cast<uint32_t>(offset);
+		mGrid[c * 2 + 1] = static_cast<uint32_t>(clusterCount);
+		offset += clusterCount;
+		mCounts[c] = 0;
+	}
+
+	// Then write them (in light order, whatever the number of threads)
+	mIndices.resize(offset);
+	RunSlices(true, jobs);
+}
+
+void LightClusters::ComputeBounds(const Matrix4& view, const Matrix4& proj,
+	float nearPlane, float farPlane, const float* centerX, const float* centerY,
+	const float* centerZ, const float* radius, size_t count)
+{
+	mMinX.resize(count);
+	mMaxX.resize(count);
+	mMinY.resize(count);
+	mMaxY.resize(count);
+	mMinZ.resize(count);
+	mMaxZ.resize(count);
+	mNearZ.resize(count);
+	mFarZ.resize(count);
+
+	// CreatePerspectiveFOV puts view depth in w, so the point's
+	// position on screen is x * xScale / z
+	float xScale = proj.mat[0][0];
+	float yScale = proj.mat[1][1];
+	size_t i = 0;
+#ifdef LIGHTS_SIMD_SSE
+	// Four lights at a time
+	__m128 nearV = _mm_set1_ps(nearPlane);
+	__m128 farV = _mm_set1_ps(farPlane);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 negOne = _mm_set1_ps(-1.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(centerX + i);
+		__m128 y = _mm_loadu_ps(centerY + i);
+		__m128 z = _mm_loadu_ps(centerZ + i);
+		__m128 r = _mm_loadu_ps(radius + i);
+		// Points are row vectors (v * M), so view space
+		// x/y/z are dot products with the columns of view
+		__m128 v[3];
+		for (int c = 0; c < 3; c++)
+		{
+			v[c] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view.mat[0][c])),
+					_mm_mul_ps(y, _mm_set1_ps(view.mat[1][c]))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view.mat[2][c])),
+					_mm_set1_ps(view.mat[3][c])));
+		}
+
+		__m128 nearZ = _mm_max_ps(_mm_sub_ps(v[2], r), nearV);
+		__m128 farZ = _mm_min_ps(_mm_add_ps(v[2], r), farV);
+		// (Keeps the divides sane for lights behind the camera)
+		__m128 farDiv = _mm_max_ps(farZ, nearV);
+		__m128 minX = _mm_mul_ps(ProjectMin(_mm_sub_ps(v[0], r), nearZ, farDiv),
+			_mm_set1_ps(xScale));
+		__m128 maxX = _mm_mul_ps(ProjectMax(_mm_add_ps(v[0], r), nearZ, farDiv),
+			_mm_set1_ps(xScale));
+		__m128 minY = _mm_mul_ps(ProjectMin(_mm_sub_ps(v[1], r), nearZ, farDiv),
+			_mm_set1_ps(yScale));
+		__m128 maxY = _mm_mul_ps(ProjectMax(_mm_add_ps(v[1], r), nearZ, farDiv),
+			_mm_set1_ps(yScale));
+
+		// Visible if it's between the near and far planes and overlaps the screen
+		__m128 visible = _mm_and_ps(
+			_mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(v[2], r), nearV),
+				_mm_cmplt_ps(_mm_sub_ps(v[2], r), farV)),
+			_mm_and_ps(
+				_mm_and_ps(_mm_cmple_ps(minX, one), _mm_cmpge_ps(maxX, negOne)),
+				_mm_and_ps(_mm_cmple_ps(minY, one), _mm_cmpge_ps(maxY, negOne))));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&mMinX[i]), ToTile(minX, NumX));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&mMaxX[i]), ToTile(maxX, NumX));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&mMinY[i]), ToTile(minY, NumY));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&mMaxY[i]), ToTile(maxY, NumY));
+		_mm_storeu_ps(&mNearZ[i], nearZ);
+		// A far depth of 0 (before the near plane) marks it as not visible
+		_mm_storeu_ps(&mFarZ[i], _mm_and_ps(visible, farZ));
+	}
+#endif
+	// Anything left over (or everything, without SSE)
+	for (; i < count; i++)
+	{
+		Vector3 v = Vector3::Transform(Vector3(centerX[i], centerY[i], centerZ[i]), view);
+		float r = radius[i];
+		float nearZ = Math::Max(v.z - r, nearPlane);
+		float farZ = Math::Min(v.z + r, farPlane);
+		float farDiv = Math::Max(farZ, nearPlane);
+		float minX = ProjectMin(v.x - r, nearZ, farDiv) * xScale;
+		float maxX = ProjectMax(v.x + r, nearZ, farDiv) * xScale;
+		float minY = ProjectMin(v.y - r, nearZ, farDiv) * yScale;
+		float maxY = ProjectMax(v.y + r, nearZ, farDiv) * yScale;
+		bool visible = v.z + r > nearPlane && v.z - r < farPlane &&
+			minX <= 1.0f && maxX >= -1.0f && minY <= 1.0f && maxY >= -1.0f;
+		mMinX[i] = ToTile(minX, NumX);
+		mMaxX[i] = ToTile(maxX, NumX);
+		mMinY[i] = ToTile(minY, NumY);
+		mMaxY[i] = ToTile(maxY, NumY);
+		mNearZ[i] = nearZ;
+		mFarZ[i] = visible ? farZ : 0.0f;
+	}
+
+	// Depth slices (there's no SSE log, so these are one at a time)
+	for (i = 0; i < count; i++)
+	{
+		if (mFarZ[i] < mNearZ[i])
+		{
+			mMinZ[i] = 1;
+			mMaxZ[i] = 0;
+			continue;
+		}
+		float minZ = std::floor(std::log(mNearZ[i]) * mSliceScale + mSliceBias);
+		float maxZ = std::floor(std::log(mFarZ[i]) * mSliceScale + mSliceBias);
+		mMinZ[i] = static_cast<int32_t>(Math::Clamp(minZ, 0.0f, NumZ - 1.0f));
+		mMaxZ[i] = static_cast<int32_t>(Math::Clamp(maxZ, 0.0f, NumZ - 1.0f));
+	}
+}
+
+void LightClusters::RunSlices(bool write, JobSystem* jobs)
+{
+	if (jobs == nullptr || mNumLights < MinLightsForThreads)
+	{
+		BinSlices(0, NumZ, write);
+		return;
+	}
+
+	// Each range of slices has its own clusters, so ranges
+	// never touch the same count or index
+	jobs->ParallelFor(NumZ, 1, [this, write](size_t begin, size_t end)
+	{
+		BinSlices(static_cast<int>(begin), static_cast<int>(end), write);
+	});
+}
+
+void LightClusters::BinSlices(int firstSlice, int endSlice, bool write)
+{
+	for (size_t i = 0; i < mNumLights; i++)
+	{
+		int minZ = Math::Max(mMinZ[i], firstSlice);
+		int maxZ = Math::Min(mMaxZ[i], endSlice - 1);
+		for (int z = minZ; z <= maxZ; z++)
+		{
+			for (int y = mMinY[i]; y <= mMaxY[i]; y++)
+			{
+				int cluster = (z * NumY + y) * NumX;
+				for (int x = mMinX[i]; x <= mMaxX[i]; x++)
+				{
+					uint32_t& count = mCounts[cluster + x];
+					if (!write)
+					{
+						count++;
+					}
+					else if (count < mGrid[(cluster + x) * 2 + 1])
+					{
+						mIndices[mGrid[(cluster + x) * 2] + count] = static_cast<uint32_t>(i);
+						count++;
+					}
+				}
+			}
+		}
+	}
+}
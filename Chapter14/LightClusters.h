@@ -0,0 +1,83 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Math.h"
+
+// Splits the view frustum into a grid of clusters (tiles on screen,
+// and slices in depth that get thicker further away) and lists the
+// point lights that reach each cluster. The G-buffer lighting pass
+// then only has to loop over the lights in its pixel's cluster.
+class LightClusters
+{
+public:
+	// Size of the grid (these have to match GBufferGlobal.frag)
+	static const int NumX = 16;
+	static const int NumY = 9;
+	static const int NumZ = 24;
+	static const int NumClusters = NumX * NumY * NumZ;
+
+	LightClusters();
+
+	// Light bounding spheres (in world space) are stored as separate
+	// arrays for each component, so four can be binned at once with SSE.
+	// nearPlane/farPlane have to be the planes proj was made with.
+	// With jobs, the binning is split over its workers (by depth slices).
+	void Build(const Matrix4& view, const Matrix4& proj, float nearPlane, float farPlane,
+		const float* centerX, const float* centerY, const float* centerZ,
+		const float* radius, size_t count, class JobSystem* jobs = nullptr);
+
+	// Offset into the indices and number of lights, for each cluster
+	// (cluster (x, y, z) is (z * NumY + y) * NumX + x, with y = 0 at
+	// the bottom of the screen)
+	const std::vector<uint32_t>& GetGrid() const { return mGrid; }
+	// The light indices of every cluster, one after the other
+	const std::vector<uint32_t>& GetIndices() const { return mIndices; }
+	// Lights that were in at least one cluster
+	size_t GetNumVisible() const { return mNumVisible; }
+
+	// Depth slice of view depth z is floor(log(z) * scale + bias)
+	float GetSliceScale() const { return mSliceScale; }
+	float GetSliceBias() const { return mSliceBias; }
+
+	// Caps the light indices (lights past it are left out of clusters)
+	void SetMaxIndices(size_t maxIndices) { mMaxIndices = maxIndices; }
+private:
+	// Find the range of clusters each light touches
+	void ComputeBounds(const Matrix4& view, const Matrix4& proj, float nearPlane, float farPlane,
+		const float* centerX, const float* centerY, const float* centerZ,
+		const float* radius, size_t count);
+	// Count (or write, once the offsets are known) the lights in
+	// every slice, split over the job system's workers
+	void RunSlices(bool write, class JobSystem* jobs);
+	// Same for just slices [firstSlice, endSlice)
+	void BinSlices(int firstSlice, int endSlice, bool write);
+
+	// Cluster range of each light (min > max if it's not visible)
+	std::vector<int32_t> mMinX;
+	std::vector<int32_t> mMaxX;
+	std::vector<int32_t> mMinY;
+	std::vector<int32_t> mMaxY;
+	std::vector<int32_t> mMinZ;
+	std::vector<int32_t> mMaxZ;
+	// View depth range of each light, clamped to the near/far planes
+	std::vector<float> mNearZ;
+	std::vector<float> mFarZ;
+	// Lights counted (then written) into each cluster so far
+	std::vector<uint32_t> mCounts;
+	std::vector<uint32_t> mGrid;
+	std::vector<uint32_t> mIndices;
+	size_t mNumLights;
+	size_t mNumVisible;
+	size_t mMaxIndices;
+	float mSliceScale;
+	float mSliceBias;
+};
@@ -7,14 +7,145 @@
 // ----------------------------------------------------------------
 
 #include "Game.h"
+#include "AssetBaker.h"
+#include "AtlasPacker.h"
+#include "FrameScheduler.h"
+#include "LevelGenerator.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include <cstdlib>
+#include <string>
 
 int main(int argc, char** argv)
 {
+	// Convert source assets to their binary formats and exit
+	if (argc > 1 && std::string(argv[1]) == "-bake")
+	{
+		std::string dir = "Assets";
+		bool compress = false;
+		for (int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "-compress")
+			{
+				compress = true;
+			}
+			else
+			{
+				dir = arg;
+			}
+		}
+		return AssetBaker::BakeDirectory(dir, compress) ? 0 : 1;
+	}
+
+	// Pack the UI images into an atlas and exit
+	if (argc > 1 && std::string(argv[1]) == "-atlas")
+	{
+		std::string dir = argc > 2 ? argv[2] : "Assets";
+		return AtlasPacker::PackUI(dir) ? 0 : 1;
+	}
+
+	// Write a synthetic level for stress testing and exit
+	if (argc > 2 && std::string(argv[1]) == "-genlevel")
+	{
+		LevelGenParams params;
+		for (int i = 3; i + 1 < argc; i++)
+		{
+			std::string arg = argv[i];
+			int value = std::atoi(argv[i + 1]);
+			if (arg == "-movers")
+			{
+				params.mMovers = value;
+			}
+			else if (arg == "-boxes")
+			{
+				params.mBoxes = value;
+			}
+			else if (arg == "-lights")
+			{
+				params.mLights = value;
+			}
+			else if (arg == "-skeletal")
+			{
+				params.mSkeletalMeshes = value;
+			}
+			else if (arg == "-seed")
+			{
+				params.mSeed = static_cast<unsigned int>(value);
+			}
+		}
+		return LevelGenerator::Generate(argv[2], params) ? 0 : 1;
+	}
+
+	// -headless [level] runs without a window or audio for
+	// -frames N frames, then prints timings as JSON
+	bool headless = false;
+	int headlessFrames = 1000;
 	Game game;
-	bool success = game.Initialize();
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-headless")
+		{
+			headless = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				game.SetLevelFile(argv[i + 1]);
+			}
+		}
+		else if (arg == "-frames" && i + 1 < argc)
+		{
+			headlessFrames = std::atoi(argv[i + 1]);
+		}
+	}
+
+	bool success = game.Initialize(headless);
 	if (success)
 	{
-		game.RunLoop();
+		// -perlight draws a sphere per point light instead of
+		// the clustered lighting (to compare the two)
+		// -fullgbuffer uses three RGB32F G-buffer targets instead
+		// of the compact layout
+		for (int i = 1; i < argc; i++)
+		{
+			if (std::string(argv[i]) == "-perlight")
+			{
+				game.GetRenderer()->SetClusteredLights(false);
+			}
+			else if (std::string(argv[i]) == "-fullgbuffer")
+			{
+				game.GetRenderer()->SetCompactGBuffer(false);
+			}
+		}
+
+		// -fps N caps the frame rate (0 is uncapped)
+		// -simrate N runs the simulation at N steps per second
+		// -profile N captures the first N frames to profile.json
+		for (int i = 1; i + 1 < argc; i++)
+		{
+			std::string arg = argv[i];
+			float value = static_cast<float>(std::atof(argv[i + 1]));
+			if (arg == "-fps")
+			{
+				game.GetFrameScheduler()->SetTargetFPS(value);
+			}
+			else if (arg == "-simrate" && value > 0.0f)
+			{
+				game.GetFrameScheduler()->SetFixedStep(1.0f / value);
+			}
+			else if (arg == "-profile")
+			{
+				Profiler::Get().StartCapture(static_cast<int>(value), "profile.json");
+			}
+		}
+		if (headless)
+		{
+			game.RunHeadless(headlessFrames);
+		}
+		else
+		{
+			game.RunLoop();
+		}
 	}
 	game.Shutdown();
 	return 0;
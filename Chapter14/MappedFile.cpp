@@ -0,0 +1,125 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	:mData(nullptr)
+	,mSize(0)
+#ifdef _WIN32
+	,mFile(INVALID_HANDLE_VALUE)
+	,mMapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+	mFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	mData = static_cast<const unsigned char*>(
+		MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr)
+	{
+		Close();
+		return false;
+	}
+	mSize = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+	}
+	mData = nullptr;
+	mSize = 0;
+	mMapping = nullptr;
+	mFile = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+		MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the file is closed
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	mData = static_cast<const unsigned char*>(data);
+	mSize = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData)
+	{
+		munmap(const_cast<unsigned char*>(mData), mSize);
+	}
+	mData = nullptr;
+	mSize = 0;
+}
+#endif
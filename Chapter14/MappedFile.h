@@ -0,0 +1,37 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <cstddef>
+
+// A read-only file mapped into memory, so binary assets can be
+// used straight from the OS page cache without reading them into
+// a separate buffer first
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Returns false if the file doesn't exist or can't be mapped
+	bool Open(const std::string& fileName);
+	void Close();
+
+	const unsigned char* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+private:
+	const unsigned char* mData;
+	size_t mSize;
+#ifdef _WIN32
+	void* mFile;
+	void* mMapping;
+#endif
+};
@@ -53,19 +53,82 @@ Vector2 Vector2::Transform(const Vector2& vec, const Matrix3& mat, float w /*= 1
 	return retVal;
 }
 
+#if defined(MATH_SIMD_SSE)
+namespace
+{
+	// vec * mat for a vector already split into x, y, z, w registers
+	inline __m128 TransformSSE(__m128 x, __m128 y, __m128 z, __m128 w,
+		const __m128 rows[4])
+	{
+		return _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(x, rows[0]), _mm_mul_ps(y, rows[1])),
+			_mm_add_ps(_mm_mul_ps(z, rows[2]), _mm_mul_ps(w, rows[3])));
+	}
+
+	// a x b (the w of the result is 0)
+	inline __m128 CrossSSE(__m128 a, __m128 b)
+	{
+		__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	inline void LoadRows(const Matrix4& mat, __m128 rows[4])
+	{
+		rows[0] = _mm_loadu_ps(mat.mat[0]);
+		rows[1] = _mm_loadu_ps(mat.mat[1]);
+		rows[2] = _mm_loadu_ps(mat.mat[2]);
+		rows[3] = _mm_loadu_ps(mat.mat[3]);
+	}
+}
+#endif
+
 Vector3 Vector3::Transform(const Vector3& vec, const Matrix4& mat, float w /*= 1.0f*/)
 {
 	Vector3 retVal;
+#if defined(MATH_SIMD_SSE)
+	__m128 rows[4];
+	LoadRows(mat, rows);
+	alignas(16) float result[4];
+	_mm_store_ps(result, TransformSSE(_mm_set1_ps(vec.x), _mm_set1_ps(vec.y),
+		_mm_set1_ps(vec.z), _mm_set1_ps(w), rows));
+	retVal.Set(result[0], result[1], result[2]);
+#else
 	retVal.x = vec.x * mat.mat[0][0] + vec.y * mat.mat[1][0] +
 		vec.z * mat.mat[2][0] + w * mat.mat[3][0];
 	retVal.y = vec.x * mat.mat[0][1] + vec.y * mat.mat[1][1] +
 		vec.z * mat.mat[2][1] + w * mat.mat[3][1];
 	retVal.z = vec.x * mat.mat[0][2] + vec.y * mat.mat[1][2] +
 		vec.z * mat.mat[2][2] + w * mat.mat[3][2];
+#endif
 	//ignore w since we aren't returning a new value for it...
 	return retVal;
 }
 
+void Vector3::TransformArray(const Vector3* in, Vector3* out, size_t count,
+	const Matrix4& mat, float w /*= 1.0f*/)
+{
+#if defined(MATH_SIMD_SSE)
+	// The rows only need to be loaded once
+	__m128 rows[4];
+	LoadRows(mat, rows);
+	__m128 wv = _mm_set1_ps(w);
+	alignas(16) float result[4];
+	for (size_t i = 0; i < count; i++)
+	{
+		_mm_store_ps(result, TransformSSE(_mm_set1_ps(in[i].x), _mm_set1_ps(in[i].y),
+			_mm_set1_ps(in[i].z), wv, rows));
+		out[i].Set(result[0], result[1], result[2]);
+	}
+#else
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = Transform(in[i], mat, w);
+	}
+#endif
+}
+
 // This will transform the vector and renormalize the w component
 Vector3 Vector3::TransformWithPerspDiv(const Vector3& vec, const Matrix4& mat, float w /*= 1.0f*/)
 {
@@ -96,8 +159,89 @@ Vector3 Vector3::Transform(const Vector3& v, const Quaternion& q)
 	return retVal;
 }
 
+#if defined(MATH_SIMD_SSE)
+// Shuffles for the 2x2 sub-matrices packed into one register
+// as (m00, m01, m10, m11)
+#define MATH_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define MATH_SWIZZLE(a, x, y, z, w) MATH_SHUFFLE(a, a, x, y, z, w)
+
+namespace
+{
+	// a * b
+	inline __m128 Mat2Mul(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, MATH_SWIZZLE(b, 0, 3, 0, 3)),
+			_mm_mul_ps(MATH_SWIZZLE(a, 1, 0, 3, 2), MATH_SWIZZLE(b, 2, 1, 2, 1)));
+	}
+
+	// adjugate(a) * b
+	inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(MATH_SWIZZLE(a, 3, 3, 0, 0), b),
+			_mm_mul_ps(MATH_SWIZZLE(a, 1, 1, 2, 2), MATH_SWIZZLE(b, 2, 3, 0, 1)));
+	}
+
+	// a * adjugate(b)
+	inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, MATH_SWIZZLE(b, 3, 0, 3, 0)),
+			_mm_mul_ps(MATH_SWIZZLE(a, 1, 0, 3, 2), MATH_SWIZZLE(b, 2, 1, 2, 1)));
+	}
+}
+#endif
+
 void Matrix4::Invert()
 {
+#if defined(MATH_SIMD_SSE)
+	// Block-wise inverse, treating the matrix as four 2x2 matrices
+	// | A B |
+	// | C D |
+	__m128 rows[4];
+	LoadRows(*this, rows);
+	__m128 A = _mm_movelh_ps(rows[0], rows[1]);
+	__m128 B = _mm_movehl_ps(rows[1], rows[0]);
+	__m128 C = _mm_movelh_ps(rows[2], rows[3]);
+	__m128 D = _mm_movehl_ps(rows[3], rows[2]);
+
+	// Determinants of the sub-matrices as (|A|, |B|, |C|, |D|)
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(MATH_SHUFFLE(rows[0], rows[2], 0, 2, 0, 2),
+			MATH_SHUFFLE(rows[1], rows[3], 1, 3, 1, 3)),
+		_mm_mul_ps(MATH_SHUFFLE(rows[0], rows[2], 1, 3, 1, 3),
+			MATH_SHUFFLE(rows[1], rows[3], 0, 2, 0, 2)));
+	__m128 detA = MATH_SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = MATH_SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = MATH_SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = MATH_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	__m128 DC = Mat2AdjMul(D, C);
+	__m128 AB = Mat2AdjMul(A, B);
+	// Adjugates of each block of the inverse
+	__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+	__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+	__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+	__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+	// |M| = |A||D| + |B||C| - trace(adj(A)B adj(D)C)
+	__m128 det = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	__m128 tr = _mm_mul_ps(AB, MATH_SWIZZLE(DC, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, MATH_SWIZZLE(tr, 1, 0, 3, 2));
+	tr = _mm_add_ps(tr, MATH_SWIZZLE(tr, 2, 3, 0, 1));
+	det = _mm_sub_ps(det, tr);
+
+	// Signs of the adjugate, divided by the determinant
+	__m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	X = _mm_mul_ps(X, invDet);
+	Y = _mm_mul_ps(Y, invDet);
+	Z = _mm_mul_ps(Z, invDet);
+	W = _mm_mul_ps(W, invDet);
+
+	// Take the adjugate of each block while putting them back
+	_mm_storeu_ps(mat[0], MATH_SHUFFLE(X, Y, 3, 1, 3, 1));
+	_mm_storeu_ps(mat[1], MATH_SHUFFLE(X, Y, 2, 0, 2, 0));
+	_mm_storeu_ps(mat[2], MATH_SHUFFLE(Z, W, 3, 1, 3, 1));
+	_mm_storeu_ps(mat[3], MATH_SHUFFLE(Z, W, 2, 0, 2, 0));
+#else
 	// Thanks slow math
 	// This is a really janky way to unroll everything...
 	float tmp[12];
@@ -209,6 +353,96 @@ void Matrix4::Invert()
 			mat[i][j] = dst[i * 4 + j];
 		}
 	}
+#endif
+}
+
+void Matrix4::InvertAffine()
+{
+	// The upper 3x3 inverts on its own: for rows a, b, c the
+	// columns of the inverse are (b x c, c x a, a x b) / det.
+	// The translation is then -t times that inverse.
+#if defined(MATH_SIMD_SSE)
+	__m128 rows[4];
+	LoadRows(*this, rows);
+	__m128 bc = CrossSSE(rows[1], rows[2]);
+	__m128 ca = CrossSSE(rows[2], rows[0]);
+	__m128 ab = CrossSSE(rows[0], rows[1]);
+	// (w of each cross product is 0, so this is a 3D dot product)
+	__m128 det = _mm_mul_ps(rows[0], bc);
+	det = _mm_add_ps(det, MATH_SWIZZLE(det, 1, 0, 3, 2));
+	det = _mm_add_ps(det, MATH_SWIZZLE(det, 2, 3, 0, 1));
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	bc = _mm_mul_ps(bc, invDet);
+	ca = _mm_mul_ps(ca, invDet);
+	ab = _mm_mul_ps(ab, invDet);
+	__m128 zero = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(bc, ca, ab, zero);
+
+	__m128 t = rows[3];
+	__m128 trans = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(MATH_SWIZZLE(t, 0, 0, 0, 0), bc),
+			_mm_mul_ps(MATH_SWIZZLE(t, 1, 1, 1, 1), ca)),
+		_mm_mul_ps(MATH_SWIZZLE(t, 2, 2, 2, 2), ab));
+	_mm_storeu_ps(mat[0], bc);
+	_mm_storeu_ps(mat[1], ca);
+	_mm_storeu_ps(mat[2], ab);
+	_mm_storeu_ps(mat[3], _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), trans));
+#else
+	Vector3 a(mat[0][0], mat[0][1], mat[0][2]);
+	Vector3 b(mat[1][0], mat[1][1], mat[1][2]);
+	Vector3 c(mat[2][0], mat[2][1], mat[2][2]);
+	Vector3 t(mat[3][0], mat[3][1], mat[3][2]);
+	Vector3 bc = Vector3::Cross(b, c);
+	float invDet = 1.0f / Vector3::Dot(a, bc);
+	bc *= invDet;
+	Vector3 ca = Vector3::Cross(c, a) * invDet;
+	Vector3 ab = Vector3::Cross(a, b) * invDet;
+
+	mat[0][0] = bc.x; mat[0][1] = ca.x; mat[0][2] = ab.x; mat[0][3] = 0.0f;
+	mat[1][0] = bc.y; mat[1][1] = ca.y; mat[1][2] = ab.y; mat[1][3] = 0.0f;
+	mat[2][0] = bc.z; mat[2][1] = ca.z; mat[2][2] = ab.z; mat[2][3] = 0.0f;
+	mat[3][0] = -Vector3::Dot(t, bc);
+	mat[3][1] = -Vector3::Dot(t, ca);
+	mat[3][2] = -Vector3::Dot(t, ab);
+	mat[3][3] = 1.0f;
+#endif
+}
+
+void Matrix4::MultiplyArray(const Matrix4* a, const Matrix4* b,
+	Matrix4* out, size_t count)
+{
+#if defined(MATH_SIMD_AVX)
+	// Same as operator*, but the rows are stored straight to out
+	// instead of going through a temporary
+	for (size_t i = 0; i < count; i++)
+	{
+		const float (*am)[4] = a[i].mat;
+		const float (*bm)[4] = b[i].mat;
+		float (*outm)[4] = out[i].mat;
+		// Each 128-bit lane does one row of a
+		__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(bm[0]));
+		__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(bm[1]));
+		__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(bm[2]));
+		__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(bm[3]));
+		__m256 rows01 = _mm256_loadu_ps(am[0]);
+		__m256 rows23 = _mm256_loadu_ps(am[2]);
+		__m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0x00), b0);
+		__m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0x00), b0);
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0x55), b1));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0x55), b1));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0xAA), b2));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0xAA), b2));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0xFF), b3));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0xFF), b3));
+		_mm256_storeu_ps(outm[0], r01);
+		_mm256_storeu_ps(outm[2], r23);
+	}
+#else
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = a[i] * b[i];
+	}
+#endif
 }
 
 Matrix4 Matrix4::CreateFromQuaternion(const class Quaternion& q)
@@ -11,6 +11,23 @@
 #include <cmath>
 #include <memory.h>
 #include <limits>
+#include <cstddef>
+
+// Pick the widest SIMD the compiler is targeting for the Matrix4,
+// Vector3 and Quaternion kernels (define MATH_NO_SIMD to force the
+// scalar code). AVX only widens Matrix4 multiplication, everything
+// else uses the SSE code. Matrix4 multiplication has no SSE code, as
+// it was no faster than the scalar code (which compilers vectorize).
+#if !defined(MATH_NO_SIMD)
+#if defined(__AVX__)
+#define MATH_SIMD_AVX
+#define MATH_SIMD_SSE
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_SIMD_SSE
+#include <emmintrin.h>
+#endif
+#endif
 
 namespace Math
 {
@@ -400,6 +417,9 @@ public:
 	}
 
 	static Vector3 Transform(const Vector3& vec, const class Matrix4& mat, float w = 1.0f);
+	// Transform count vectors by the same matrix (in and out can be the same array)
+	static void TransformArray(const Vector3* in, Vector3* out, size_t count,
+		const class Matrix4& mat, float w = 1.0f);
 	// This will transform the vector and renormalize the w component
 	static Vector3 TransformWithPerspDiv(const Vector3& vec, const class Matrix4& mat, float w = 1.0f);
 
@@ -555,7 +575,8 @@ public:
 class Matrix4
 {
 public:
-	float mat[4][4];
+	// (Aligned so each row fits one SSE register)
+	alignas(16) float mat[4][4];
 
 	Matrix4()
 	{
@@ -576,6 +597,30 @@ public:
 	// Matrix multiplication (a * b)
 	friend Matrix4 operator*(const Matrix4& a, const Matrix4& b)
 	{
+#if defined(MATH_SIMD_AVX)
+		// Two rows of the result at once: each 128-bit lane
+		// multiplies one row of a by the rows of b
+		__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.mat[0]));
+		__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.mat[1]));
+		__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.mat[2]));
+		__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.mat[3]));
+		__m256 rows01 = _mm256_loadu_ps(a.mat[0]);
+		__m256 rows23 = _mm256_loadu_ps(a.mat[2]);
+		__m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0x00), b0);
+		__m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0x00), b0);
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0x55), b1));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0x55), b1));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0xAA), b2));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0xAA), b2));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0xFF), b3));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0xFF), b3));
+		// (Written to a local array so the compiler drops the identity
+		// that the default constructor writes)
+		alignas(32) float temp[4][4];
+		_mm256_store_ps(temp[0], r01);
+		_mm256_store_ps(temp[2], r23);
+		return Matrix4(temp);
+#else
 		Matrix4 retVal;
 		// row 0
 		retVal.mat[0][0] = 
@@ -676,8 +721,9 @@ public:
 			a.mat[3][1] * b.mat[1][3] +
 			a.mat[3][2] * b.mat[2][3] +
 			a.mat[3][3] * b.mat[3][3];
-		
+
 		return retVal;
+#endif
 	}
 
 	Matrix4& operator*=(const Matrix4& right)
@@ -686,8 +732,15 @@ public:
 		return *this;
 	}
 
-	// Invert the matrix - super slow
+	// Invert the matrix
 	void Invert();
+	// Faster invert for affine matrices (rotation/scale/translation,
+	// with (0, 0, 0, 1) as the last column) such as view matrices
+	void InvertAffine();
+
+	// out[i] = a[i] * b[i] for count matrices
+	static void MultiplyArray(const Matrix4* a, const Matrix4* b,
+		Matrix4* out, size_t count);
 
 	// Get the translation component of the matrix
 	Vector3 GetTranslation() const
@@ -861,6 +914,7 @@ public:
 	}
 	
 	static const Matrix4 Identity;
+private:
 };
 
 // (Unit) Quaternion
@@ -990,11 +1044,21 @@ public:
 		}
 
 		Quaternion retVal;
+#if defined(MATH_SIMD_SSE)
+		// Blend and normalize all four components at once
+		__m128 blend = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(scale0), _mm_loadu_ps(&a.x)),
+			_mm_mul_ps(_mm_set1_ps(scale1), _mm_loadu_ps(&b.x)));
+		__m128 lenSq = _mm_mul_ps(blend, blend);
+		lenSq = _mm_add_ps(lenSq, _mm_shuffle_ps(lenSq, lenSq, _MM_SHUFFLE(2, 3, 0, 1)));
+		lenSq = _mm_add_ps(lenSq, _mm_shuffle_ps(lenSq, lenSq, _MM_SHUFFLE(1, 0, 3, 2)));
+		_mm_storeu_ps(&retVal.x, _mm_div_ps(blend, _mm_sqrt_ps(lenSq)));
+#else
 		retVal.x = scale0 * a.x + scale1 * b.x;
 		retVal.y = scale0 * a.y + scale1 * b.y;
 		retVal.z = scale0 * a.z + scale1 * b.z;
 		retVal.w = scale0 * a.w + scale1 * b.w;
 		retVal.Normalize();
+#endif
 		return retVal;
 	}
 
@@ -14,7 +14,10 @@
 #include <SDL/SDL_log.h>
 #include "Math.h"
 #include "LevelLoader.h"
+#include "MappedFile.h"
 #include <fstream>
+#include <cstring>
+#include "Profiler.h"
 
 namespace
 {
@@ -24,24 +27,202 @@ namespace
 		uint8_t b[4];
 	};
 
-	const int BinaryVersion = 1;
+	// Version 2 is a fixed size header followed by 16-byte aligned
+	// sections, so the vertices and indices can be handed to OpenGL
+	// straight out of the mapped file:
+	// [header][strings][vertices][indices]
+	// The strings section is the shader name followed by each
+	// texture name, all null-terminated.
+	const uint32_t BinaryVersion = 2;
+	const uint32_t SectionAlignment = 16;
 	struct MeshBinHeader
 	{
 		// Signature for file type
-		char mSignature[4] = { 'G', 'M', 'S', 'H' };
+		char mSignature[4];
 		// Version
-		uint32_t mVersion = BinaryVersion;
+		uint32_t mVersion;
 		// Vertex layout type
-		VertexArray::Layout mLayout = VertexArray::PosNormTex;
+		uint32_t mLayout;
 		// Info about how many of each we have
-		uint32_t mNumTextures = 0;
-		uint32_t mNumVerts = 0;
-		uint32_t mNumIndices = 0;
+		uint32_t mNumTextures;
+		uint32_t mNumVerts;
+		uint32_t mNumIndices;
 		// Box/radius of mesh, used for collision
-		AABB mBox{ Vector3::Zero, Vector3::Zero };
+		float mBoxMin[3];
+		float mBoxMax[3];
+		float mRadius;
+		float mSpecPower;
+		// Byte offsets/sizes of each section from the start of the file
+		uint32_t mStringsOffset;
+		uint32_t mStringsSize;
+		uint32_t mVertsOffset;
+		uint32_t mIndicesOffset;
+		// Total size, to catch truncated files
+		uint32_t mFileSize;
+		uint32_t mPadding;
+	};
+	static_assert(sizeof(MeshBinHeader) == 80, "MeshBinHeader must stay 80 bytes");
+
+	uint32_t AlignSection(uint32_t offset)
+	{
+		return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+
+	// Everything read from a .gpmesh file, before any GL objects
+	// are made (so baking doesn't need a renderer)
+	struct MeshSource
+	{
+		std::string mShaderName;
+		VertexArray::Layout mLayout = VertexArray::PosNormTex;
+		size_t mVertSize = 8;
+		std::vector<Vertex> mVertices;
+		std::vector<uint32_t> mIndices;
+		std::vector<std::string> mTextureNames;
+		AABB mBox{ Vector3::Infinity, Vector3::NegInfinity };
 		float mRadius = 0.0f;
 		float mSpecPower = 100.0f;
+
+		uint32_t GetNumVerts() const
+		{
+			return static_cast<uint32_t>(mVertices.size() / mVertSize);
+		}
 	};
+
+	bool ParseMeshJSON(const std::string& fileName, MeshSource& outMesh)
+	{
+		rapidjson::Document doc;
+		if (!LevelLoader::LoadJSON(fileName, doc))
+		{
+			SDL_Log("Failed to load mesh %s", fileName.c_str());
+			return false;
+		}
+
+		int ver = doc["version"].GetInt();
+
+		// Check the version
+		if (ver != 1)
+		{
+			SDL_Log("Mesh %s not version 1", fileName.c_str());
+			return false;
+		}
+
+		outMesh.mShaderName = doc["shader"].GetString();
+
+		// Set the vertex layout/size based on the format in the file
+		std::string vertexFormat = doc["vertexformat"].GetString();
+		if (vertexFormat == "PosNormSkinTex")
+		{
+			outMesh.mLayout = VertexArray::PosNormSkinTex;
+			// This is the number of "Vertex" unions, which is 8 + 2 (for skinning)s
+			outMesh.mVertSize = 10;
+		}
+
+		// Texture names
+		const rapidjson::Value& textures = doc["textures"];
+		if (!textures.IsArray() || textures.Size() < 1)
+		{
+			SDL_Log("Mesh %s has no textures, there should be at least one", fileName.c_str());
+			return false;
+		}
+
+		outMesh.mSpecPower = static_cast<float>(doc["specularPower"].GetDouble());
+
+		for (rapidjson::SizeType i = 0; i < textures.Size(); i++)
+		{
+			outMesh.mTextureNames.emplace_back(textures[i].GetString());
+		}
+
+		// Load in the vertices
+		const rapidjson::Value& vertsJson = doc["vertices"];
+		if (!vertsJson.IsArray() || vertsJson.Size() < 1)
+		{
+			SDL_Log("Mesh %s has no vertices", fileName.c_str());
+			return false;
+		}
+
+		std::vector<Vertex>& vertices = outMesh.mVertices;
+		vertices.reserve(vertsJson.Size() * outMesh.mVertSize);
+		float radiusSq = 0.0f;
+		for (rapidjson::SizeType i = 0; i < vertsJson.Size(); i++)
+		{
+			// For now, just assume we have 8 elements
+			const rapidjson::Value& vert = vertsJson[i];
+			if (!vert.IsArray())
+			{
+				SDL_Log("Unexpected vertex format for %s", fileName.c_str());
+				return false;
+			}
+
+			Vector3 pos(vert[0].GetDouble(), vert[1].GetDouble(), vert[2].GetDouble());
+			radiusSq = Math::Max(radiusSq, pos.LengthSq());
+			outMesh.mBox.UpdateMinMax(pos);
+
+			if (outMesh.mLayout == VertexArray::PosNormTex)
+			{
+				Vertex v;
+				// Add the floats
+				for (rapidjson::SizeType j = 0; j < vert.Size(); j++)
+				{
+					v.f = static_cast<float>(vert[j].GetDouble());
+					vertices.emplace_back(v);
+				}
+			}
+			else
+			{
+				Vertex v;
+				// Add pos/normal
+				for (rapidjson::SizeType j = 0; j < 6; j++)
+				{
+					v.f = static_cast<float>(vert[j].GetDouble());
+					vertices.emplace_back(v);
+				}
+
+				// Add skin information
+				for (rapidjson::SizeType j = 6; j < 14; j += 4)
+				{
+					v.b[0] = vert[j].GetUint();
+					v.b[1] = vert[j + 1].GetUint();
+					v.b[2] = vert[j + 2].GetUint();
+					v.b[3] = vert[j + 3].GetUint();
+					vertices.emplace_back(v);
+				}
+
+				// Add tex coords
+				for (rapidjson::SizeType j = 14; j < vert.Size(); j++)
+				{
+					v.f = vert[j].GetDouble();
+					vertices.emplace_back(v);
+				}
+			}
+		}
+
+		// We were computing length squared earlier
+		outMesh.mRadius = Math::Sqrt(radiusSq);
+
+		// Load in the indices
+		const rapidjson::Value& indJson = doc["indices"];
+		if (!indJson.IsArray() || indJson.Size() < 1)
+		{
+			SDL_Log("Mesh %s has no indices", fileName.c_str());
+			return false;
+		}
+
+		outMesh.mIndices.reserve(indJson.Size() * 3);
+		for (rapidjson::SizeType i = 0; i < indJson.Size(); i++)
+		{
+			const rapidjson::Value& ind = indJson[i];
+			if (!ind.IsArray() || ind.Size() != 3)
+			{
+				SDL_Log("Invalid indices for %s", fileName.c_str());
+				return false;
+			}
+
+			outMesh.mIndices.emplace_back(ind[0].GetUint());
+			outMesh.mIndices.emplace_back(ind[1].GetUint());
+			outMesh.mIndices.emplace_back(ind[2].GetUint());
+		}
+		return true;
+	}
 }
 
 Mesh::Mesh()
@@ -49,6 +230,7 @@ Mesh::Mesh()
 	,mVertexArray(nullptr)
 	,mRadius(0.0f)
 	,mSpecPower(100.0f)
+	,mLoaded(false)
 {
 }
 
@@ -56,63 +238,72 @@ Mesh::~Mesh()
 {
 }
 
-bool Mesh::Load(const std::string& fileName, Renderer* renderer)
+// What ReadFile hands to Create. The vertices/indices are either
+// straight out of the mapped .bin, or in the parsed JSON source.
+struct Mesh::FileData
 {
-	mFileName = fileName;
+	MeshSource mSource;
+	MappedFile mFile;
+	const void* mVerts = nullptr;
+	uint32_t mNumVerts = 0;
+	const uint32_t* mIndices = nullptr;
+	uint32_t mNumIndices = 0;
+};
 
-	// Try loading the binary file first
-	if (LoadBinary(fileName + ".bin", renderer))
-	{
-		return true;
-	}
-
-	rapidjson::Document doc;
-	if (!LevelLoader::LoadJSON(fileName, doc))
-	{
-		SDL_Log("Failed to load mesh %s", fileName.c_str());
-		return false;
-	}
-
-	int ver = doc["version"].GetInt();
-
-	// Check the version
-	if (ver != 1)
+bool Mesh::Load(const std::string& fileName, Renderer* renderer)
+{
+	PROFILE_SCOPE_DETAIL("Mesh::Load", fileName.c_str());
+	std::shared_ptr<FileData> data = ReadFile(fileName);
+	if (!data)
 	{
-		SDL_Log("Mesh %s not version 1", fileName.c_str());
 		return false;
 	}
+	return Create(fileName, *data, renderer);
+}
 
-	mShaderName = doc["shader"].GetString();
-
-	// Set the vertex layout/size based on the format in the file
-	VertexArray::Layout layout = VertexArray::PosNormTex;
-	size_t vertSize = 8;
-
-	std::string vertexFormat = doc["vertexformat"].GetString();
-	if (vertexFormat == "PosNormSkinTex")
+std::shared_ptr<Mesh::FileData> Mesh::ReadFile(const std::string& fileName)
+{
+	PROFILE_SCOPE_DETAIL("Mesh::ReadFile", fileName.c_str());
+	std::shared_ptr<FileData> data = std::make_shared<FileData>();
+	// Baked meshes are mapped straight from disk, so only fall back
+	// to parsing the JSON if this mesh hasn't been baked
+	if (ReadBinary(fileName + ".bin", *data) || ReadJSON(fileName, *data))
 	{
-		layout = VertexArray::PosNormSkinTex;
-		// This is the number of "Vertex" unions, which is 8 + 2 (for skinning)s
-		vertSize = 10;
+		return data;
 	}
+	return nullptr;
+}
 
-	// Load textures
-	const rapidjson::Value& textures = doc["textures"];
-	if (!textures.IsArray() || textures.Size() < 1)
+bool Mesh::ReadJSON(const std::string& fileName, FileData& outData)
+{
+	MeshSource& source = outData.mSource;
+	if (!ParseMeshJSON(fileName, source))
 	{
-		SDL_Log("Mesh %s has no textures, there should be at least one", fileName.c_str());
 		return false;
 	}
+	outData.mVerts = source.mVertices.data();
+	outData.mNumVerts = source.GetNumVerts();
+	outData.mIndices = source.mIndices.data();
+	outData.mNumIndices = static_cast<uint32_t>(source.mIndices.size());
+	return true;
+}
 
-	mSpecPower = static_cast<float>(doc["specularPower"].GetDouble());
+bool Mesh::Create(const std::string& fileName, const FileData& data,
+	Renderer* renderer, bool streamTextures)
+{
+	const MeshSource& source = data.mSource;
+	mFileName = fileName;
+	mShaderName = source.mShaderName;
+	mBox = source.mBox;
+	mRadius = source.mRadius;
+	mSpecPower = source.mSpecPower;
 
-	std::vector<std::string> textureNames;
-	for (rapidjson::SizeType i = 0; i < textures.Size(); i++)
+	for (const auto& texName : source.mTextureNames)
 	{
-		// Is this texture already loaded?
-		std::string texName = textures[i].GetString();
-		textureNames.emplace_back(texName);
-		Texture* t = renderer->GetTexture(texName);
+		// Is this texture already loaded? (A streamed texture shows
+		// the default one until it's in)
+		Texture* t = streamTextures ? renderer->GetTextureAsync(texName) :
+			renderer->GetTexture(texName);
 		if (t == nullptr)
 		{
 			// If it's null, use the default texture
@@ -121,109 +312,29 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		mTextures.emplace_back(t);
 	}
 
-	// Load in the vertices
-	const rapidjson::Value& vertsJson = doc["vertices"];
-	if (!vertsJson.IsArray() || vertsJson.Size() < 1)
+	// Now create a vertex array (unless there's no GL to put it in)
+	if (!renderer->IsHeadless())
 	{
-		SDL_Log("Mesh %s has no vertices", fileName.c_str());
-		return false;
+		mVertexArray = new VertexArray(data.mVerts, data.mNumVerts,
+			source.mLayout, data.mIndices, data.mNumIndices);
 	}
+	mLoaded = true;
+	return true;
+}
 
-	std::vector<Vertex> vertices;
-	vertices.reserve(vertsJson.Size() * vertSize);
-	mRadius = 0.0f;
-	for (rapidjson::SizeType i = 0; i < vertsJson.Size(); i++)
-	{
-		// For now, just assume we have 8 elements
-		const rapidjson::Value& vert = vertsJson[i];
-		if (!vert.IsArray())
-		{
-			SDL_Log("Unexpected vertex format for %s", fileName.c_str());
-			return false;
-		}
-
-		Vector3 pos(vert[0].GetDouble(), vert[1].GetDouble(), vert[2].GetDouble());
-		mRadius = Math::Max(mRadius, pos.LengthSq());
-		mBox.UpdateMinMax(pos);
-
-		if (layout == VertexArray::PosNormTex)
-		{
-			Vertex v;
-			// Add the floats
-			for (rapidjson::SizeType j = 0; j < vert.Size(); j++)
-			{
-				v.f = static_cast<float>(vert[j].GetDouble());
-				vertices.emplace_back(v);
-			}
-		}
-		else
-		{
-			Vertex v;
-			// Add pos/normal
-			for (rapidjson::SizeType j = 0; j < 6; j++)
-			{
-				v.f = static_cast<float>(vert[j].GetDouble());
-				vertices.emplace_back(v);
-			}
-
-			// Add skin information
-			for (rapidjson::SizeType j = 6; j < 14; j += 4)
-			{
-				v.b[0] = vert[j].GetUint();
-				v.b[1] = vert[j + 1].GetUint();
-				v.b[2] = vert[j + 2].GetUint();
-				v.b[3] = vert[j + 3].GetUint();
-				vertices.emplace_back(v);
-			}
-
-			// Add tex coords
-			for (rapidjson::SizeType j = 14; j < vert.Size(); j++)
-			{
-				v.f = vert[j].GetDouble();
-				vertices.emplace_back(v);
-			}
-		}
-	}
-
-	// We were computing length squared earlier
-	mRadius = Math::Sqrt(mRadius);
-
-	// Load in the indices
-	const rapidjson::Value& indJson = doc["indices"];
-	if (!indJson.IsArray() || indJson.Size() < 1)
+bool Mesh::Bake(const std::string& fileName)
+{
+	MeshSource source;
+	if (!ParseMeshJSON(fileName, source))
 	{
-		SDL_Log("Mesh %s has no indices", fileName.c_str());
 		return false;
 	}
 
-	std::vector<unsigned int> indices;
-	indices.reserve(indJson.Size() * 3);
-	for (rapidjson::SizeType i = 0; i < indJson.Size(); i++)
-	{
-		const rapidjson::Value& ind = indJson[i];
-		if (!ind.IsArray() || ind.Size() != 3)
-		{
-			SDL_Log("Invalid indices for %s", fileName.c_str());
-			return false;
-		}
-
-		indices.emplace_back(ind[0].GetUint());
-		indices.emplace_back(ind[1].GetUint());
-		indices.emplace_back(ind[2].GetUint());
-	}
-
-	// Now create a vertex array
-	unsigned int numVerts = static_cast<unsigned>(vertices.size()) / vertSize;
-	mVertexArray = new VertexArray(vertices.data(), numVerts,
-		layout, indices.data(), static_cast<unsigned>(indices.size()));
-
-	// Save the binary mesh
-	SaveBinary(fileName + ".bin", vertices.data(),
-		numVerts, layout, indices.data(),
-		static_cast<unsigned>(indices.size()),
-		textureNames, mBox, mRadius,
-		mSpecPower);
-	return true;
+	return SaveBinary(fileName + ".bin", source.mVertices.data(),
+		source.GetNumVerts(), source.mLayout, source.mIndices.data(),
+		static_cast<uint32_t>(source.mIndices.size()),
+		source.mShaderName, source.mTextureNames,
+		source.mBox, source.mRadius, source.mSpecPower);
 }
 
 void Mesh::Unload()
@@ -244,119 +355,149 @@ Texture* Mesh::GetTexture(size_t index)
 	}
 }
 
-void Mesh::SaveBinary(const std::string& fileName, const void* verts, 
+bool Mesh::SaveBinary(const std::string& fileName, const void* verts,
 	uint32_t numVerts, VertexArray::Layout layout,
 	const uint32_t* indices, uint32_t numIndices,
+	const std::string& shaderName,
 	const std::vector<std::string>& textureNames,
 	const AABB& box, float radius,
 	float specPower)
 {
+	// Shader name then texture names, each null-terminated
+	std::string strings(shaderName.c_str(), shaderName.length() + 1);
+	for (const auto& tex : textureNames)
+	{
+		strings.append(tex.c_str(), tex.length() + 1);
+	}
+
 	// Create header struct
 	MeshBinHeader header;
-	header.mLayout = layout;
-	header.mNumTextures = 
-		static_cast<unsigned>(textureNames.size());
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mSignature, "GMSH", 4);
+	header.mVersion = BinaryVersion;
+	header.mLayout = static_cast<uint32_t>(layout);
+	header.mNumTextures =
+		static_cast<uint32_t>(textureNames.size());
 	header.mNumVerts = numVerts;
 	header.mNumIndices = numIndices;
-	header.mBox = box;
+	memcpy(header.mBoxMin, box.mMin.GetAsFloatPtr(), sizeof(header.mBoxMin));
+	memcpy(header.mBoxMax, box.mMax.GetAsFloatPtr(), sizeof(header.mBoxMax));
 	header.mRadius = radius;
+	header.mSpecPower = specPower;
+
+	// Figure out number of bytes for each vertex, based on layout
+	uint32_t vertsSize = numVerts * VertexArray::GetVertexSize(layout);
+	uint32_t indicesSize = numIndices * sizeof(uint32_t);
+	header.mStringsOffset = AlignSection(sizeof(header));
+	header.mStringsSize = static_cast<uint32_t>(strings.size());
+	header.mVertsOffset = AlignSection(header.mStringsOffset + header.mStringsSize);
+	header.mIndicesOffset = AlignSection(header.mVertsOffset + vertsSize);
+	header.mFileSize = header.mIndicesOffset + indicesSize;
 
 	// Open binary file for writing
-	std::ofstream outFile(fileName, std::ios::out 
-		| std::ios::binary);
-	if (outFile.is_open())
+	std::ofstream outFile(fileName, std::ios::out
+		| std::ios::binary | std::ios::trunc);
+	if (!outFile.is_open())
 	{
-		// Write the header
-		outFile.write(reinterpret_cast<char*>(&header), sizeof(header));
-
-		// For each texture, we need to write the size of the name
-		// followed by the string (null-terminated)
-		for (const auto& tex : textureNames)
-		{
-			// (Assume file names won't have more than 32k characters)
-			uint16_t nameSize = static_cast<uint16_t>(tex.length()) + 1;
-			outFile.write(reinterpret_cast<char*>(&nameSize), sizeof(nameSize));
-			outFile.write(tex.c_str(), nameSize - 1);
-			outFile.write("\0", 1);
-		}
-
-		// Figure out number of bytes for each vertex, based on layout
-		unsigned vertexSize = VertexArray::GetVertexSize(layout);
-		// Write vertices
-		outFile.write(reinterpret_cast<const char*>(verts), 
-			numVerts * vertexSize);
-		// Write indices
-		outFile.write(reinterpret_cast<const char*>(indices), 
-			numIndices * sizeof(uint32_t));
+		SDL_Log("Failed to write mesh %s", fileName.c_str());
+		return false;
 	}
+
+	// Writes each section, zero padding up to its offset
+	const char zeros[SectionAlignment] = {};
+	uint32_t written = 0;
+	auto writeSection = [&](uint32_t offset, const void* data, uint32_t size)
+	{
+		outFile.write(zeros, offset - written);
+		outFile.write(reinterpret_cast<const char*>(data), size);
+		written = offset + size;
+	};
+	writeSection(0, &header, sizeof(header));
+	writeSection(header.mStringsOffset, strings.data(), header.mStringsSize);
+	writeSection(header.mVertsOffset, verts, vertsSize);
+	writeSection(header.mIndicesOffset, indices, indicesSize);
+	return outFile.good();
 }
 
-bool Mesh::LoadBinary(const std::string& fileName, Renderer* renderer)
+bool Mesh::ReadBinary(const std::string& fileName, FileData& outData)
 {
-	std::ifstream inFile(fileName, std::ios::in | 
-		std::ios::binary);
-	if (inFile.is_open())
+	MappedFile& file = outData.mFile;
+	if (!file.Open(fileName) || file.GetSize() < sizeof(MeshBinHeader))
 	{
-		// Read in header
-		MeshBinHeader header;
-		inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
-
-		// Validate the header signature and version
-		char* sig = header.mSignature;
-		if (sig[0] != 'G' || sig[1] != 'M' || sig[2] != 'S' ||
-			sig[3] != 'H' || header.mVersion != BinaryVersion)
-		{
-			return false;
-		}
-
-		// Read in the texture file names
-		for (uint32_t i = 0; i < header.mNumTextures; i++)
-		{
-			// Get the file name size
-			uint16_t nameSize = 0;
-			inFile.read(reinterpret_cast<char*>(&nameSize), sizeof(nameSize));
-			
-			// Make a buffer of this size
-			char* texName = new char[nameSize];
-			// Read in the texture name
-			inFile.read(texName, nameSize);
-			
-			// Get this texture
-			Texture* t = renderer->GetTexture(texName);
-			if (t == nullptr)
-			{
-				// If it's null, use the default texture
-				t = renderer->GetTexture("Assets/Default.png");
-			}
-			mTextures.emplace_back(t);
-
-			delete[] texName;
-		}
-
-		// Now read in the vertices
-		unsigned vertexSize = VertexArray::GetVertexSize(header.mLayout);
-		char* verts = new char[header.mNumVerts * vertexSize];
-		inFile.read(verts, header.mNumVerts * vertexSize);
-
-		// Now read in the indices
-		uint32_t* indices = new uint32_t[header.mNumIndices];
-		inFile.read(reinterpret_cast<char*>(indices), 
-			header.mNumIndices * sizeof(uint32_t));
+		return false;
+	}
+	const unsigned char* data = file.GetData();
+	// (The mapping is page aligned, so the header can be read in place)
+	const MeshBinHeader& header = *reinterpret_cast<const MeshBinHeader*>(data);
 
-		// Now create the vertex array
-		mVertexArray = new VertexArray(verts, header.mNumVerts,
-			header.mLayout, indices, header.mNumIndices);
+	// Validate the header signature and version
+	if (memcmp(header.mSignature, "GMSH", 4) != 0)
+	{
+		return false;
+	}
+	if (header.mVersion != BinaryVersion)
+	{
+		SDL_Log("Mesh %s is an old version, rebake it with -bake", fileName.c_str());
+		return false;
+	}
 
-		// Cleanup memory
-		delete[] verts;
-		delete[] indices;
+	// Make sure every section is inside the file before using it
+	uint64_t vertsSize = static_cast<uint64_t>(header.mNumVerts) *
+		VertexArray::GetVertexSize(static_cast<VertexArray::Layout>(header.mLayout));
+	uint64_t indicesSize = static_cast<uint64_t>(header.mNumIndices) * sizeof(uint32_t);
+	if (header.mLayout > VertexArray::PosNormSkinTex ||
+		header.mFileSize != file.GetSize() ||
+		header.mStringsOffset % SectionAlignment != 0 ||
+		header.mVertsOffset % SectionAlignment != 0 ||
+		header.mIndicesOffset % SectionAlignment != 0 ||
+		static_cast<uint64_t>(header.mStringsOffset) + header.mStringsSize > header.mFileSize ||
+		header.mVertsOffset + vertsSize > header.mFileSize ||
+		header.mIndicesOffset + indicesSize > header.mFileSize)
+	{
+		SDL_Log("Mesh %s is corrupt", fileName.c_str());
+		return false;
+	}
 
-		// Set mBox/mRadius/specular from header
-		mBox = header.mBox;
-		mRadius = header.mRadius;
-		mSpecPower = header.mSpecPower;
+	// Split the strings section up, it must end in a null
+	const char* strings = reinterpret_cast<const char*>(data + header.mStringsOffset);
+	if (header.mStringsSize == 0 || strings[header.mStringsSize - 1] != '\0')
+	{
+		SDL_Log("Mesh %s is corrupt", fileName.c_str());
+		return false;
+	}
+	std::vector<const char*> names;
+	for (size_t i = 0; i < header.mStringsSize; i += strlen(strings + i) + 1)
+	{
+		names.emplace_back(strings + i);
+	}
+	if (names.size() != header.mNumTextures + 1)
+	{
+		SDL_Log("Mesh %s is corrupt", fileName.c_str());
+		return false;
+	}
 
-		return true;
+	MeshSource& source = outData.mSource;
+	source.mShaderName = names[0];
+	source.mTextureNames.assign(names.begin() + 1, names.end());
+	source.mLayout = static_cast<VertexArray::Layout>(header.mLayout);
+
+	// The vertices/indices get uploaded directly from the mapped file.
+	// Touch every page now, so the disk reads happen on this thread
+	// rather than in the upload.
+	outData.mVerts = data + header.mVertsOffset;
+	outData.mNumVerts = header.mNumVerts;
+	outData.mIndices = reinterpret_cast<const uint32_t*>(data + header.mIndicesOffset);
+	outData.mNumIndices = header.mNumIndices;
+	volatile unsigned char touch = 0;
+	for (size_t i = 0; i < file.GetSize(); i += 4096)
+	{
+		touch += data[i];
 	}
-	return false;
+
+	// Set box/radius/specular from header
+	source.mBox.mMin = Vector3(header.mBoxMin[0], header.mBoxMin[1], header.mBoxMin[2]);
+	source.mBox.mMax = Vector3(header.mBoxMax[0], header.mBoxMax[1], header.mBoxMax[2]);
+	source.mRadius = header.mRadius;
+	source.mSpecPower = header.mSpecPower;
+	return true;
 }
@@ -7,6 +7,7 @@
 // ----------------------------------------------------------------
 
 #pragma once
+#include <memory>
 #include <vector>
 #include <string>
 #include "Collision.h"
@@ -35,16 +36,33 @@ public:
 	// Get specular power of mesh
 	float GetSpecPower() const { return mSpecPower; }
 
+	// False until the vertex array/textures are set up (for meshes
+	// still on their way from the AssetLoader)
+	bool IsLoaded() const { return mLoaded; }
+
+	// Load split in two, so the file can be read and parsed off the
+	// main thread. ReadFile returns null on failure, Create needs the
+	// GL context. streamTextures loads the textures asynchronously.
+	struct FileData;
+	static std::shared_ptr<FileData> ReadFile(const std::string& fileName);
+	bool Create(const std::string& fileName, const FileData& data,
+		class Renderer* renderer, bool streamTextures = false);
+
+	// Convert a .gpmesh file to the .gpmesh.bin next to it
+	static bool Bake(const std::string& fileName);
 	// Save the mesh in binary format
-	void SaveBinary(const std::string& fileName, const void* verts, 
+	static bool SaveBinary(const std::string& fileName, const void* verts,
 		uint32_t numVerts, VertexArray::Layout layout,
 		const uint32_t* indices, uint32_t numIndices,
+		const std::string& shaderName,
 		const std::vector<std::string>& textureNames,
 		const AABB& box, float radius,
 		float specPower);
-	// Load in the mesh from binary format
-	bool LoadBinary(const std::string& fileName, class Renderer* renderer);
 private:
+	// Read the .gpmesh file, or the baked .gpmesh.bin
+	static bool ReadJSON(const std::string& fileName, FileData& outData);
+	static bool ReadBinary(const std::string& fileName, FileData& outData);
+
 	// AABB collision
 	AABB mBox;
 	// Textures associated with this mesh
@@ -59,4 +77,5 @@ private:
 	float mRadius;
 	// Specular power of surface
 	float mSpecPower;
+	bool mLoaded;
 };
\ No newline at end of file
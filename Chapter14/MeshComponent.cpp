@@ -15,6 +15,7 @@
 #include "Texture.h"
 #include "VertexArray.h"
 #include "LevelLoader.h"
+#include "InstanceBatch.h"
 
 MeshComponent::MeshComponent(Actor* owner, bool isSkeletal)
 	:Component(owner)
@@ -22,24 +23,24 @@ MeshComponent::MeshComponent(Actor* owner, bool isSkeletal)
 	,mTextureIndex(0)
 	,mVisible(true)
 	,mIsSkeletal(isSkeletal)
+	,mInstanceBatch(nullptr)
+	,mInstanceSlot(-1)
 {
-	mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
+	// Nothing to do per frame
+	mUpdateMode = ENoUpdate;
+	mRendererHandle = mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
 }
 
 MeshComponent::~MeshComponent()
 {
-	mOwner->GetGame()->GetRenderer()->RemoveMeshComp(this);
+	mOwner->GetGame()->GetRenderer()->RemoveMeshComp(this, mRendererHandle);
 }
 
 void MeshComponent::Draw(Shader* shader)
 {
 	if (mMesh)
 	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform", 
-			mOwner->GetWorldTransform());
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
+		SetUniforms(shader);
 		// Set the active texture
 		Texture* t = mMesh->GetTexture(mTextureIndex);
 		if (t)
@@ -54,6 +55,30 @@ void MeshComponent::Draw(Shader* shader)
 	}
 }
 
+void MeshComponent::SetUniforms(Shader* shader)
+{
+	static const UniformHandle worldTransform("uWorldTransform");
+	static const UniformHandle specPower("uSpecPower");
+	// Set the world transform
+	shader->SetMatrixUniform(worldTransform, 
+		mOwner->GetRenderTransform());
+	// Set specular power
+	shader->SetFloatUniform(specPower, mMesh->GetSpecPower());
+}
+
+void MeshComponent::OnUpdateRenderTransform()
+{
+	if (mInstanceBatch)
+	{
+		mInstanceBatch->SetTransform(mInstanceSlot, mOwner->GetRenderTransform());
+	}
+}
+
+Texture* MeshComponent::GetTexture() const
+{
+	return mMesh ? mMesh->GetTexture(mTextureIndex) : nullptr;
+}
+
 void MeshComponent::LoadProperties(const rapidjson::Value& inObj)
 {
 	Component::LoadProperties(inObj);
@@ -61,7 +86,8 @@ void MeshComponent::LoadProperties(const rapidjson::Value& inObj)
 	std::string meshFile;
 	if (JsonHelper::GetString(inObj, "meshFile", meshFile))
 	{
-		SetMesh(mOwner->GetGame()->GetRenderer()->GetMesh(meshFile));
+		// Streamed in, it's drawn once it's loaded
+		SetMesh(mOwner->GetGame()->GetRenderer()->GetMeshAsync(meshFile));
 	}
 
 	int idx;
@@ -13,12 +13,20 @@ class MeshComponent : public Component
 {
 public:
 	MeshComponent(class Actor* owner, bool isSkeletal = false);
+	DECLARE_POOLED(MeshComponent)
 	~MeshComponent();
 	// Draw this mesh component
 	virtual void Draw(class Shader* shader);
+	// Set the per-object uniforms Draw uses (the render queue
+	// binds the texture and vertex array itself)
+	virtual void SetUniforms(class Shader* shader);
 	// Set the mesh/texture index used by mesh component
 	virtual void SetMesh(class Mesh* mesh) { mMesh = mesh; }
+	class Mesh* GetMesh() const { return mMesh; }
+	// Texture this component draws with (may be null)
+	class Texture* GetTexture() const;
 	void SetTextureIndex(size_t index) { mTextureIndex = index; }
+	size_t GetTextureIndex() const { return mTextureIndex; }
 
 	void SetVisible(bool visible) { mVisible = visible; }
 	bool GetVisible() const { return mVisible; }
@@ -27,6 +35,17 @@ public:
 
 	TypeID GetType() const override { return TMeshComponent; }
 
+	// Keeps the instance batch's copy of the transform up to date
+	void OnUpdateRenderTransform() override;
+	// Batch this is drawn with (if the renderer is instancing)
+	class InstanceBatch* GetInstanceBatch() const { return mInstanceBatch; }
+	int GetInstanceSlot() const { return mInstanceSlot; }
+	void SetInstanceBatch(class InstanceBatch* batch, int slot)
+	{
+		mInstanceBatch = batch;
+		mInstanceSlot = slot;
+	}
+
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
@@ -35,4 +54,7 @@ protected:
 	size_t mTextureIndex;
 	bool mVisible;
 	bool mIsSkeletal;
+	class InstanceBatch* mInstanceBatch;
+	int mInstanceSlot;
+	SlotHandle mRendererHandle;
 };
\ No newline at end of file
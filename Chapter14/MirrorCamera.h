@@ -13,6 +13,7 @@ class MirrorCamera : public CameraComponent
 {
 public:
 	MirrorCamera(class Actor* owner);
+	DECLARE_POOLED(MirrorCamera)
 
 	void Update(float deltaTime) override;
 	
@@ -9,13 +9,39 @@
 #include "MoveComponent.h"
 #include "Actor.h"
 #include "LevelLoader.h"
+#include "JobSystem.h"
 
 MoveComponent::MoveComponent(class Actor* owner, int updateOrder)
 :Component(owner, updateOrder)
 ,mAngularSpeed(0.0f)
 ,mForwardSpeed(0.0f)
+,mStrafeSpeed(0.0f)
 {
-	
+	// Plain MoveComponents are all updated at once by UpdateAll
+	mUpdateMode = EUpdateBatched;
+	mUpdatePhase = EPhasePrePhysics;
+	mParallelSafe = true;
+}
+
+void MoveComponent::UpdateAll(float deltaTime, JobSystem* jobs)
+{
+	// They're all in one pool, so each worker walks straight through
+	// the memory of the chunks it takes. Each only writes its owner,
+	// and an actor only ever has one MoveComponent.
+	Pool<MoveComponent>& pool = Pool<MoveComponent>::Get();
+	jobs->ParallelFor(pool.GetNumChunks(), 1, [&pool, deltaTime](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			pool.ForEachInChunk(i, [deltaTime](MoveComponent* mc) {
+				if (mc->mUpdateMode == EUpdateBatched &&
+					mc->mOwner->GetState() == Actor::EActive)
+				{
+					mc->MoveComponent::Update(deltaTime);
+				}
+			});
+		}
+	});
 }
 
 void MoveComponent::Update(float deltaTime)
@@ -14,7 +14,11 @@ class MoveComponent : public Component
 public:
 	// Lower update order to update first
 	MoveComponent(class Actor* owner, int updateOrder = 10);
+	DECLARE_POOLED(MoveComponent)
 	void Update(float deltaTime) override;
+	// Updates every batched MoveComponent, split across the workers
+	// (see Game::UpdateActors)
+	static void UpdateAll(float deltaTime, class JobSystem* jobs);
 	
 	float GetAngularSpeed() const { return mAngularSpeed; }
 	float GetForwardSpeed() const { return mForwardSpeed; }
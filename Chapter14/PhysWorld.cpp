@@ -16,89 +16,120 @@ PhysWorld::PhysWorld(Game* game)
 {
 }
 
-bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
+namespace
 {
-	bool collided = false;
-	// Initialize closestT to infinity, so first
-	// intersection will always update closestT
-	float closestT = Math::Infinity;
-	Vector3 norm;
-	// Test against all boxes
-	for (auto box : mBoxes)
+	// Boxes found by the tree are gathered into small batches,
+	// which then go through the SIMD segment test together
+	const size_t SegmentBatchSize = 16;
+
+	struct SegmentBatch
 	{
-		float t;
-		// Does the segment intersect with the box?
-		if (Intersect(l, box->GetWorldBox(), t, norm))
+		alignas(32) float mMin[3][SegmentBatchSize];
+		alignas(32) float mMax[3][SegmentBatchSize];
+		BoxComponent* mBoxes[SegmentBatchSize];
+		size_t mCount = 0;
+
+		void Add(BoxComponent* box)
 		{
-			// Is this closer than previous intersection?
-			if (t < closestT)
+			const AABB& world = box->GetWorldBox();
+			for (int i = 0; i < 3; i++)
 			{
-				closestT = t;
-				outColl.mPoint = l.PointOnSegment(t);
-				outColl.mNormal = norm;
-				outColl.mBox = box;
-				outColl.mActor = box->GetOwner();
-				collided = true;
+				mMin[i][mCount] = world.mMin.GetAsFloatPtr()[i];
+				mMax[i][mCount] = world.mMax.GetAsFloatPtr()[i];
 			}
+			mBoxes[mCount] = box;
+			mCount++;
+		}
+
+		AABBSoA GetSoA() const
+		{
+			return AABBSoA{ mMin[0], mMin[1], mMin[2],
+				mMax[0], mMax[1], mMax[2], mCount };
+		}
+	};
+}
+
+bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
+{
+	bool collided = false;
+	SegmentBatch batch;
+	float closestT = 1.0f;
+	// Test the batched boxes, keeping the closest intersection
+	auto flush = [&]() {
+		float t;
+		Vector3 norm;
+		size_t index;
+		if (Intersect(l, batch.GetSoA(), closestT, t, norm, index))
+		{
+			closestT = t;
+			outColl.mPoint = l.PointOnSegment(t);
+			outColl.mNormal = norm;
+			outColl.mBox = batch.mBoxes[index];
+			outColl.mActor = outColl.mBox->GetOwner();
+			collided = true;
 		}
+		batch.mCount = 0;
+	};
+
+	// Only test against boxes whose node in the tree the segment
+	// passes through. The tree passes in the closest t so far
+	// (initially the end of the segment), so boxes further away
+	// than the closest intersection get culled
+	mTree.SegmentCast(l, [&](int proxyID, float) {
+		batch.Add(static_cast<BoxComponent*>(mTree.GetUserData(proxyID)));
+		if (batch.mCount == SegmentBatchSize)
+		{
+			flush();
+		}
+		return closestT;
+	});
+	if (batch.mCount > 0)
+	{
+		flush();
 	}
 	return collided;
 }
 
 void PhysWorld::TestPairwise(std::function<void(Actor*, Actor*)> f)
 {
-	// Naive implementation O(n^2)
-	for (size_t i = 0; i < mBoxes.size(); i++)
+	// Query the tree with each box, so only nearby boxes are tested
+	for (BoxComponent* a : mBoxes)
 	{
-		// Don't need to test vs itself and any previous i values
-		for (size_t j = i + 1; j < mBoxes.size(); j++)
-		{
-			BoxComponent* a = mBoxes[i];
-			BoxComponent* b = mBoxes[j];
-			if (Intersect(a->GetWorldBox(), b->GetWorldBox()))
+		const AABB& boxA = a->GetWorldBox();
+		int proxyA = a->GetTreeProxyID();
+		mTree.Query(boxA, [&](int proxyB) {
+			// Only handle each pair once (and don't test vs itself)
+			if (proxyB > proxyA)
 			{
-				// Call supplied function to handle intersection
-				f(a->GetOwner(), b->GetOwner());
+				BoxComponent* b = static_cast<BoxComponent*>(mTree.GetUserData(proxyB));
+				if (Intersect(boxA, b->GetWorldBox()))
+				{
+					// Call supplied function to handle intersection
+					f(a->GetOwner(), b->GetOwner());
+				}
 			}
-		}
+			return true;
+		});
 	}
 }
 
-void PhysWorld::TestSweepAndPrune(std::function<void(Actor*, Actor*)> f)
+void PhysWorld::OverlapBox(const AABB& box, std::function<void(BoxComponent*)> f)
 {
-	// Sort by min.x
-	std::sort(mBoxes.begin(), mBoxes.end(),
-		[](BoxComponent* a, BoxComponent* b) {
-			return a->GetWorldBox().mMin.x <
-				b->GetWorldBox().mMin.x;
-	});
-
-	for (size_t i = 0; i < mBoxes.size(); i++)
-	{
-		// Get max.x for current box
-		BoxComponent* a = mBoxes[i];
-		float max = a->GetWorldBox().mMax.x;
-		for (size_t j = i + 1; j < mBoxes.size(); j++)
+	mTree.Query(box, [&](int proxyID) {
+		BoxComponent* b = static_cast<BoxComponent*>(mTree.GetUserData(proxyID));
+		// The tree stores fat boxes, so test the actual box
+		if (Intersect(box, b->GetWorldBox()))
 		{
-			BoxComponent* b = mBoxes[j];
-			// If AABB[j] min is past the max bounds of AABB[i],
-			// then there aren't any other possible intersections
-			// against AABB[i]
-			if (b->GetWorldBox().mMin.x > max)
-			{
-				break;
-			}
-			else if (Intersect(a->GetWorldBox(), b->GetWorldBox()))
-			{
-				f(a->GetOwner(), b->GetOwner());
-			}
+			f(b);
 		}
-	}
+		return true;
+	});
 }
 
 void PhysWorld::AddBox(BoxComponent* box)
 {
 	mBoxes.emplace_back(box);
+	box->SetTreeProxyID(mTree.CreateProxy(box->GetWorldBox(), box));
 }
 
 void PhysWorld::RemoveBox(BoxComponent* box)
@@ -109,5 +140,14 @@ void PhysWorld::RemoveBox(BoxComponent* box)
 		// Swap to end of vector and pop off (avoid erase copies)
 		std::iter_swap(iter, mBoxes.end() - 1);
 		mBoxes.pop_back();
+		mTree.DestroyProxy(box->GetTreeProxyID());
+		box->SetTreeProxyID(AABBTree::NullNode);
 	}
 }
+
+void PhysWorld::UpdateBox(BoxComponent* box)
+{
+	// This only reinserts into the tree if the box
+	// moved outside of its fat box
+	mTree.MoveProxy(box->GetTreeProxyID(), box->GetWorldBox());
+}
@@ -11,6 +11,7 @@
 #include <functional>
 #include "Math.h"
 #include "Collision.h"
+#include "AABBTree.h"
 
 class PhysWorld
 {
@@ -34,15 +35,20 @@ public:
 	// Returns true if it collides against a box
 	bool SegmentCast(const LineSegment& l, CollisionInfo& outColl);
 
-	// Tests collisions using naive pairwise
+	// Tests collisions using the bounding volume tree
 	void TestPairwise(std::function<void(class Actor*, class Actor*)> f);
-	// Test collisions using sweep and prune
-	void TestSweepAndPrune(std::function<void(class Actor*, class Actor*)> f);
+
+	// Calls f for every box that intersects the specified box
+	void OverlapBox(const AABB& box, std::function<void(class BoxComponent*)> f);
 
 	// Add/remove box components from world
 	void AddBox(class BoxComponent* box);
 	void RemoveBox(class BoxComponent* box);
+	// Called when a box component's world box changes
+	void UpdateBox(class BoxComponent* box);
 private:
 	class Game* mGame;
 	std::vector<class BoxComponent*> mBoxes;
+	// Broadphase tree of all the world boxes
+	AABBTree mTree;
 };
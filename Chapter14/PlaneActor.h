@@ -13,5 +13,6 @@ class PlaneActor : public Actor
 {
 public:
 	PlaneActor(class Game* game);
+	DECLARE_POOLED(PlaneActor)
 	TypeID GetType() const override { return TPlaneActor; }
 };
@@ -18,12 +18,14 @@
 PointLightComponent::PointLightComponent(Actor* owner)
 	:Component(owner)
 {
-	owner->GetGame()->GetRenderer()->AddPointLight(this);
+	// Nothing to do per frame
+	mUpdateMode = ENoUpdate;
+	mRendererHandle = owner->GetGame()->GetRenderer()->AddPointLight(this);
 }
 
 PointLightComponent::~PointLightComponent()
 {
-	mOwner->GetGame()->GetRenderer()->RemovePointLight(this);
+	mOwner->GetGame()->GetRenderer()->RemovePointLight(mRendererHandle);
 }
 
 void PointLightComponent::Draw(Shader* shader, Mesh* mesh)
@@ -32,17 +34,23 @@ void PointLightComponent::Draw(Shader* shader, Mesh* mesh)
 	// and the sphere mesh is active
 
 	// World transform is scaled to the outer radius (divided by the mesh radius)
-	// and positioned to the world position
+	// and positioned to the world position (interpolated, like the meshes)
+	Vector3 pos = mOwner->GetRenderTransform().GetTranslation();
 	Matrix4 scale = Matrix4::CreateScale(mOwner->GetScale() *
 		mOuterRadius / mesh->GetRadius());
-	Matrix4 trans = Matrix4::CreateTranslation(mOwner->GetPosition());
+	Matrix4 trans = Matrix4::CreateTranslation(pos);
 	Matrix4 worldTransform = scale * trans;
-	shader->SetMatrixUniform("uWorldTransform", worldTransform);
+	static const UniformHandle worldHandle("uWorldTransform");
+	static const UniformHandle worldPos("uPointLight.mWorldPos");
+	static const UniformHandle diffuseColor("uPointLight.mDiffuseColor");
+	static const UniformHandle innerRadius("uPointLight.mInnerRadius");
+	static const UniformHandle outerRadius("uPointLight.mOuterRadius");
+	shader->SetMatrixUniform(worldHandle, worldTransform);
 	// Set point light shader constants
-	shader->SetVectorUniform("uPointLight.mWorldPos", mOwner->GetPosition());
-	shader->SetVectorUniform("uPointLight.mDiffuseColor", mDiffuseColor);
-	shader->SetFloatUniform("uPointLight.mInnerRadius", mInnerRadius);
-	shader->SetFloatUniform("uPointLight.mOuterRadius", mOuterRadius);
+	shader->SetVectorUniform(worldPos, pos);
+	shader->SetVectorUniform(diffuseColor, mDiffuseColor);
+	shader->SetFloatUniform(innerRadius, mInnerRadius);
+	shader->SetFloatUniform(outerRadius, mOuterRadius);
 
 	// Draw the sphere
 	glDrawElements(GL_TRIANGLES, mesh->GetVertexArray()->GetNumIndices(), 
@@ -14,6 +14,7 @@ class PointLightComponent : public Component
 {
 public:
 	PointLightComponent(class Actor* owner);
+	DECLARE_POOLED(PointLightComponent)
 	~PointLightComponent();
 
 	// Draw this point light as geometry
@@ -30,4 +31,6 @@ public:
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
+private:
+	SlotHandle mRendererHandle;
 };
@@ -0,0 +1,142 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Storage for every object of type T, in chunks of contiguous slots.
+// Freed slots are reused first, so live objects stay packed together
+// and a loop over them (ForEach) walks memory in order.
+template <typename T>
+class Pool
+{
+public:
+	// The one pool for T
+	static Pool& Get()
+	{
+		static Pool pool;
+		return pool;
+	}
+
+	void* Allocate()
+	{
+		if (mFree.empty())
+		{
+			AddChunk();
+		}
+		Slot* slot = mFree.back();
+		mFree.pop_back();
+		slot->mAlive = true;
+		mCount++;
+		return &slot->mStorage;
+	}
+
+	void Free(void* ptr)
+	{
+		// The storage is the first member of the slot
+		Slot* slot = reinterpret_cast<Slot*>(ptr);
+		slot->mAlive = false;
+		mFree.emplace_back(slot);
+		mCount--;
+	}
+
+	// Calls func(T*) for every live object, in memory order
+	template <typename Func>
+	void ForEach(Func func)
+	{
+		for (size_t i = 0; i < mChunks.size(); i++)
+		{
+			ForEachInChunk(i, func);
+		}
+	}
+
+	// Calls func(T*) for every live object in one chunk, so different
+	// chunks can be handed to different threads
+	template <typename Func>
+	void ForEachInChunk(size_t chunk, Func func)
+	{
+		for (Slot& slot : mChunks[chunk]->mSlots)
+		{
+			if (slot.mAlive)
+			{
+				func(reinterpret_cast<T*>(&slot.mStorage));
+			}
+		}
+	}
+
+	size_t GetNumChunks() const { return mChunks.size(); }
+	size_t GetCount() const { return mCount; }
+	size_t GetCapacity() const { return mChunks.size() * ChunkSize; }
+private:
+	Pool() : mCount(0) { }
+	Pool(const Pool&) = delete;
+	Pool& operator=(const Pool&) = delete;
+
+	static const size_t ChunkSize = 256;
+	struct Slot
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type mStorage;
+		bool mAlive;
+	};
+	struct Chunk
+	{
+		Slot mSlots[ChunkSize];
+	};
+
+	void AddChunk()
+	{
+		mChunks.emplace_back(new Chunk());
+		Chunk* chunk = mChunks.back().get();
+		// Push in reverse so the first slot is handed out first
+		for (size_t i = ChunkSize; i > 0; i--)
+		{
+			chunk->mSlots[i - 1].mAlive = false;
+			mFree.emplace_back(&chunk->mSlots[i - 1]);
+		}
+	}
+
+	std::vector<std::unique_ptr<Chunk>> mChunks;
+	std::vector<Slot*> mFree;
+	size_t mCount;
+};
+
+// Only objects the size of T go in T's pool. A subclass that doesn't
+// declare its own pool is usually bigger, so it uses the heap (but
+// one that adds no members ends up in T's pool).
+template <typename T>
+void* PoolAllocate(size_t size)
+{
+	if (size == sizeof(T))
+	{
+		return Pool<T>::Get().Allocate();
+	}
+	return ::operator new(size);
+}
+
+template <typename T>
+void PoolFree(void* ptr, size_t size)
+{
+	if (size == sizeof(T))
+	{
+		Pool<T>::Get().Free(ptr);
+	}
+	else
+	{
+		::operator delete(ptr);
+	}
+}
+
+// Put in the public section of a class to allocate it from Pool<T>
+// (new and delete keep working as before)
+#define DECLARE_POOLED(T) \
+	static void* operator new(size_t size) { return PoolAllocate<T>(size); } \
+	static void operator delete(void* ptr, size_t size) { PoolFree<T>(ptr, size); }
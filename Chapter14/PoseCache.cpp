@@ -0,0 +1,101 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "PoseCache.h"
+#include "Animation.h"
+#include "Skeleton.h"
+#include <functional>
+
+PoseCache::PoseCache()
+	:mTolerance(1.0f / 60.0f)
+	,mHits(0)
+	,mMisses(0)
+	,mLastHits(0)
+	,mLastMisses(0)
+{
+}
+
+size_t PoseCache::KeyHash::operator()(const Key& key) const
+{
+	size_t hash = std::hash<const void*>()(key.mAnim);
+	hash = hash * 31 + std::hash<const void*>()(key.mSkel);
+	hash = hash * 31 + std::hash<int>()(key.mSlot);
+	hash = hash * 31 + std::hash<size_t>()(key.mMaxBones);
+	return hash;
+}
+
+void PoseCache::BeginFrame()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	// Anything only the cache still references can be reused
+	for (auto& iter : mEntries)
+	{
+		if (iter.second.use_count() == 1)
+		{
+			mFree.emplace_back(std::move(iter.second));
+		}
+	}
+	mEntries.clear();
+
+	mLastHits = mHits;
+	mLastMisses = mMisses;
+	mHits = 0;
+	mMisses = 0;
+}
+
+std::shared_ptr<const MatrixPalette> PoseCache::GetPalette(const Animation* anim,
+	const Skeleton* skel, float inTime, size_t maxBones,
+	std::vector<Matrix4>& scratch)
+{
+	Key key;
+	key.mAnim = anim;
+	key.mSkel = skel;
+	key.mSlot = static_cast<int>(inTime / mTolerance + 0.5f);
+	key.mMaxBones = maxBones;
+
+	std::shared_ptr<MatrixPalette> palette;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto iter = mEntries.find(key);
+		if (iter != mEntries.end())
+		{
+			mHits++;
+			return iter->second;
+		}
+		palette = AllocatePalette();
+	}
+
+	// Compute outside the lock, so other threads aren't held up.
+	// Sample at the slot's time, not inTime, so every mesh that
+	// shares this entry would have computed the same thing.
+	float slotTime = Math::Min(key.mSlot * mTolerance, anim->GetDuration());
+	anim->GetGlobalPoseAtTime(scratch, skel, slotTime, maxBones);
+	Matrix4::MultiplyArray(skel->GetGlobalInvBindPoses().data(), scratch.data(),
+		palette->mEntry, skel->GetNumBones());
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMisses++;
+	// Another thread may have filled in the same entry meanwhile
+	auto result = mEntries.emplace(key, palette);
+	if (!result.second)
+	{
+		mFree.emplace_back(std::move(palette));
+	}
+	return result.first->second;
+}
+
+std::shared_ptr<MatrixPalette> PoseCache::AllocatePalette()
+{
+	if (mFree.empty())
+	{
+		return std::make_shared<MatrixPalette>();
+	}
+	std::shared_ptr<MatrixPalette> palette = std::move(mFree.back());
+	mFree.pop_back();
+	return palette;
+}
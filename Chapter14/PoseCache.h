@@ -0,0 +1,73 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include "MatrixPalette.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Shares matrix palettes between skeletal meshes playing the same
+// animation at (nearly) the same time. Times are rounded to a
+// multiple of the tolerance, so every mesh in the same slot gets
+// exactly the same pose. Entries only live for one frame, but a
+// palette stays alive as long as a mesh still holds onto it.
+class PoseCache
+{
+public:
+	PoseCache();
+
+	// Call once per frame, before any palettes are requested
+	void BeginFrame();
+
+	// Returns the palette for anim on skel at inTime, computing it if
+	// it's not in the cache yet. scratch is used to sample the pose.
+	// Safe to call from multiple threads at once.
+	std::shared_ptr<const MatrixPalette> GetPalette(const class Animation* anim,
+		const class Skeleton* skel, float inTime, size_t maxBones,
+		std::vector<Matrix4>& scratch);
+
+	// Time quantization in seconds (0 turns the cache off)
+	void SetTolerance(float tolerance) { mTolerance = tolerance; }
+	float GetTolerance() const { return mTolerance; }
+	bool IsEnabled() const { return mTolerance > 0.0f; }
+
+	// Hits/misses during the last full frame
+	int GetHits() const { return mLastHits; }
+	int GetMisses() const { return mLastMisses; }
+private:
+	struct Key
+	{
+		const class Animation* mAnim;
+		const class Skeleton* mSkel;
+		int mSlot;
+		size_t mMaxBones;
+		bool operator==(const Key& other) const
+		{
+			return mAnim == other.mAnim && mSkel == other.mSkel &&
+				mSlot == other.mSlot && mMaxBones == other.mMaxBones;
+		}
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	std::shared_ptr<MatrixPalette> AllocatePalette();
+
+	std::unordered_map<Key, std::shared_ptr<MatrixPalette>, KeyHash> mEntries;
+	// Palettes no mesh is using any more, ready for reuse
+	std::vector<std::shared_ptr<MatrixPalette>> mFree;
+	std::mutex mMutex;
+	float mTolerance;
+	int mHits;
+	int mMisses;
+	int mLastHits;
+	int mLastMisses;
+};
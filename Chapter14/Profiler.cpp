@@ -0,0 +1,162 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Profiler.h"
+#include <SDL/SDL_log.h>
+#include <chrono>
+#include <fstream>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler()
+	:mCapturing(false)
+	,mNextThreadID(0)
+	,mGpuActive(false)
+	,mCaptureStart(0)
+	,mFrameStart(0)
+	,mFramesLeft(0)
+	,mFramesRequested(0)
+{
+}
+
+uint64_t Profiler::GetTime()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void Profiler::StartCapture(int numFrames, const std::string& fileName)
+{
+	if (mCapturing || numFrames <= 0)
+	{
+		return;
+	}
+	mFramesRequested = numFrames;
+	mFileName = fileName;
+	SDL_Log("Capturing %d frames to %s", numFrames, fileName.c_str());
+}
+
+int Profiler::GetThreadID()
+{
+	thread_local int id = -1;
+	if (id < 0)
+	{
+		id = mNextThreadID++;
+	}
+	return id;
+}
+
+void Profiler::AddEvent(const char* name, uint64_t start, uint64_t end,
+	const char* detail)
+{
+	int thread = GetThreadID();
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEvents.emplace_back(Event{ name, detail ? detail : "", start, end, thread });
+}
+
+void Profiler::AddTrackEvent(int track, const char* name, uint64_t start, uint64_t end)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEvents.emplace_back(Event{ name, "", start, end, track });
+}
+
+void Profiler::WriteTrace()
+{
+	// Times are in nanoseconds, traces are in microseconds
+	const double usPerTick = 1.0e-3;
+
+	// Take the events, so other threads can keep adding to mEvents
+	std::vector<Event> events;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		events.swap(mEvents);
+	}
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("displayTimeUnit");
+	writer.String("ms");
+	writer.Key("traceEvents");
+	writer.StartArray();
+
+	// Name the tracks
+	auto nameTrack = [&writer](int track, const std::string& name) {
+		writer.StartObject();
+		writer.Key("name");
+		writer.String("thread_name");
+		writer.Key("ph");
+		writer.String("M");
+		writer.Key("pid");
+		writer.Int(1);
+		writer.Key("tid");
+		writer.Int(track);
+		writer.Key("args");
+		writer.StartObject();
+		writer.Key("name");
+		writer.String(name.c_str());
+		writer.EndObject();
+		writer.EndObject();
+	};
+	int numThreads = mNextThreadID;
+	nameTrack(0, "Main thread");
+	for (int i = 1; i < numThreads; i++)
+	{
+		nameTrack(i, "Worker " + std::to_string(i));
+	}
+	nameTrack(GpuTrack, "GPU");
+	nameTrack(TotalsTrack, "Component totals (all threads)");
+
+	// "Complete" events, with a start and a duration
+	for (const Event& event : events)
+	{
+		writer.StartObject();
+		writer.Key("name");
+		writer.String(event.mName);
+		writer.Key("ph");
+		writer.String("X");
+		writer.Key("ts");
+		writer.Double((event.mStart - mCaptureStart) * usPerTick);
+		writer.Key("dur");
+		writer.Double((event.mEnd - event.mStart) * usPerTick);
+		writer.Key("pid");
+		writer.Int(1);
+		writer.Key("tid");
+		writer.Int(event.mTrack);
+		if (!event.mDetail.empty())
+		{
+			writer.Key("args");
+			writer.StartObject();
+			writer.Key("detail");
+			writer.String(event.mDetail.c_str());
+			writer.EndObject();
+		}
+		writer.EndObject();
+	}
+
+	writer.EndArray();
+	writer.EndObject();
+
+	std::ofstream outFile(mFileName);
+	if (outFile.is_open())
+	{
+		outFile << buffer.GetString();
+		SDL_Log("Wrote %d profiler events to %s",
+			static_cast<int>(events.size()), mFileName.c_str());
+	}
+	else
+	{
+		SDL_Log("Failed to write profile %s", mFileName.c_str());
+	}
+}
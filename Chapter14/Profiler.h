@@ -0,0 +1,162 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records timed events for a number of frames and writes them out as
+// a Chrome trace (open it in chrome://tracing or ui.perfetto.dev).
+// Outside a capture the markers only check one flag.
+class Profiler
+{
+public:
+	// The one profiler
+	static Profiler& Get();
+
+	// Captures the next numFrames frames to fileName
+	void StartCapture(int numFrames, const std::string& fileName);
+	bool IsCapturing() const { return mCapturing.load(std::memory_order_relaxed); }
+
+	// Called by Game around every frame (on the main thread)
+	void BeginFrame();
+	void EndFrame();
+
+	// High resolution timer (in nanoseconds)
+	static uint64_t GetTime();
+
+	// Tracks that aren't threads
+	static const int GpuTrack = 1000;
+	static const int TotalsTrack = 1001;
+
+	// Adds a finished CPU event (safe from any thread). Events on one
+	// track nest by time, so a scope inside another shows up under it.
+	// (name has to outlive the capture, detail is copied)
+	void AddEvent(const char* name, uint64_t start, uint64_t end,
+		const char* detail = nullptr);
+	// Adds an event to one of the tracks above
+	void AddTrackEvent(int track, const char* name, uint64_t start, uint64_t end);
+
+	// Times GPU work between Begin and End with a GL_TIME_ELAPSED
+	// query. These can't nest (GL only allows one query of the type
+	// at a time), so Begin returns false if one's already running.
+	// Main thread only.
+	bool BeginGpuEvent(const char* name);
+	void EndGpuEvent();
+private:
+	Profiler();
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	// Small ID for the calling thread (the first caller is the main thread)
+	int GetThreadID();
+	// Turns finished GPU queries into events (waits for them all if wait)
+	void ResolveGpuEvents(bool wait);
+	void WriteTrace();
+
+	struct Event
+	{
+		const char* mName;
+		std::string mDetail;
+		uint64_t mStart;
+		uint64_t mEnd;
+		int mTrack;
+	};
+
+	struct GpuEvent
+	{
+		const char* mName;
+		unsigned int mQuery;
+		// CPU time the commands were issued at (GPU timings
+		// only give a duration, so it's placed from here)
+		uint64_t mStart;
+	};
+
+	std::atomic<bool> mCapturing;
+	std::mutex mMutex;
+	std::vector<Event> mEvents;
+	std::atomic<int> mNextThreadID;
+
+	// Queries waiting for results, and ones free for reuse
+	std::vector<GpuEvent> mPendingGpu;
+	std::vector<unsigned int> mFreeQueries;
+	bool mGpuActive;
+
+	std::string mFileName;
+	uint64_t mCaptureStart;
+	uint64_t mFrameStart;
+	int mFramesLeft;
+	// Set by StartCapture, so the capture starts on a frame boundary
+	int mFramesRequested;
+};
+
+// Adds an event covering the lifetime of the scope
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name, const char* detail = nullptr)
+		:mName(name)
+		,mDetail(detail)
+		,mStart(0)
+		,mActive(Profiler::Get().IsCapturing())
+	{
+		if (mActive)
+		{
+			mStart = Profiler::GetTime();
+		}
+	}
+	~ProfileScope()
+	{
+		if (mActive)
+		{
+			Profiler::Get().AddEvent(mName, mStart, Profiler::GetTime(), mDetail);
+		}
+	}
+private:
+	const char* mName;
+	const char* mDetail;
+	uint64_t mStart;
+	bool mActive;
+};
+
+// Adds a CPU event and a GPU event for the scope
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(const char* name)
+		:mCpuScope(name)
+		,mGpuActive(false)
+	{
+		if (Profiler::Get().IsCapturing())
+		{
+			mGpuActive = Profiler::Get().BeginGpuEvent(name);
+		}
+	}
+	~GpuProfileScope()
+	{
+		if (mGpuActive)
+		{
+			Profiler::Get().EndGpuEvent();
+		}
+	}
+private:
+	ProfileScope mCpuScope;
+	bool mGpuActive;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing scope
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+// Same, with extra text (like a file name) shown with the event
+#define PROFILE_SCOPE_DETAIL(name, detail) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, detail)
+// Times the rest of the enclosing scope on the CPU and the GPU
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
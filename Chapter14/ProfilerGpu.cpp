@@ -0,0 +1,109 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// The frame and GPU query half of Profiler, kept apart from
+// Profiler.cpp so code that only adds CPU events doesn't need GL
+
+#include "Profiler.h"
+#include <GL/glew.h>
+
+void Profiler::BeginFrame()
+{
+	if (mFramesRequested > 0)
+	{
+		// Make sure the main thread is thread 0
+		GetThreadID();
+		{
+			// Worker threads can still be adding events from
+			// scopes that started in the last capture
+			std::lock_guard<std::mutex> lock(mMutex);
+			mEvents.clear();
+		}
+		mFramesLeft = mFramesRequested;
+		mFramesRequested = 0;
+		mCaptureStart = GetTime();
+		mCapturing = true;
+	}
+	mFrameStart = GetTime();
+}
+
+void Profiler::EndFrame()
+{
+	if (!mCapturing)
+	{
+		return;
+	}
+	AddEvent("Frame", mFrameStart, GetTime());
+	ResolveGpuEvents(false);
+
+	mFramesLeft--;
+	if (mFramesLeft <= 0)
+	{
+		mCapturing = false;
+		ResolveGpuEvents(true);
+		WriteTrace();
+		std::lock_guard<std::mutex> lock(mMutex);
+		mEvents.clear();
+	}
+}
+
+bool Profiler::BeginGpuEvent(const char* name)
+{
+	if (mGpuActive)
+	{
+		return false;
+	}
+
+	GpuEvent event;
+	event.mName = name;
+	event.mStart = GetTime();
+	if (mFreeQueries.empty())
+	{
+		glGenQueries(1, &event.mQuery);
+	}
+	else
+	{
+		event.mQuery = mFreeQueries.back();
+		mFreeQueries.pop_back();
+	}
+	glBeginQuery(GL_TIME_ELAPSED, event.mQuery);
+	mGpuActive = true;
+	mPendingGpu.emplace_back(event);
+	return true;
+}
+
+void Profiler::EndGpuEvent()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	mGpuActive = false;
+}
+
+void Profiler::ResolveGpuEvents(bool wait)
+{
+	// Queries finish in order, so stop at the first one that isn't done
+	size_t done = 0;
+	for (; done < mPendingGpu.size(); done++)
+	{
+		GpuEvent& event = mPendingGpu[done];
+		if (!wait)
+		{
+			GLuint available = 0;
+			glGetQueryObjectuiv(event.mQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				break;
+			}
+		}
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(event.mQuery, GL_QUERY_RESULT, &elapsed);
+		// (GL and GetTime both count nanoseconds)
+		AddTrackEvent(GpuTrack, event.mName, event.mStart, event.mStart + elapsed);
+		mFreeQueries.emplace_back(event.mQuery);
+	}
+	mPendingGpu.erase(mPendingGpu.begin(), mPendingGpu.begin() + done);
+}
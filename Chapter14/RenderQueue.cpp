@@ -0,0 +1,124 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "VertexArray.h"
+#include "Mesh.h"
+#include "MeshComponent.h"
+#include "InstanceBatch.h"
+#include <algorithm>
+#include <GL/glew.h>
+
+RenderQueue::RenderQueue()
+{
+}
+
+void RenderQueue::Clear()
+{
+	mCommands.clear();
+}
+
+uint64_t RenderQueue::MakeKey(Pass pass, unsigned int shader,
+	unsigned int texture, unsigned int vertexArray, float depth)
+{
+	// OpenGL object names are small integers, so the low bits are
+	// enough to group draws (a clash just means a worse order)
+	const uint64_t depthBits = (1 << 20) - 1;
+	uint64_t quantDepth = static_cast<uint64_t>(
+		Math::Clamp(depth, 0.0f, 1.0f) * depthBits);
+	return (static_cast<uint64_t>(pass & 0xF) << 60) |
+		(static_cast<uint64_t>(shader & 0xFF) << 52) |
+		(static_cast<uint64_t>(texture & 0xFFFF) << 36) |
+		(static_cast<uint64_t>(vertexArray & 0xFFFF) << 20) |
+		quantDepth;
+}
+
+void RenderQueue::Submit(Pass pass, Shader* shader, MeshComponent* mesh, float depth)
+{
+	Command cmd;
+	cmd.mShader = shader;
+	cmd.mTexture = mesh->GetTexture();
+	cmd.mVertexArray = mesh->GetMesh()->GetVertexArray();
+	cmd.mMesh = mesh;
+	cmd.mBatch = nullptr;
+	cmd.mKey = MakeKey(pass, shader->GetProgramID(),
+		cmd.mTexture ? cmd.mTexture->GetTextureID() : 0,
+		cmd.mVertexArray->GetArrayID(), depth);
+	mCommands.emplace_back(cmd);
+}
+
+void RenderQueue::Submit(Pass pass, Shader* shader, InstanceBatch* batch, float depth)
+{
+	Command cmd;
+	cmd.mShader = shader;
+	cmd.mTexture = batch->GetTexture();
+	cmd.mVertexArray = batch->GetMesh()->GetVertexArray();
+	cmd.mMesh = nullptr;
+	cmd.mBatch = batch;
+	cmd.mKey = MakeKey(pass, shader->GetProgramID(),
+		cmd.mTexture ? cmd.mTexture->GetTextureID() : 0,
+		cmd.mVertexArray->GetArrayID(), depth);
+	mCommands.emplace_back(cmd);
+}
+
+void RenderQueue::Sort()
+{
+	std::sort(mCommands.begin(), mCommands.end(),
+		[](const Command& a, const Command& b) {
+			return a.mKey < b.mKey;
+	});
+}
+
+void RenderQueue::Execute(RenderStats& stats)
+{
+	// Other drawing code binds things too, so don't assume
+	// anything is bound at the start
+	Shader* currShader = nullptr;
+	Texture* currTexture = nullptr;
+	VertexArray* currVertexArray = nullptr;
+	for (const Command& cmd : mCommands)
+	{
+		if (cmd.mShader != currShader)
+		{
+			cmd.mShader->SetActive();
+			currShader = cmd.mShader;
+			stats.mShaderChanges++;
+		}
+		// Meshes without a texture use whatever is bound
+		// (same as MeshComponent::Draw)
+		if (cmd.mTexture && cmd.mTexture != currTexture)
+		{
+			cmd.mTexture->SetActive();
+			currTexture = cmd.mTexture;
+			stats.mTextureChanges++;
+		}
+		if (cmd.mVertexArray != currVertexArray)
+		{
+			cmd.mVertexArray->SetActive();
+			currVertexArray = cmd.mVertexArray;
+			stats.mVertexArrayChanges++;
+		}
+		if (cmd.mBatch)
+		{
+			// World transforms come from the instance buffer
+			static const UniformHandle specPower("uSpecPower");
+			cmd.mShader->SetFloatUniform(specPower, cmd.mBatch->GetMesh()->GetSpecPower());
+			cmd.mBatch->Draw();
+		}
+		else
+		{
+			cmd.mMesh->SetUniforms(cmd.mShader);
+			glDrawElements(GL_TRIANGLES, cmd.mVertexArray->GetNumIndices(),
+				GL_UNSIGNED_INT, nullptr);
+		}
+		stats.mDrawCalls++;
+	}
+}
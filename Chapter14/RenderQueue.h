@@ -0,0 +1,64 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Collects the mesh draws for a frame, sorts them so draws that
+// share a shader/texture/vertex array are next to each other, and
+// then issues them while skipping state that's already bound
+class RenderQueue
+{
+public:
+	// Passes are drawn in this order
+	enum Pass
+	{
+		EMeshPass,
+		EInstancedPass,
+		ESkinnedPass
+	};
+
+	RenderQueue();
+
+	// Remove all the draws (keeps the memory)
+	void Clear();
+	// Add a draw of the mesh component with this shader.
+	// depth is the normalized view depth [0, 1]. Closer meshes
+	// draw first, so later ones can fail the depth test early.
+	void Submit(Pass pass, class Shader* shader,
+		class MeshComponent* mesh, float depth);
+	// Add one instanced draw of every mesh in the batch
+	void Submit(Pass pass, class Shader* shader,
+		class InstanceBatch* batch, float depth);
+	// Sort the draws by their keys
+	void Sort();
+	// Issue every draw. Adds the number of draws and state
+	// changes made to stats
+	void Execute(struct RenderStats& stats);
+
+	size_t GetNumDraws() const { return mCommands.size(); }
+
+	// Key layout, from the most significant bits:
+	// pass (4), shader (8), texture (16), vertex array (16), depth (20)
+	static uint64_t MakeKey(Pass pass, unsigned int shader,
+		unsigned int texture, unsigned int vertexArray, float depth);
+private:
+	struct Command
+	{
+		uint64_t mKey;
+		class Shader* mShader;
+		class Texture* mTexture;
+		class VertexArray* mVertexArray;
+		// One of these is set
+		class MeshComponent* mMesh;
+		class InstanceBatch* mBatch;
+	};
+	std::vector<Command> mCommands;
+};
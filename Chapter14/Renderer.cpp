@@ -20,17 +20,78 @@
 #include "SkeletalMeshComponent.h"
 #include "GBuffer.h"
 #include "PointLightComponent.h"
+#include "Frustum.h"
+#include "UniformBuffer.h"
+#include "InstanceBatch.h"
+#include "Actor.h"
+#include "JobSystem.h"
+#include <atomic>
+#include "Profiler.h"
+#include "AssetLoader.h"
+#include "SpriteBatch.h"
+#include "LevelLoader.h"
+#include "LightClusters.h"
+#include <fstream>
+
+namespace
+{
+	// Uniform buffer binding point of the FrameData block
+	const unsigned int FrameDataBinding = 0;
+
+	// Matches the std140 layout of the FrameData block in
+	// Shaders/FrameData.glsl (vec3s take up 16 bytes)
+	struct FrameUniforms
+	{
+		Matrix4 mViewProj;
+		Vector3 mCameraPos;
+		float mPad0;
+		Vector3 mAmbientLight;
+		float mPad1;
+		// DirectionalLight struct
+		Vector3 mDirDirection;
+		float mPad2;
+		Vector3 mDirDiffuseColor;
+		float mPad3;
+		Vector3 mDirSpecColor;
+		float mPad4;
+	};
+	static_assert(sizeof(FrameUniforms) == 144, "FrameUniforms must match std140 layout");
+
+	// Has to match the version AtlasPacker writes
+	const int AtlasVersion = 1;
+
+	// Texture units of the clustered light buffers (after the
+	// three G-buffer textures)
+	const int LightDataUnit = 3;
+	const int LightGridUnit = 4;
+	const int LightIndexUnit = 5;
+}
 
 Renderer::Renderer(Game* game)
-	:mGame(game)
+	:mSpritesDirty(false)
+	,mGame(game)
 	,mSpriteShader(nullptr)
+	,mSpriteVerts(nullptr)
+	,mSpriteBatch(nullptr)
 	,mMeshShader(nullptr)
 	,mSkinnedShader(nullptr)
+	,mInstancedShader(nullptr)
+	,mNearPlane(10.0f)
+	,mFarPlane(10000.0f)
 	,mMirrorBuffer(0)
 	,mMirrorTexture(nullptr)
 	,mGBuffer(nullptr)
+	,mCompactGBuffer(true)
 	,mGGlobalShader(nullptr)
 	,mGPointLightShader(nullptr)
+	,mFrameBuffer(nullptr)
+	,mLightClusters(nullptr)
+	,mClusteredLights(true)
+	,mNumCullStatic(0)
+	,mFrustumCulling(true)
+	,mSortRenderQueue(true)
+	,mInstancing(true)
+	,mHeadless(false)
 {
 }
 
@@ -90,8 +151,12 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 		return false;
 	}
 
-	// Create quad for drawing sprites
+	// Create quad for drawing from the G-buffer, and the
+	// batch all the 2D quads go through
 	CreateSpriteVerts();
+	mSpriteBatch = new SpriteBatch();
+	// Load the UI atlas made by -atlas, if there is one
+	LoadAtlas("Assets/UI.gpatlas");
 
 	// Create render target for mirror
 	//if (!CreateMirrorTarget())
@@ -101,23 +166,40 @@ bool Renderer::Initialize(float screenWidth, float screenHeight)
 	//}
 	
 	// Create G-buffer
-	mGBuffer = new GBuffer();
-	int width = static_cast<int>(mScreenWidth);
-	int height = static_cast<int>(mScreenHeight);
-	if (!mGBuffer->Create(width, height))
+	if (!CreateGBuffer())
 	{
 		SDL_Log("Failed to create G-buffer.");
 		return false;
 	}
 
-	// Load point light mesh
+	// Load point light mesh (for the per-light path)
 	mPointLightMesh = GetMesh("Assets/PointLight.gpmesh");
+	CreateLightBuffers();
 
 	return true;
 }
 
+void Renderer::InitializeHeadless(float screenWidth, float screenHeight)
+{
+	mHeadless = true;
+	mScreenWidth = screenWidth;
+	mScreenHeight = screenHeight;
+	// The camera components still set the view, and the animation
+	// LOD uses the projection
+	mView = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
+	mProjection = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
+		mScreenWidth, mScreenHeight, mNearPlane, mFarPlane);
+	mWindow = nullptr;
+	mContext = nullptr;
+}
+
 void Renderer::Shutdown()
 {
+	if (mHeadless)
+	{
+		return;
+	}
+
 	// Get rid of any render target textures, if they exist
 	if (mMirrorTexture != nullptr)
 	{
@@ -132,25 +214,43 @@ void Renderer::Shutdown()
 		delete mGBuffer;
 	}
 	// Delete point lights
-	while (!mPointLights.empty())
+	while (!mPointLights.Empty())
 	{
-		delete mPointLights.back();
+		delete mPointLights.GetValues().back();
 	}
+	glDeleteTextures(3, mLightTextures);
+	glDeleteBuffers(3, mLightBuffers);
+	delete mLightClusters;
 	delete mSpriteVerts;
+	delete mSpriteBatch;
 	mSpriteShader->Unload();
 	delete mSpriteShader;
 	mMeshShader->Unload();
 	delete mMeshShader;
+	mInstancedShader->Unload();
+	delete mInstancedShader;
+	delete mFrameBuffer;
 	SDL_GL_DeleteContext(mContext);
 	SDL_DestroyWindow(mWindow);
 }
 
 void Renderer::UnloadData()
 {
-	// Destroy textures
+	// Destroy instance batches (they use the meshes)
+	for (auto i : mInstanceBatches)
+	{
+		delete i.second;
+	}
+	mInstanceBatches.clear();
+	mVisibleBatches.clear();
+
+	// Destroy textures (headless ones were never loaded)
 	for (auto i : mTextures)
 	{
-		i.second->Unload();
+		if (!mHeadless)
+		{
+			i.second->Unload();
+		}
 		delete i.second;
 	}
 	mTextures.clear();
@@ -166,117 +266,141 @@ void Renderer::UnloadData()
 
 void Renderer::Draw()
 {
+	if (mHeadless)
+	{
+		return;
+	}
+	PROFILE_SCOPE("Renderer::Draw");
+	mStats = RenderStats();
 	// Draw to the mirror texture first
 	//Draw3DScene(mMirrorBuffer, mMirrorView, mProjection);
 	// Draw the 3D scene to the G-buffer
-	Draw3DScene(mGBuffer->GetBufferID(), mView, mProjection, false);
+	Draw3DScene(mGBuffer->GetBufferID(), mView, mProjection);
 	// Set the frame buffer back to zero (screen's frame buffer)
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	// Draw from the GBuffer
 	DrawFromGBuffer();
 	
-	// Draw all sprite components
-	// Disable depth buffering
-	glDisable(GL_DEPTH_TEST);
-	// Enable alpha blending on the color buffer
-	glEnable(GL_BLEND);
-	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
-
-	// Set shader/vao as active
-	mSpriteShader->SetActive();
-	mSpriteVerts->SetActive();
-	for (auto sprite : mSprites)
+	// Collect the sprite components, then any UI screens
+	// on top, and draw them together
+	mSpriteBatch->Begin();
+	DrawSprites();
 	{
-		if (sprite->GetVisible())
+		PROFILE_SCOPE("Renderer::DrawUI");
+		for (auto ui : mGame->GetUIStack())
 		{
-			sprite->Draw(mSpriteShader);
+			ui->Draw(mSpriteBatch);
 		}
 	}
-	
-	// Draw any UI screens
-	for (auto ui : mGame->GetUIStack())
 	{
-		ui->Draw(mSpriteShader);
+		PROFILE_GPU_SCOPE("SpriteBatch::End");
+		mSpriteBatch->End();
 	}
+	mStats.mSpriteQuads = mSpriteBatch->GetNumQuads();
+	mStats.mSpriteDrawCalls = mSpriteBatch->GetNumDrawCalls();
 
 	// Swap the buffers
+	PROFILE_SCOPE("SDL_GL_SwapWindow");
 	SDL_GL_SwapWindow(mWindow);
 }
 
-void Renderer::AddSprite(SpriteComponent* sprite)
+void Renderer::DrawSprites()
 {
-	// Find the insertion point in the sorted vector
-	// (The first element with a higher draw order than me)
-	int myDrawOrder = sprite->GetDrawOrder();
-	auto iter = mSprites.begin();
-	for (;
-		iter != mSprites.end();
-		++iter)
+	PROFILE_SCOPE("Renderer::DrawSprites");
+	// Disable depth buffering
+	glDisable(GL_DEPTH_TEST);
+	// Enable alpha blending on the color buffer
+	glEnable(GL_BLEND);
+	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+
+	mSpriteShader->SetActive();
+	if (mSpritesDirty)
+	{
+		// Sort by draw order (equal orders keep their relative order)
+		mSortedSprites = mSprites.GetValues();
+		std::stable_sort(mSortedSprites.begin(), mSortedSprites.end(),
+			[](const SpriteComponent* a, const SpriteComponent* b) {
+			return a->GetDrawOrder() < b->GetDrawOrder();
+		});
+		mSpritesDirty = false;
+	}
+	for (auto sprite : mSortedSprites)
 	{
-		if (myDrawOrder < (*iter)->GetDrawOrder())
+		if (sprite->GetVisible())
 		{
-			break;
+			sprite->Draw(mSpriteBatch);
 		}
 	}
+}
 
-	// Inserts element before position of iterator
-	mSprites.insert(iter, sprite);
+SlotHandle Renderer::AddSprite(SpriteComponent* sprite)
+{
+	// Sorted by draw order the next time sprites are drawn
+	mSpritesDirty = true;
+	return mSprites.Insert(sprite);
 }
 
-void Renderer::RemoveSprite(SpriteComponent* sprite)
+void Renderer::RemoveSprite(SlotHandle handle)
 {
-	auto iter = std::find(mSprites.begin(), mSprites.end(), sprite);
-	mSprites.erase(iter);
+	if (mSprites.Remove(handle))
+	{
+		mSpritesDirty = true;
+	}
 }
 
-void Renderer::AddMeshComp(MeshComponent* mesh)
+SlotHandle Renderer::AddMeshComp(MeshComponent* mesh)
 {
 	if (mesh->GetIsSkeletal())
 	{
 		SkeletalMeshComponent* sk = static_cast<SkeletalMeshComponent*>(mesh);
-		mSkeletalMeshes.emplace_back(sk);
-	}
-	else
-	{
-		mMeshComps.emplace_back(mesh);
+		return mSkeletalMeshes.Insert(sk);
 	}
+	return mMeshComps.Insert(mesh);
 }
 
-void Renderer::RemoveMeshComp(MeshComponent* mesh)
+void Renderer::RemoveMeshComp(MeshComponent* mesh, SlotHandle handle)
 {
 	if (mesh->GetIsSkeletal())
 	{
-		SkeletalMeshComponent* sk = static_cast<SkeletalMeshComponent*>(mesh);
-		auto iter = std::find(mSkeletalMeshes.begin(), mSkeletalMeshes.end(), sk);
-		mSkeletalMeshes.erase(iter);
+		mSkeletalMeshes.Remove(handle);
 	}
 	else
 	{
-		auto iter = std::find(mMeshComps.begin(), mMeshComps.end(), mesh);
-		mMeshComps.erase(iter);
+		mMeshComps.Remove(handle);
+		if (mesh->GetInstanceBatch())
+		{
+			mesh->GetInstanceBatch()->RemoveInstance(mesh);
+		}
 	}
 }
 
-void Renderer::AddPointLight(PointLightComponent * light)
+SlotHandle Renderer::AddPointLight(PointLightComponent* light)
 {
-	mPointLights.emplace_back(light);
+	return mPointLights.Insert(light);
 }
 
-void Renderer::RemovePointLight(PointLightComponent * light)
+void Renderer::RemovePointLight(SlotHandle handle)
 {
-	auto iter = std::find(mPointLights.begin(), mPointLights.end(), light);
-	mPointLights.erase(iter);
+	mPointLights.Remove(handle);
 }
 
 Texture* Renderer::GetTexture(const std::string& fileName)
 {
+	// A texture that's streaming in has to finish first
+	mGame->GetAssetLoader()->Wait(fileName);
 	Texture* tex = nullptr;
 	auto iter = mTextures.find(fileName);
 	if (iter != mTextures.end())
 	{
 		tex = iter->second;
 	}
+	else if (mHeadless)
+	{
+		// Nothing samples it, so an empty texture will do
+		tex = new Texture();
+		mTextures.emplace(fileName, tex);
+	}
 	else
 	{
 		tex = new Texture();
@@ -293,13 +417,102 @@ Texture* Renderer::GetTexture(const std::string& fileName)
 	return tex;
 }
 
+Texture* Renderer::GetTextureAsync(const std::string& fileName)
+{
+	if (mHeadless)
+	{
+		return GetTexture(fileName);
+	}
+	// Show the default texture until it's uploaded (and for good,
+	// if it fails to load). This is first, so a request for the
+	// default texture itself is already in the map below.
+	Texture* placeholder = GetTexture("Assets/Default.png");
+	auto iter = mTextures.find(fileName);
+	if (iter != mTextures.end())
+	{
+		return iter->second;
+	}
+
+	Texture* tex = new Texture();
+	if (placeholder)
+	{
+		tex->SetPlaceholder(fileName, placeholder);
+	}
+	mTextures.emplace(fileName, tex);
+	mGame->GetAssetLoader()->Load(fileName, [fileName, tex]() -> AssetLoader::FinishFunc {
+		std::shared_ptr<Texture::Image> image = Texture::Decode(fileName);
+		if (!image)
+		{
+			return nullptr;
+		}
+		return [tex, image]() { tex->Upload(*image); };
+	});
+	return tex;
+}
+
+bool Renderer::LoadAtlas(const std::string& fileName)
+{
+	if (mHeadless || !std::ifstream(fileName).good())
+	{
+		return false;
+	}
+	rapidjson::Document doc;
+	int version = 0;
+	if (!LevelLoader::LoadJSON(fileName, doc) ||
+		!JsonHelper::GetInt(doc, "version", version) || version != AtlasVersion ||
+		!doc["pages"].IsArray() || !doc["regions"].IsArray())
+	{
+		SDL_Log("Atlas %s is invalid, repack it with -atlas", fileName.c_str());
+		return false;
+	}
+
+	const rapidjson::Value& pagesJson = doc["pages"];
+	std::vector<Texture*> pages;
+	for (rapidjson::SizeType i = 0; i < pagesJson.Size(); i++)
+	{
+		pages.emplace_back(GetTexture(pagesJson[i].GetString()));
+	}
+
+	// Each region goes in the texture map under the image's own
+	// name, so GetTexture hands it out in place of the image
+	const rapidjson::Value& regions = doc["regions"];
+	for (rapidjson::SizeType i = 0; i < regions.Size(); i++)
+	{
+		const rapidjson::Value& region = regions[i];
+		std::string file;
+		int page = 0, x = 0, y = 0, width = 0, height = 0;
+		if (!JsonHelper::GetString(region, "file", file) ||
+			!JsonHelper::GetInt(region, "page", page) ||
+			page < 0 || page >= static_cast<int>(pages.size()) || !pages[page] ||
+			mTextures.find(file) != mTextures.end())
+		{
+			continue;
+		}
+		JsonHelper::GetInt(region, "x", x);
+		JsonHelper::GetInt(region, "y", y);
+		JsonHelper::GetInt(region, "width", width);
+		JsonHelper::GetInt(region, "height", height);
+		Texture* tex = new Texture();
+		tex->SetAtlasRegion(file, pages[page], x, y, width, height);
+		mTextures.emplace(file, tex);
+	}
+	return true;
+}
+
 Mesh* Renderer::GetMesh(const std::string & fileName)
 {
+	// A mesh that's streaming in has to finish first
+	mGame->GetAssetLoader()->Wait(fileName);
 	Mesh* m = nullptr;
 	auto iter = mMeshes.find(fileName);
 	if (iter != mMeshes.end())
 	{
 		m = iter->second;
+		// (It never loads if it was streamed and failed)
+		if (!m->IsLoaded())
+		{
+			m = nullptr;
+		}
 	}
 	else
 	{
@@ -317,8 +530,31 @@ Mesh* Renderer::GetMesh(const std::string & fileName)
 	return m;
 }
 
-void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj, bool lit)
+Mesh* Renderer::GetMeshAsync(const std::string& fileName)
+{
+	auto iter = mMeshes.find(fileName);
+	if (iter != mMeshes.end())
+	{
+		return iter->second;
+	}
+
+	// The mesh isn't drawn until Create runs
+	Mesh* m = new Mesh();
+	mMeshes.emplace(fileName, m);
+	mGame->GetAssetLoader()->Load(fileName, [this, fileName, m]() -> AssetLoader::FinishFunc {
+		std::shared_ptr<Mesh::FileData> data = Mesh::ReadFile(fileName);
+		if (!data)
+		{
+			return nullptr;
+		}
+		return [this, fileName, m, data]() { m->Create(fileName, *data, this, true); };
+	});
+	return m;
+}
+
+void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj)
 {
+	PROFILE_GPU_SCOPE("Renderer::Draw3DScene");
 	// Set the current frame buffer
 	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 	// Clear color buffer/depth buffer
@@ -330,41 +566,176 @@ void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const
 	// Enable depth buffering/disable alpha blend
 	glEnable(GL_DEPTH_TEST);
 	glDisable(GL_BLEND);
-	// Set the mesh shader active
-	mMeshShader->SetActive();
-	// Update view-projection matrix
-	mMeshShader->SetMatrixUniform("uViewProj", view * proj);
-	// Update lighting uniforms
-	if (lit)
+	// Skip meshes that are outside the view frustum
+	CullMeshes(view * proj);
+	// Upload the view-projection and lights once,
+	// every 3D shader reads them from the uniform buffer
+	UpdateFrameUniforms(view, proj);
+
+	// Queue up the meshes that weren't culled
+	mRenderQueue.Clear();
+	for (InstanceBatch* batch : mVisibleBatches)
 	{
-		SetLightUniforms(mMeshShader, view);
+		float depth = Vector3::Transform(batch->GetCenter(), view).z / mFarPlane;
+		mRenderQueue.Submit(RenderQueue::EInstancedPass, mInstancedShader,
+			batch, depth);
 	}
-	for (auto mc : mMeshComps)
+	for (size_t i = 0; i < mCullMeshes.size(); i++)
 	{
-		if (mc->GetVisible())
+		if (mCullVisible[i])
 		{
-			mc->Draw(mMeshShader);
+			// View space depth of the mesh's center
+			Vector3 center(mCullX[i], mCullY[i], mCullZ[i]);
+			float depth = Vector3::Transform(center, view).z / mFarPlane;
+			if (i < mNumCullStatic)
+			{
+				mRenderQueue.Submit(RenderQueue::EMeshPass, mMeshShader,
+					mCullMeshes[i], depth);
+			}
+			else
+			{
+				mRenderQueue.Submit(RenderQueue::ESkinnedPass, mSkinnedShader,
+					mCullMeshes[i], depth);
+			}
 		}
 	}
+	if (mSortRenderQueue)
+	{
+		mRenderQueue.Sort();
+	}
+	mRenderQueue.Execute(mStats);
+}
 
-	// Draw any skinned meshes now
-	mSkinnedShader->SetActive();
-	// Update view-projection matrix
-	mSkinnedShader->SetMatrixUniform("uViewProj", view * proj);
-	// Update lighting uniforms
-	if (lit)
+void Renderer::CullMeshes(const Matrix4& viewProj)
+{
+	// Gather the bounds of every visible mesh
+	mCullMeshes.clear();
+	mCullX.clear();
+	mCullY.clear();
+	mCullZ.clear();
+	mCullRadius.clear();
+	auto addMesh = [this](MeshComponent* mc) {
+		if (mc->GetVisible() && mc->GetMesh() && mc->GetMesh()->IsLoaded())
+		{
+			// The mesh radius is from the object space origin,
+			// so scale it by the largest axis of the world transform
+			const Matrix4& world = mc->GetOwner()->GetRenderTransform();
+			Vector3 center = world.GetTranslation();
+			Vector3 scale = world.GetScale();
+			float maxScale = Math::Max(scale.x, Math::Max(scale.y, scale.z));
+			mCullMeshes.emplace_back(mc);
+			mCullX.emplace_back(center.x);
+			mCullY.emplace_back(center.y);
+			mCullZ.emplace_back(center.z);
+			mCullRadius.emplace_back(mc->GetMesh()->GetRadius() * maxScale);
+		}
+	};
+	for (auto mc : mMeshComps)
 	{
-		SetLightUniforms(mSkinnedShader, view);
+		// Instanced meshes are culled by their batch below
+		if (UpdateInstanceBatch(mc))
+		{
+			continue;
+		}
+		addMesh(mc);
 	}
+	mNumCullStatic = mCullMeshes.size();
 	for (auto sk : mSkeletalMeshes)
 	{
-		if (sk->GetVisible())
+		addMesh(sk);
+	}
+
+	size_t count = mCullMeshes.size();
+	mCullVisible.resize(count);
+	size_t numVisible = count;
+	Frustum frustum(viewProj);
+	if (!mFrustumCulling)
+	{
+		std::fill(mCullVisible.begin(), mCullVisible.end(), 1);
+	}
+	else
+	{
+		// Waking the workers isn't worth it unless there's a lot to cull
+		const size_t minPerRange = 4096;
+		JobSystem* jobs = mGame->GetJobSystem();
+		if (jobs == nullptr || count < minPerRange * 2)
+		{
+			numVisible = frustum.CullSpheres(mCullX.data(), mCullY.data(),
+				mCullZ.data(), mCullRadius.data(), count, mCullVisible.data());
+		}
+		else
+		{
+			// Split into groups of four spheres, so every range
+			// stays on the SIMD path
+			size_t numGroups = (count + 3) / 4;
+			std::atomic<size_t> visible(0);
+			jobs->ParallelFor(numGroups, minPerRange / 4,
+				[this, &frustum, &visible, count](size_t begin, size_t end)
+			{
+				size_t start = begin * 4;
+				size_t num = Math::Min(count, end * 4) - start;
+				visible += frustum.CullSpheres(mCullX.data() + start,
+					mCullY.data() + start, mCullZ.data() + start,
+					mCullRadius.data() + start, num, mCullVisible.data() + start);
+			});
+			numVisible = visible;
+		}
+	}
+
+	mStats.mMeshesDrawn += static_cast<int>(numVisible);
+	mStats.mMeshesCulled += static_cast<int>(count - numVisible);
+
+	// Instances are culled one at a time too, and each batch
+	// only uploads and draws its visible instances
+	mVisibleBatches.clear();
+	for (auto& iter : mInstanceBatches)
+	{
+		InstanceBatch* batch = iter.second;
+		size_t numInstances = batch->GetNumInstances();
+		if (numInstances == 0)
+		{
+			continue;
+		}
+		size_t numVisible = batch->Cull(mFrustumCulling ? &frustum : nullptr);
+		if (numVisible > 0)
 		{
-			sk->Draw(mSkinnedShader);
+			mVisibleBatches.emplace_back(batch);
 		}
+		mStats.mMeshesDrawn += static_cast<int>(numVisible);
+		mStats.mMeshesCulled += static_cast<int>(numInstances - numVisible);
 	}
 }
 
+bool Renderer::UpdateInstanceBatch(MeshComponent* mc)
+{
+	InstanceBatch* batch = mc->GetInstanceBatch();
+	bool instanced = mInstancing && mc->GetVisible() && mc->GetMesh() &&
+		mc->GetMesh()->IsLoaded();
+	// Leave the batch if it's hidden or its mesh/texture changed
+	if (batch && (!instanced || batch->GetMesh() != mc->GetMesh() ||
+		batch->GetTextureIndex() != mc->GetTextureIndex()))
+	{
+		batch->RemoveInstance(mc);
+		batch = nullptr;
+	}
+	if (instanced && !batch)
+	{
+		auto key = std::make_pair(mc->GetMesh(), mc->GetTextureIndex());
+		auto iter = mInstanceBatches.find(key);
+		if (iter != mInstanceBatches.end())
+		{
+			batch = iter->second;
+		}
+		else
+		{
+			batch = new InstanceBatch(mc->GetMesh(), mc->GetTextureIndex());
+			mInstanceBatches.emplace(key, batch);
+		}
+		batch->AddInstance(mc);
+	}
+	return instanced;
+}
+
 bool Renderer::CreateMirrorTarget()
 {
 	// Generate a frame buffer for the mirror texture
@@ -407,6 +778,12 @@ bool Renderer::CreateMirrorTarget()
 
 void Renderer::DrawFromGBuffer()
 {
+	if (mClusteredLights)
+	{
+		UpdateLightClusters();
+	}
+
+	PROFILE_GPU_SCOPE("Renderer::DrawFromGBuffer");
 	// Clear the current framebuffer
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -415,14 +792,40 @@ void Renderer::DrawFromGBuffer()
 	glDisable(GL_DEPTH_TEST);
 	// Activate global G-buffer shader
 	mGGlobalShader->SetActive();
+	// The compact G-buffer rebuilds world positions from depth
+	Matrix4 invViewProj = mView * mProjection;
+	invViewProj.Invert();
+	static const UniformHandle invViewProjHandle("uInvViewProj");
+	mGGlobalShader->SetMatrixUniform(invViewProjHandle, invViewProj);
+	static const UniformHandle clustered("uClustered");
+	mGGlobalShader->SetIntUniform(clustered, mClusteredLights ? 1 : 0);
+	if (mClusteredLights)
+	{
+		// The shader finds each pixel's cluster from its view depth
+		static const UniformHandle view("uView");
+		static const UniformHandle slice("uClusterSlice");
+		mGGlobalShader->SetMatrixUniform(view, mView);
+		mGGlobalShader->SetVector2Uniform(slice, Vector2(
+			mLightClusters->GetSliceScale(), mLightClusters->GetSliceBias()));
+		for (int i = 0; i < 3; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + LightDataUnit + i);
+			glBindTexture(GL_TEXTURE_BUFFER, mLightTextures[i]);
+		}
+	}
 	// Activate sprite verts quad
 	mSpriteVerts->SetActive();
 	// Set the G-buffer textures to sample
+	// (lighting uniforms are in the per-frame uniform buffer)
 	mGBuffer->SetTexturesActive();
-	// Set the lighting uniforms
-	SetLightUniforms(mGGlobalShader, mView);
 	// Draw the triangles
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	if (mClusteredLights)
+	{
+		// The point lights were shaded in that pass too
+		return;
+	}
+	mStats.mPointLights = static_cast<int>(mPointLights.Size());
 
 	// Copy depth buffer from G-buffer to default frame buffer
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, mGBuffer->GetBufferID());
@@ -438,10 +841,8 @@ void Renderer::DrawFromGBuffer()
 
 	// Set the point light shader and mesh as active
 	mGPointLightShader->SetActive();
+	mGPointLightShader->SetMatrixUniform(invViewProjHandle, invViewProj);
 	mPointLightMesh->GetVertexArray()->SetActive();
-	// Set the view-projeciton matrix
-	mGPointLightShader->SetMatrixUniform("uViewProj",
-		mView * mProjection);
 	// Set the G-buffer textures for sampling
 	mGBuffer->SetTexturesActive();
 
@@ -456,6 +857,50 @@ void Renderer::DrawFromGBuffer()
 	}
 }
 
+bool Renderer::CreateGBuffer()
+{
+	if (mGBuffer != nullptr)
+	{
+		mGBuffer->Destroy();
+		delete mGBuffer;
+	}
+	mGBuffer = new GBuffer();
+	int width = static_cast<int>(mScreenWidth);
+	int height = static_cast<int>(mScreenHeight);
+	if (!mGBuffer->Create(width, height, mCompactGBuffer))
+	{
+		delete mGBuffer;
+		mGBuffer = nullptr;
+		return false;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Every shader that writes or reads the G-buffer has to
+	// know which layout it's in
+	static const UniformHandle compact("uCompactGBuffer");
+	Shader* shaders[] = { mMeshShader, mSkinnedShader, mInstancedShader,
+		mGGlobalShader, mGPointLightShader };
+	for (Shader* shader : shaders)
+	{
+		shader->SetActive();
+		shader->SetIntUniform(compact, mCompactGBuffer ? 1 : 0);
+	}
+	return true;
+}
+
+void Renderer::SetCompactGBuffer(bool compact)
+{
+	if (compact == mCompactGBuffer)
+	{
+		return;
+	}
+	mCompactGBuffer = compact;
+	if (mGBuffer != nullptr && !CreateGBuffer())
+	{
+		SDL_Log("Failed to create G-buffer.");
+	}
+}
+
 bool Renderer::LoadShaders()
 {
 	// Create sprite shader
@@ -477,12 +922,12 @@ bool Renderer::LoadShaders()
 		return false;
 	}
 
-	mMeshShader->SetActive();
-	// Set the view-projection matrix
+	// The view-projection matrix and lights come from the
+	// per-frame uniform buffer
+	mMeshShader->BindUniformBlock("FrameData", FrameDataBinding);
 	mView = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
 	mProjection = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
-		mScreenWidth, mScreenHeight, 10.0f, 10000.0f);
-	mMeshShader->SetMatrixUniform("uViewProj", mView * mProjection);
+		mScreenWidth, mScreenHeight, mNearPlane, mFarPlane);
 
 	// Create skinned shader
 	mSkinnedShader = new Shader();
@@ -491,8 +936,15 @@ bool Renderer::LoadShaders()
 		return false;
 	}
 
-	mSkinnedShader->SetActive();
-	mSkinnedShader->SetMatrixUniform("uViewProj", mView * mProjection);
+	mSkinnedShader->BindUniformBlock("FrameData", FrameDataBinding);
+
+	// Create instanced mesh shader
+	mInstancedShader = new Shader();
+	if (!mInstancedShader->Load("Shaders/PhongInstanced.vert", "Shaders/GBufferWrite.frag"))
+	{
+		return false;
+	}
+	mInstancedShader->BindUniformBlock("FrameData", FrameDataBinding);
 	
 	// Create shader for drawing from GBuffer (global lighting)
 	mGGlobalShader = new Shader();
@@ -505,12 +957,18 @@ bool Renderer::LoadShaders()
 	mGGlobalShader->SetIntUniform("uGDiffuse", 0);
 	mGGlobalShader->SetIntUniform("uGNormal", 1);
 	mGGlobalShader->SetIntUniform("uGWorldPos", 2);
+	mGGlobalShader->SetIntUniform("uClusterLights", LightDataUnit);
+	mGGlobalShader->SetIntUniform("uClusterGrid", LightGridUnit);
+	mGGlobalShader->SetIntUniform("uClusterIndices", LightIndexUnit);
+	mGGlobalShader->SetVector2Uniform("uScreenDimensions",
+		Vector2(mScreenWidth, mScreenHeight));
 	// The view projection is just the sprite one
 	mGGlobalShader->SetMatrixUniform("uViewProj", spriteViewProj);
 	// The world transform scales to the screen and flips y
 	Matrix4 gbufferWorld = Matrix4::CreateScale(mScreenWidth, -mScreenHeight,
 												1.0f);
 	mGGlobalShader->SetMatrixUniform("uWorldTransform", gbufferWorld);
+	mGGlobalShader->BindUniformBlock("FrameData", FrameDataBinding);
 	
 	// Create a shader for point lights from GBuffer
 	mGPointLightShader = new Shader();
@@ -526,6 +984,10 @@ bool Renderer::LoadShaders()
 	mGPointLightShader->SetIntUniform("uGWorldPos", 2);
 	mGPointLightShader->SetVector2Uniform("uScreenDimensions",
 		Vector2(mScreenWidth, mScreenHeight));
+	mGPointLightShader->BindUniformBlock("FrameData", FrameDataBinding);
+
+	// Buffer for the FrameData block
+	mFrameBuffer = new UniformBuffer(sizeof(FrameUniforms), FrameDataBinding);
 	return true;
 }
 
@@ -546,21 +1008,98 @@ void Renderer::CreateSpriteVerts()
 	mSpriteVerts = new VertexArray(vertices, 4, VertexArray::PosNormTex, indices, 6);
 }
 
-void Renderer::SetLightUniforms(Shader* shader, const Matrix4& view)
+void Renderer::UpdateFrameUniforms(const Matrix4& view, const Matrix4& proj)
 {
+	FrameUniforms frame;
+	frame.mViewProj = view * proj;
 	// Camera position is from inverted view
 	Matrix4 invView = view;
-	invView.Invert();
-	shader->SetVectorUniform("uCameraPos", invView.GetTranslation());
-	// Ambient light
-	shader->SetVectorUniform("uAmbientLight", mAmbientLight);
-	// Directional light
-	shader->SetVectorUniform("uDirLight.mDirection",
-		mDirLight.mDirection);
-	shader->SetVectorUniform("uDirLight.mDiffuseColor",
-		mDirLight.mDiffuseColor);
-	shader->SetVectorUniform("uDirLight.mSpecColor",
-		mDirLight.mSpecColor);
+	invView.InvertAffine();
+	frame.mCameraPos = invView.GetTranslation();
+	frame.mAmbientLight = mAmbientLight;
+	frame.mDirDirection = mDirLight.mDirection;
+	frame.mDirDiffuseColor = mDirLight.mDiffuseColor;
+	frame.mDirSpecColor = mDirLight.mSpecColor;
+	mFrameBuffer->Update(&frame);
+}
+
+void Renderer::CreateLightBuffers()
+{
+	mLightClusters = new LightClusters();
+	// Buffer textures only have to hold this many texels
+	int maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	mLightClusters->SetMaxIndices(static_cast<size_t>(maxTexels));
+
+	// Light data is two RGBA floats per light, the grid is an
+	// (offset, count) pair per cluster, and each index is a uint
+	const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	glGenBuffers(3, mLightBuffers);
+	glGenTextures(3, mLightTextures);
+	for (int i = 0; i < 3; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, mLightBuffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, mLightTextures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], mLightBuffers[i]);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void Renderer::UpdateLightClusters()
+{
+	PROFILE_SCOPE("Renderer::UpdateLightClusters");
+	// Gather the lights (interpolated, like the meshes)
+	const std::vector<PointLightComponent*>& lights = mPointLights.GetValues();
+	size_t count = lights.size();
+	mLightX.resize(count);
+	mLightY.resize(count);
+	mLightZ.resize(count);
+	mLightRadius.resize(count);
+	mLightData.resize(count * 8);
+	for (size_t i = 0; i < count; i++)
+	{
+		PointLightComponent* light = lights[i];
+		Vector3 pos = light->GetOwner()->GetRenderTransform().GetTranslation();
+		mLightX[i] = pos.x;
+		mLightY[i] = pos.y;
+		mLightZ[i] = pos.z;
+		// Nothing is lit past the outer radius
+		mLightRadius[i] = light->mOuterRadius;
+		float* data = &mLightData[i * 8];
+		data[0] = pos.x;
+		data[1] = pos.y;
+		data[2] = pos.z;
+		data[3] = light->mInnerRadius;
+		data[4] = light->mDiffuseColor.x;
+		data[5] = light->mDiffuseColor.y;
+		data[6] = light->mDiffuseColor.z;
+		data[7] = light->mOuterRadius;
+	}
+
+	mLightClusters->Build(mView, mProjection, mNearPlane, mFarPlane,
+		mLightX.data(), mLightY.data(), mLightZ.data(), mLightRadius.data(), count,
+		mGame->GetJobSystem());
+	mStats.mPointLights = static_cast<int>(mLightClusters->GetNumVisible());
+	mStats.mClusterLightIndices = static_cast<int>(mLightClusters->GetIndices().size());
+
+	// Orphan last frame's buffers rather than waiting for the GPU
+	// to be done with them
+	const void* data[3] = { mLightData.data(), mLightClusters->GetGrid().data(),
+		mLightClusters->GetIndices().data() };
+	size_t sizes[3] = { mLightData.size() * sizeof(float),
+		mLightClusters->GetGrid().size() * sizeof(uint32_t),
+		mLightClusters->GetIndices().size() * sizeof(uint32_t) };
+	for (int i = 0; i < 3; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, mLightBuffers[i]);
+		if (sizes[i] > 0)
+		{
+			glBufferData(GL_TEXTURE_BUFFER, sizes[i], data[i], GL_STREAM_DRAW);
+		}
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
 Vector3 Renderer::Unproject(const Vector3& screenPoint) const
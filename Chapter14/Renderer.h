@@ -10,8 +10,12 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <cstdint>
 #include <SDL/SDL.h>
 #include "Math.h"
+#include "RenderQueue.h"
+#include "SlotMap.h"
 
 struct DirectionalLight
 {
@@ -23,6 +27,27 @@ struct DirectionalLight
 	Vector3 mSpecColor;
 };
 
+// Counts for the most recent frame
+struct RenderStats
+{
+	// Mesh components that were on screen and drawn
+	int mMeshesDrawn = 0;
+	// Mesh components skipped by frustum culling
+	int mMeshesCulled = 0;
+	// Made by the render queue
+	int mDrawCalls = 0;
+	int mShaderChanges = 0;
+	int mTextureChanges = 0;
+	int mVertexArrayChanges = 0;
+	// Made by the sprite batch (sprites and UI)
+	int mSpriteQuads = 0;
+	int mSpriteDrawCalls = 0;
+	// Point lights that reach the screen (all of them for the
+	// per-light path), and the light indices in the clusters
+	int mPointLights = 0;
+	int mClusterLightIndices = 0;
+};
+
 class Renderer
 {
 public:
@@ -30,29 +55,46 @@ public:
 	~Renderer();
 
 	bool Initialize(float screenWidth, float screenHeight);
+	// Sets up without a window or OpenGL, for headless runs. Meshes
+	// and textures only load what the simulation needs, and Draw
+	// does nothing.
+	void InitializeHeadless(float screenWidth, float screenHeight);
+	bool IsHeadless() const { return mHeadless; }
 	void Shutdown();
 	void UnloadData();
 
 	void Draw();
 
-	void AddSprite(class SpriteComponent* sprite);
-	void RemoveSprite(class SpriteComponent* sprite);
+	// The add functions return the handle to remove with
+	SlotHandle AddSprite(class SpriteComponent* sprite);
+	void RemoveSprite(SlotHandle handle);
 
-	void AddMeshComp(class MeshComponent* mesh);
-	void RemoveMeshComp(class MeshComponent* mesh);
+	SlotHandle AddMeshComp(class MeshComponent* mesh);
+	void RemoveMeshComp(class MeshComponent* mesh, SlotHandle handle);
 
-	void AddPointLight(class PointLightComponent* light);
-	void RemovePointLight(class PointLightComponent* light);
+	SlotHandle AddPointLight(class PointLightComponent* light);
+	void RemovePointLight(SlotHandle handle);
 
 	class Texture* GetTexture(const std::string& fileName);
 	class Mesh* GetMesh(const std::string& fileName);
+	// Return right away and load on the AssetLoader. The texture shows
+	// Default.png until it's in, and the mesh isn't drawn until it's in.
+	// (GetTexture/GetMesh on one of these waits for it to finish)
+	class Texture* GetTextureAsync(const std::string& fileName);
+	class Mesh* GetMeshAsync(const std::string& fileName);
+	// Adds every region in an atlas made by AtlasPacker as a texture
+	// (returns false if there's no such atlas)
+	bool LoadAtlas(const std::string& fileName);
 
 	void SetViewMatrix(const Matrix4& view) { mView = view; }
+	const Matrix4& GetViewMatrix() const { return mView; }
+	const Matrix4& GetProjectionMatrix() const { return mProjection; }
 
 	const Vector3& GetAmbientLight() const { return mAmbientLight; }
 	void SetAmbientLight(const Vector3& ambient) { mAmbientLight = ambient; }
 	DirectionalLight& GetDirectionalLight() { return mDirLight; }
-	const std::vector<class PointLightComponent*>& GetPointLights() const { return mPointLights; }
+	const std::vector<class PointLightComponent*>& GetPointLights() const { return mPointLights.GetValues(); }
+	const std::vector<class SkeletalMeshComponent*>& GetSkeletalMeshes() const { return mSkeletalMeshes.GetValues(); }
 
 	// Given a screen space point, unprojects it into world space,
 	// based on the current 3D view/projection matrices
@@ -71,16 +113,50 @@ public:
 	void SetMirrorView(const Matrix4& view) { mMirrorView = view; }
 	class Texture* GetMirrorTexture() { return mMirrorTexture; }
 	class GBuffer* GetGBuffer() { return mGBuffer; }
+
+	const RenderStats& GetStats() const { return mStats; }
+	void SetFrustumCulling(bool cull) { mFrustumCulling = cull; }
+	bool GetFrustumCulling() const { return mFrustumCulling; }
+	// If false, meshes draw in the order they were added
+	// (to compare the number of state changes)
+	void SetSortRenderQueue(bool sort) { mSortRenderQueue = sort; }
+	bool GetSortRenderQueue() const { return mSortRenderQueue; }
+	// If true, non-skeletal meshes that share a mesh and
+	// texture are drawn together with instancing
+	void SetInstancing(bool instancing) { mInstancing = instancing; }
+	bool GetInstancing() const { return mInstancing; }
+	// If true, point lights are binned into clusters and shaded in
+	// the global G-buffer pass, instead of a sphere drawn per light
+	void SetClusteredLights(bool clustered) { mClusteredLights = clustered; }
+	bool GetClusteredLights() const { return mClusteredLights; }
+	// If true, the G-buffer uses the compact layout (see GBuffer),
+	// otherwise three RGB32F targets. Changing it remakes the G-buffer.
+	void SetCompactGBuffer(bool compact);
+	bool GetCompactGBuffer() const { return mCompactGBuffer; }
 private:
 	// Chapter 14 additions
-	void Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj, bool lit = true);
+	void Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj);
 	bool CreateMirrorTarget();
+	// (Re)create the G-buffer in the current layout
+	bool CreateGBuffer();
 	void DrawFromGBuffer();
 	//void DrawFromGBuffer();
 	// End chapter 14 additions
+	// Add the sprite components to the sprite batch in draw order
+	void DrawSprites();
+	// Fill in mCullVisible for every mesh in mCullMeshes
+	void CullMeshes(const Matrix4& viewProj);
+	// Move the mesh into (or out of) the right instance batch.
+	// Returns true if it's drawn instanced
+	bool UpdateInstanceBatch(class MeshComponent* mc);
 	bool LoadShaders();
 	void CreateSpriteVerts();
-	void SetLightUniforms(class Shader* shader, const Matrix4& view);
+	// Upload the per-frame uniform buffer
+	void UpdateFrameUniforms(const Matrix4& view, const Matrix4& proj);
+	// Buffers for the clustered point lights
+	void CreateLightBuffers();
+	// Bin the point lights into clusters and upload the lists
+	void UpdateLightClusters();
 
 	// Map of textures loaded
 	std::unordered_map<std::string, class Texture*> mTextures;
@@ -88,28 +164,37 @@ private:
 	std::unordered_map<std::string, class Mesh*> mMeshes;
 
 	// All the sprite components drawn
-	std::vector<class SpriteComponent*> mSprites;
+	SlotMap<class SpriteComponent*> mSprites;
+	// The sprites in draw order (rebuilt when sprites are added/removed)
+	std::vector<class SpriteComponent*> mSortedSprites;
+	bool mSpritesDirty;
 
 	// All (non-skeletal) mesh components drawn
-	std::vector<class MeshComponent*> mMeshComps;
-	std::vector<class SkeletalMeshComponent*> mSkeletalMeshes;
+	SlotMap<class MeshComponent*> mMeshComps;
+	SlotMap<class SkeletalMeshComponent*> mSkeletalMeshes;
 
 	// Game
 	class Game* mGame;
 
 	// Sprite shader
 	class Shader* mSpriteShader;
-	// Sprite vertex array
+	// Sprite vertex array (the full screen quad for the G-buffer)
 	class VertexArray* mSpriteVerts;
+	// Every sprite and UI quad of the frame
+	class SpriteBatch* mSpriteBatch;
 
 	// Mesh shader
 	class Shader* mMeshShader;
 	// Skinned shader
 	class Shader* mSkinnedShader;
+	// Mesh shader with per-instance world transforms
+	class Shader* mInstancedShader;
 
 	// View/projection for 3D shaders
 	Matrix4 mView;
 	Matrix4 mProjection;
+	float mNearPlane;
+	float mFarPlane;
 
 	// Lighting data
 	Vector3 mAmbientLight;
@@ -128,9 +213,47 @@ private:
 	Matrix4 mMirrorView;
 	
 	class GBuffer* mGBuffer;
+	bool mCompactGBuffer;
 	// GBuffer shader
 	class Shader* mGGlobalShader;
 	class Shader* mGPointLightShader;
-	std::vector<class PointLightComponent*> mPointLights;
+	// Per-frame data shared by the 3D shaders
+	class UniformBuffer* mFrameBuffer;
+	SlotMap<class PointLightComponent*> mPointLights;
 	class Mesh* mPointLightMesh;
+	// Clustered point lights. The buffers (and the buffer textures
+	// the shader reads them through) are the light data, the grid
+	// of clusters, and the light indices in them
+	class LightClusters* mLightClusters;
+	unsigned int mLightBuffers[3];
+	unsigned int mLightTextures[3];
+	// Light bounding spheres as separate arrays for the binning,
+	// and the data for the shader (two vec4s per light)
+	std::vector<float> mLightX;
+	std::vector<float> mLightY;
+	std::vector<float> mLightZ;
+	std::vector<float> mLightRadius;
+	std::vector<float> mLightData;
+	bool mClusteredLights;
+
+	// Meshes that might be drawn this pass (non-skeletal first),
+	// with their world bounding spheres stored as separate
+	// arrays so the frustum test can use SIMD
+	std::vector<class MeshComponent*> mCullMeshes;
+	size_t mNumCullStatic;
+	std::vector<float> mCullX;
+	std::vector<float> mCullY;
+	std::vector<float> mCullZ;
+	std::vector<float> mCullRadius;
+	std::vector<uint8_t> mCullVisible;
+	bool mFrustumCulling;
+	RenderStats mStats;
+	// Meshes to draw this pass
+	RenderQueue mRenderQueue;
+	bool mSortRenderQueue;
+	// Meshes drawn with instancing, by (mesh, texture index)
+	std::map<std::pair<class Mesh*, size_t>, class InstanceBatch*> mInstanceBatches;
+	std::vector<class InstanceBatch*> mVisibleBatches;
+	bool mInstancing;
+	bool mHeadless;
 };
@@ -11,6 +11,33 @@
 #include <SDL/SDL.h>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include "Profiler.h"
+
+namespace
+{
+	// Stops include cycles
+	const int MaxIncludeDepth = 8;
+}
+
+UniformHandle::UniformHandle(const char* name)
+	:mID(Shader::GetUniformID(name))
+{
+}
+
+int Shader::GetUniformID(const std::string& name)
+{
+	// Function static, so it's ready for handles in other statics
+	static std::unordered_map<std::string, int> ids;
+	auto iter = ids.find(name);
+	if (iter != ids.end())
+	{
+		return iter->second;
+	}
+	int id = static_cast<int>(ids.size());
+	ids.emplace(name, id);
+	return id;
+}
 
 Shader::Shader()
 	: mShaderProgram(0)
@@ -27,6 +54,7 @@ Shader::~Shader()
 
 bool Shader::Load(const std::string& vertName, const std::string& fragName)
 {
+	PROFILE_SCOPE_DETAIL("Shader::Load", fragName.c_str());
 	// Compile vertex and pixel shaders
 	if (!CompileShader(vertName,
 					   GL_VERTEX_SHADER,
@@ -50,7 +78,8 @@ bool Shader::Load(const std::string& vertName, const std::string& fragName)
 	{
 		return false;
 	}
-	
+
+	CacheUniformLocations();
 	return true;
 }
 
@@ -68,81 +97,157 @@ void Shader::SetActive()
 	glUseProgram(mShaderProgram);
 }
 
-void Shader::SetMatrixUniform(const char* name, const Matrix4& matrix)
+void Shader::SetMatrixUniform(UniformHandle handle, const Matrix4& matrix)
 {
-	// Find the uniform by this name
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
 	// Send the matrix data to the uniform
-	glUniformMatrix4fv(loc, 1, GL_TRUE, matrix.GetAsFloatPtr());
+	glUniformMatrix4fv(GetLocation(handle), 1, GL_TRUE, matrix.GetAsFloatPtr());
 }
 
-void Shader::SetMatrixUniforms(const char* name, Matrix4* matrices, unsigned count)
+void Shader::SetMatrixUniforms(UniformHandle handle, const Matrix4* matrices, unsigned count)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
 	// Send the matrix data to the uniform
-	glUniformMatrix4fv(loc, count, GL_TRUE, matrices->GetAsFloatPtr());
+	glUniformMatrix4fv(GetLocation(handle), count, GL_TRUE, matrices->GetAsFloatPtr());
 }
 
-void Shader::SetVectorUniform(const char* name, const Vector3& vector)
+void Shader::SetVectorUniform(UniformHandle handle, const Vector3& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
 	// Send the vector data
-	glUniform3fv(loc, 1, vector.GetAsFloatPtr());
+	glUniform3fv(GetLocation(handle), 1, vector.GetAsFloatPtr());
 }
 
-void Shader::SetVector2Uniform(const char* name, const Vector2& vector)
+void Shader::SetVector2Uniform(UniformHandle handle, const Vector2& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
 	// Send the vector data
-	glUniform2fv(loc, 1, vector.GetAsFloatPtr());
+	glUniform2fv(GetLocation(handle), 1, vector.GetAsFloatPtr());
 }
 
-void Shader::SetFloatUniform(const char* name, float value)
+void Shader::SetFloatUniform(UniformHandle handle, float value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
 	// Send the float data
-	glUniform1f(loc, value);
+	glUniform1f(GetLocation(handle), value);
 }
 
-void Shader::SetIntUniform(const char* name, int value)
+void Shader::SetIntUniform(UniformHandle handle, int value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the float data
-	glUniform1i(loc, value);
+	// Send the int data
+	glUniform1i(GetLocation(handle), value);
+}
+
+bool Shader::BindUniformBlock(const char* blockName, unsigned int bindingPoint)
+{
+	GLuint index = glGetUniformBlockIndex(mShaderProgram, blockName);
+	if (index == GL_INVALID_INDEX)
+	{
+		return false;
+	}
+	glUniformBlockBinding(mShaderProgram, index, bindingPoint);
+	return true;
+}
+
+void Shader::CacheUniformLocations()
+{
+	mLocations.clear();
+	GLint numUniforms = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORMS, &numUniforms);
+	char name[256];
+	for (GLint i = 0; i < numUniforms; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(mShaderProgram, i, sizeof(name), &length,
+			&size, &type, name);
+		// Uniforms in a block don't have a location
+		GLint loc = glGetUniformLocation(mShaderProgram, name);
+		if (loc == -1)
+		{
+			continue;
+		}
+		// Arrays are reported as "name[0]", but are set by "name"
+		std::string uniformName(name, length);
+		size_t bracket = uniformName.find('[');
+		if (bracket != std::string::npos)
+		{
+			uniformName.resize(bracket);
+		}
+		int id = GetUniformID(uniformName);
+		if (id >= static_cast<int>(mLocations.size()))
+		{
+			mLocations.resize(id + 1, -1);
+		}
+		mLocations[id] = loc;
+	}
 }
 
 bool Shader::CompileShader(const std::string& fileName,
 				   GLenum shaderType,
 				   GLuint& outShader)
+{
+	// Read the file (and anything it includes) into a string
+	std::string contents;
+	if (!ReadSource(fileName, contents, 0))
+	{
+		return false;
+	}
+	const char* contentsChar = contents.c_str();
+
+	// Create a shader of the specified type
+	outShader = glCreateShader(shaderType);
+	// Set the source characters and try to compile
+	glShaderSource(outShader, 1, &(contentsChar), nullptr);
+	glCompileShader(outShader);
+
+	if (!IsCompiled(outShader))
+	{
+		SDL_Log("Failed to compile shader %s", fileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool Shader::ReadSource(const std::string& fileName, std::string& outSource, int depth)
 {
 	// Open file
 	std::ifstream shaderFile(fileName);
-	if (shaderFile.is_open())
+	if (!shaderFile.is_open())
 	{
-		// Read all of the text into a string
-		std::stringstream sstream;
-		sstream << shaderFile.rdbuf();
-		std::string contents = sstream.str();
-		const char* contentsChar = contents.c_str();
-		
-		// Create a shader of the specified type
-		outShader = glCreateShader(shaderType);
-		// Set the source characters and try to compile
-		glShaderSource(outShader, 1, &(contentsChar), nullptr);
-		glCompileShader(outShader);
-		
-		if (!IsCompiled(outShader))
+		SDL_Log("Shader file not found: %s", fileName.c_str());
+		return false;
+	}
+
+	// Included files are relative to the file including them
+	size_t slash = fileName.find_last_of("/\\");
+	std::string dir = (slash == std::string::npos) ? "" : fileName.substr(0, slash + 1);
+
+	std::string line;
+	int lineNum = 0;
+	while (std::getline(shaderFile, line))
+	{
+		lineNum++;
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
 		{
-			SDL_Log("Failed to compile shader %s", fileName.c_str());
+			outSource += line;
+			outSource += '\n';
+			continue;
+		}
+
+		// #include "File.glsl" pastes in the whole file
+		size_t open = line.find('"', start);
+		size_t close = (open == std::string::npos) ? open : line.find('"', open + 1);
+		if (close == std::string::npos || depth >= MaxIncludeDepth)
+		{
+			SDL_Log("Bad #include in %s, line %d", fileName.c_str(), lineNum);
 			return false;
 		}
+		if (!ReadSource(dir + line.substr(open + 1, close - open - 1), outSource, depth + 1))
+		{
+			return false;
+		}
+		// So compile errors still have the right line numbers
+		outSource += "#line " + std::to_string(lineNum + 1) + "\n";
 	}
-	else
-	{
-		SDL_Log("Shader file not found: %s", fileName.c_str());
-		return false;
-	}
-	
 	return true;
 }
 
@@ -9,8 +9,20 @@
 #pragma once
 #include <GL/glew.h>
 #include <string>
+#include <vector>
 #include "Math.h"
 
+// Handle to a uniform name. Names are interned into a small
+// integer once, and shaders cache the location for every ID,
+// so setting a uniform through a handle needs no string lookups.
+// Usually stored in a static, e.g.
+//   static const UniformHandle worldTransform("uWorldTransform");
+struct UniformHandle
+{
+	explicit UniformHandle(const char* name);
+	int mID;
+};
+
 class Shader
 {
 public:
@@ -20,22 +32,69 @@ public:
 	void Unload();
 	// Set this as the active shader program
 	void SetActive();
+	GLuint GetProgramID() const { return mShaderProgram; }
 	// Sets a Matrix uniform
-	void SetMatrixUniform(const char* name, const Matrix4& matrix);
+	void SetMatrixUniform(UniformHandle handle, const Matrix4& matrix);
 	// Sets an array of matrix uniforms
-	void SetMatrixUniforms(const char* name, Matrix4* matrices, unsigned count);
+	void SetMatrixUniforms(UniformHandle handle, const Matrix4* matrices, unsigned count);
 	// Sets a Vector3 uniform
-	void SetVectorUniform(const char* name, const Vector3& vector);
-	void SetVector2Uniform(const char* name, const Vector2& vector);
+	void SetVectorUniform(UniformHandle handle, const Vector3& vector);
+	void SetVector2Uniform(UniformHandle handle, const Vector2& vector);
 	// Sets a float uniform
-	void SetFloatUniform(const char* name, float value);
+	void SetFloatUniform(UniformHandle handle, float value);
 	// Sets an integer uniform
-	void SetIntUniform(const char* name, int value);
+	void SetIntUniform(UniformHandle handle, int value);
+
+	// Versions that take the name. It's looked up in the intern
+	// table every call, so these are for setup code. Anything set
+	// per frame or per draw should use a static UniformHandle.
+	void SetMatrixUniform(const char* name, const Matrix4& matrix)
+	{
+		SetMatrixUniform(UniformHandle(name), matrix);
+	}
+	void SetMatrixUniforms(const char* name, Matrix4* matrices, unsigned count)
+	{
+		SetMatrixUniforms(UniformHandle(name), matrices, count);
+	}
+	void SetVectorUniform(const char* name, const Vector3& vector)
+	{
+		SetVectorUniform(UniformHandle(name), vector);
+	}
+	void SetVector2Uniform(const char* name, const Vector2& vector)
+	{
+		SetVector2Uniform(UniformHandle(name), vector);
+	}
+	void SetFloatUniform(const char* name, float value)
+	{
+		SetFloatUniform(UniformHandle(name), value);
+	}
+	void SetIntUniform(const char* name, int value)
+	{
+		SetIntUniform(UniformHandle(name), value);
+	}
+
+	// Connect the named uniform block to a uniform buffer binding
+	// point. Returns false if the shader doesn't use the block
+	bool BindUniformBlock(const char* blockName, unsigned int bindingPoint);
+
+	// Interned ID for a uniform name (adds it if it's new)
+	static int GetUniformID(const std::string& name);
 private:
+	// Location of the uniform, or -1 if this shader doesn't have it
+	GLint GetLocation(UniformHandle handle) const
+	{
+		return handle.mID < static_cast<int>(mLocations.size()) ?
+			mLocations[handle.mID] : -1;
+	}
+	// Look up every active uniform once the program links
+	void CacheUniformLocations();
 	// Tries to compile the specified shader
 	bool CompileShader(const std::string& fileName,
 					   GLenum shaderType,
 					   GLuint& outShader);
+	// Reads the file into outSource, replacing #include "File"
+	// lines with the file they name
+	bool ReadSource(const std::string& fileName, std::string& outSource, int depth);
 	
 	// Tests whether shader compiled successfully
 	bool IsCompiled(GLuint shader);
@@ -46,4 +105,6 @@ private:
 	GLuint mVertexShader;
 	GLuint mFragShader;
 	GLuint mShaderProgram;
+	// Uniform locations, indexed by interned uniform ID
+	std::vector<GLint> mLocations;
 };
@@ -9,9 +9,10 @@
 // Request GLSL 3.3
 #version 330
 
-// Uniforms for world transform and view-proj
+// Uniform for world transform
 uniform mat4 uWorldTransform;
-uniform mat4 uViewProj;
+
+#include "FrameData.glsl"
 
 // Attribute 0 is position, 1 is normal, 2 is tex coords.
 layout(location = 0) in vec3 inPosition;
@@ -26,7 +27,7 @@ void main()
 	// Convert position to homogeneous coordinates
 	vec4 pos = vec4(inPosition, 1.0);
 	// Transform to position world space, then clip space
-	gl_Position = pos * uWorldTransform * uViewProj;
+	gl_Position = pos * uWorldTransform * uFrame.mViewProj;
 
 	// Pass along the texture coordinate to frag shader
 	fragTexCoord = inTexCoord;
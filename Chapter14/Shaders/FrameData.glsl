@@ -0,0 +1,32 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+// Per-frame data shared by all the 3D shaders. Shader::Load pastes
+// this in wherever a shader has #include "FrameData.glsl".
+
+struct DirectionalLight
+{
+	// Direction of light
+	vec3 mDirection;
+	// Diffuse color
+	vec3 mDiffuseColor;
+	// Specular color
+	vec3 mSpecColor;
+};
+
+// std140, so it matches FrameUniforms in Renderer.cpp
+layout(std140, row_major) uniform FrameData
+{
+	mat4 mViewProj;
+	// Camera position (in world space)
+	vec3 mCameraPos;
+	// Ambient light level
+	vec3 mAmbientLight;
+	// Directional Light
+	DirectionalLight mDirLight;
+} uFrame;
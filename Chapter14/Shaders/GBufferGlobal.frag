@@ -16,53 +16,86 @@ in vec2 fragTexCoord;
 // This corresponds to the output color to the color buffer
 layout(location = 0) out vec4 outColor;
 
-// Different textures from G-buffer
-uniform sampler2D uGDiffuse;
-uniform sampler2D uGNormal;
-uniform sampler2D uGWorldPos;
+#include "GBufferRead.glsl"
 
-// Create a struct for directional light
-struct DirectionalLight
+// Point lights binned by LightClusters (the grid size has to
+// match LightClusters.h)
+const int NumClustersX = 16;
+const int NumClustersY = 9;
+const int NumClustersZ = 24;
+// Whether to add the clustered point lights (otherwise they're
+// drawn as spheres afterwards)
+uniform bool uClustered;
+// Two texels per light: (position, inner radius), (color, outer radius)
+uniform samplerBuffer uClusterLights;
+// (offset, count) into the light indices for each cluster
+uniform usamplerBuffer uClusterGrid;
+uniform usamplerBuffer uClusterIndices;
+// For finding the cluster of a pixel
+uniform mat4 uView;
+// Depth slice is floor(log(view depth) * x + y)
+uniform vec2 uClusterSlice;
+uniform vec2 uScreenDimensions;
+
+#include "FrameData.glsl"
+
+// Diffuse light from the point lights in this pixel's cluster
+vec3 ClusterLights(vec3 worldPos, vec3 N)
 {
-	// Direction of light
-	vec3 mDirection;
-	// Diffuse color
-	vec3 mDiffuseColor;
-	// Specular color
-	vec3 mSpecColor;
-};
+	vec3 light = vec3(0.0, 0.0, 0.0);
+	float viewZ = (vec4(worldPos, 1.0) * uView).z;
+	if (viewZ <= 0.0)
+	{
+		return light;
+	}
+	ivec3 cluster;
+	cluster.xy = ivec2(gl_FragCoord.xy / uScreenDimensions *
+		vec2(NumClustersX, NumClustersY));
+	cluster.z = int(floor(log(viewZ) * uClusterSlice.x + uClusterSlice.y));
+	cluster = clamp(cluster, ivec3(0),
+		ivec3(NumClustersX - 1, NumClustersY - 1, NumClustersZ - 1));
+	int index = (cluster.z * NumClustersY + cluster.y) * NumClustersX + cluster.x;
+	uvec2 range = texelFetch(uClusterGrid, index).xy;
 
-// Uniforms for lighting
-// Camera position (in world space)
-uniform vec3 uCameraPos;
-// Ambient light level
-uniform vec3 uAmbientLight;
-// Directional Light
-uniform DirectionalLight uDirLight;
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int lightIndex = int(texelFetch(uClusterIndices, int(range.x + i)).x);
+		vec4 posInner = texelFetch(uClusterLights, lightIndex * 2);
+		vec4 colorOuter = texelFetch(uClusterLights, lightIndex * 2 + 1);
+		light += PointLightDiffuse(posInner.xyz, colorOuter.rgb, posInner.w,
+			colorOuter.w, worldPos, N);
+	}
+	return light;
+}
 
 void main()
 {
 	vec3 gbufferDiffuse = texture(uGDiffuse, fragTexCoord).xyz;
-	vec3 gbufferNorm = texture(uGNormal, fragTexCoord).xyz;
-	vec3 gbufferWorldPos = texture(uGWorldPos, fragTexCoord).xyz;
 	// Surface normal
-	vec3 N = normalize(gbufferNorm);
+	vec3 N;
+	vec3 gbufferWorldPos;
+	ReadGBuffer(fragTexCoord, N, gbufferWorldPos);
 	// Vector from surface to light
-	vec3 L = normalize(-uDirLight.mDirection);
+	vec3 L = normalize(-uFrame.mDirLight.mDirection);
 	// Vector from surface to camera
-	vec3 V = normalize(uCameraPos - gbufferWorldPos);
+	vec3 V = normalize(uFrame.mCameraPos - gbufferWorldPos);
 	// Reflection of -L about N
 	vec3 R = normalize(reflect(-L, N));
 
 	// Compute phong reflection
-	vec3 Phong = uAmbientLight;
+	vec3 Phong = uFrame.mAmbientLight;
 	float NdotL = dot(N, L);
 	if (NdotL > 0)
 	{
-		vec3 Diffuse = uDirLight.mDiffuseColor * dot(N, L);
+		vec3 Diffuse = uFrame.mDirLight.mDiffuseColor * dot(N, L);
 	}
 	// Clamp light between 0-1 RGB values
 	Phong = clamp(Phong, 0.0, 1.0);
+	// Point lights add on top (like the blended per-light spheres)
+	if (uClustered)
+	{
+		Phong += ClusterLights(gbufferWorldPos, N);
+	}
 
 	// Final color is texture color times phong light (alpha = 1)
 	outColor = vec4(gbufferDiffuse * Phong, 1.0);
@@ -16,10 +16,7 @@ in vec2 fragTexCoord;
 // This corresponds to the output color to the color buffer
 layout(location = 0) out vec4 outColor;
 
-// Different textures from G-buffer
-uniform sampler2D uGDiffuse;
-uniform sampler2D uGNormal;
-uniform sampler2D uGWorldPos;
+#include "GBufferRead.glsl"
 
 // Create a struct for the point light
 struct PointLight
@@ -44,30 +41,13 @@ void main()
 	
 	// Sample from G-buffer
 	vec3 gbufferDiffuse = texture(uGDiffuse, gbufferCoord).xyz;
-	vec3 gbufferNorm = texture(uGNormal, gbufferCoord).xyz;
-	vec3 gbufferWorldPos = texture(uGWorldPos, gbufferCoord).xyz;
-	
 	// Surface normal
-	vec3 N = normalize(gbufferNorm);
-	// Vector from surface to light
-	vec3 L = normalize(uPointLight.mWorldPos - gbufferWorldPos);
-
+	vec3 N;
+	vec3 gbufferWorldPos;
+	ReadGBuffer(gbufferCoord, N, gbufferWorldPos);
 	// Compute Phong diffuse component for the light
-	vec3 Phong = vec3(0.0, 0.0, 0.0);
-	float NdotL = dot(N, L);
-	if (NdotL > 0)
-	{
-		// Get the distance between the light and the world pos
-		float dist = distance(uPointLight.mWorldPos, gbufferWorldPos);
-		// Use smoothstep to compute value in range [0,1]
-		// between inner/outer radius
-		float intensity = smoothstep(uPointLight.mInnerRadius,
-									 uPointLight.mOuterRadius, dist);
-		// The diffuse color of the light depends on intensity
-		vec3 DiffuseColor = mix(uPointLight.mDiffuseColor,
-								vec3(0.0, 0.0, 0.0), intensity);
-		Phong = DiffuseColor * NdotL;
-	}
+	vec3 Phong = PointLightDiffuse(uPointLight.mWorldPos, uPointLight.mDiffuseColor,
+		uPointLight.mInnerRadius, uPointLight.mOuterRadius, gbufferWorldPos, N);
 
 	// Final color is texture color times phong light (alpha = 1)
 	outColor = vec4(gbufferDiffuse * Phong, 1.0);
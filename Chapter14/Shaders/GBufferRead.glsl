@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+
+// Reading the G-buffer and lighting it, for the lighting passes
+
+#include "Octahedral.glsl"
+
+// Different textures from G-buffer
+uniform sampler2D uGDiffuse;
+uniform sampler2D uGNormal;
+uniform sampler2D uGWorldPos;
+// Whether the G-buffer uses the compact layout (octahedral normals,
+// and uGWorldPos is the depth buffer)
+uniform bool uCompactGBuffer;
+// Takes NDC back to world space
+uniform mat4 uInvViewProj;
+
+// Normal and world position of the G-buffer pixel at coord
+void ReadGBuffer(vec2 coord, out vec3 normal, out vec3 worldPos)
+{
+	if (uCompactGBuffer)
+	{
+		normal = OctDecode(texture(uGNormal, coord).xy);
+		// Undo the projection (the depth buffer is [0,1], NDC is [-1,1])
+		float depth = texture(uGWorldPos, coord).x;
+		vec4 ndc = vec4(coord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+		vec4 pos = ndc * uInvViewProj;
+		worldPos = pos.xyz / pos.w;
+	}
+	else
+	{
+		normal = normalize(texture(uGNormal, coord).xyz);
+		worldPos = texture(uGWorldPos, coord).xyz;
+	}
+}
+
+// Phong diffuse light from a point light, which fades out
+// between the inner and outer radius
+vec3 PointLightDiffuse(vec3 lightPos, vec3 diffuseColor, float innerRadius,
+	float outerRadius, vec3 worldPos, vec3 N)
+{
+	// Vector from surface to light
+	vec3 L = normalize(lightPos - worldPos);
+	float NdotL = dot(N, L);
+	if (NdotL <= 0)
+	{
+		return vec3(0.0, 0.0, 0.0);
+	}
+	// Get the distance between the light and the world pos
+	float dist = distance(lightPos, worldPos);
+	// Use smoothstep to compute value in range [0,1]
+	// between inner/outer radius
+	float intensity = smoothstep(innerRadius, outerRadius, dist);
+	// The diffuse color of the light depends on intensity
+	return mix(diffuseColor, vec3(0.0, 0.0, 0.0), intensity) * NdotL;
+}
@@ -17,18 +17,31 @@ in vec3 fragNormal;
 in vec3 fragWorldPos;
 
 // This corresponds to the outputs to the G-buffer
+// (in the compact layout, the normal is two octahedral components
+// and the world position comes from the depth buffer instead)
 layout(location = 0) out vec3 outDiffuse;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec3 outWorldPos;
 
 // This is used for the texture sampling
 uniform sampler2D uTexture;
+// Whether the G-buffer uses the compact layout
+uniform bool uCompactGBuffer;
+
+#include "Octahedral.glsl"
 
 void main()
 {
 	// Diffuse color is sampled from texture
 	outDiffuse = texture(uTexture, fragTexCoord).xyz;
-	// Normal/world pos are passed directly along
-	outNormal = fragNormal;
-	outWorldPos = fragWorldPos;
+	if (uCompactGBuffer)
+	{
+		outNormal = vec3(OctEncode(normalize(fragNormal)), 0.0);
+	}
+	else
+	{
+		// Normal/world pos are passed directly along
+		outNormal = fragNormal;
+		outWorldPos = fragWorldPos;
+	}
 }
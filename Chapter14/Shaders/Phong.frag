@@ -23,46 +23,29 @@ out vec4 outColor;
 // This is used for the texture sampling
 uniform sampler2D uTexture;
 
-// Create a struct for directional light
-struct DirectionalLight
-{
-	// Direction of light
-	vec3 mDirection;
-	// Diffuse color
-	vec3 mDiffuseColor;
-	// Specular color
-	vec3 mSpecColor;
-};
+#include "FrameData.glsl"
 
-// Uniforms for lighting
-// Camera position (in world space)
-uniform vec3 uCameraPos;
 // Specular power for this surface
 uniform float uSpecPower;
-// Ambient light level
-uniform vec3 uAmbientLight;
-
-// Directional Light
-uniform DirectionalLight uDirLight;
 
 void main()
 {
 	// Surface normal
 	vec3 N = normalize(fragNormal);
 	// Vector from surface to light
-	vec3 L = normalize(-uDirLight.mDirection);
+	vec3 L = normalize(-uFrame.mDirLight.mDirection);
 	// Vector from surface to camera
-	vec3 V = normalize(uCameraPos - fragWorldPos);
+	vec3 V = normalize(uFrame.mCameraPos - fragWorldPos);
 	// Reflection of -L about N
 	vec3 R = normalize(reflect(-L, N));
 
 	// Compute phong reflection
-	vec3 Phong = uAmbientLight;
+	vec3 Phong = uFrame.mAmbientLight;
 	float NdotL = dot(N, L);
 	if (NdotL > 0)
 	{
-		vec3 Diffuse = uDirLight.mDiffuseColor * NdotL;
-		vec3 Specular = uDirLight.mSpecColor * pow(max(0.0, dot(R, V)), uSpecPower);
+		vec3 Diffuse = uFrame.mDirLight.mDiffuseColor * NdotL;
+		vec3 Specular = uFrame.mDirLight.mSpecColor * pow(max(0.0, dot(R, V)), uSpecPower);
 		Phong += Diffuse + Specular;
 	}
 
@@ -9,9 +9,10 @@
 // Request GLSL 3.3
 #version 330
 
-// Uniforms for world transform and view-proj
+// Uniform for world transform
 uniform mat4 uWorldTransform;
-uniform mat4 uViewProj;
+
+#include "FrameData.glsl"
 
 // Attribute 0 is position, 1 is normal, 2 is tex coords.
 layout(location = 0) in vec3 inPosition;
@@ -34,7 +35,7 @@ void main()
 	// Save world position
 	fragWorldPos = pos.xyz;
 	// Transform to clip space
-	gl_Position = pos * uViewProj;
+	gl_Position = pos * uFrame.mViewProj;
 
 	// Transform normal into world space (w = 0)
 	fragNormal = (vec4(inNormal, 0.0f) * uWorldTransform).xyz;
@@ -9,9 +9,11 @@
 // Request GLSL 3.3
 #version 330
 
-// Uniforms for world transform and view-proj
+// Uniform for world transform
 uniform mat4 uWorldTransform;
-uniform mat4 uViewProj;
+
+#include "FrameData.glsl"
+
 // Uniform for matrix palette
 uniform mat4 uMatrixPalette[96];
 
@@ -47,7 +49,7 @@ void main()
 	// Save world position
 	fragWorldPos = skinnedPos.xyz;
 	// Transform to clip space
-	gl_Position = skinnedPos * uViewProj;
+	gl_Position = skinnedPos * uFrame.mViewProj;
 
 	// Skin the vertex normal
 	vec4 skinnedNormal = vec4(inNormal, 0.0f);
@@ -17,25 +17,45 @@
 #include "Animation.h"
 #include "Skeleton.h"
 #include "LevelLoader.h"
+#include "Frustum.h"
+#include "PoseCache.h"
 
 SkeletalMeshComponent::SkeletalMeshComponent(Actor* owner)
 	:MeshComponent(owner, true)
 	,mSkeleton(nullptr)
+	,mAnimation(nullptr)
+	,mAnimPlayRate(1.0f)
+	,mAnimTime(0.0f)
+	,mPaletteDirty(false)
+	,mFramesSinceUpdate(0)
+	,mLODEnabled(true)
+	,mLODMidSize(0.2f)
+	,mLODMidInterval(2)
+	,mLODLowSize(0.08f)
+	,mLODLowInterval(4)
+	,mLODLowBones(24)
 {
+	// Unlike a plain MeshComponent, this advances the animation
+	// (which only touches this component)
+	mUpdateMode = EUpdateInPhase;
+	mUpdatePhase = EPhaseAnimation;
+	mParallelSafe = true;
+}
+
+void SkeletalMeshComponent::SetSkeleton(Skeleton* sk)
+{
+	mSkeleton = sk;
+	if (mSkeleton)
+	{
+		mCurrentPoses.resize(mSkeleton->GetNumBones());
+	}
 }
 
 void SkeletalMeshComponent::Draw(Shader* shader)
 {
 	if (mMesh)
 	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform", 
-			mOwner->GetWorldTransform());
-		// Set the matrix palette
-		shader->SetMatrixUniforms("uMatrixPalette", &mPalette.mEntry[0], 
-			MAX_SKELETON_BONES);
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
+		SetUniforms(shader);
 		// Set the active texture
 		Texture* t = mMesh->GetTexture(mTextureIndex);
 		if (t)
@@ -50,6 +70,21 @@ void SkeletalMeshComponent::Draw(Shader* shader)
 	}
 }
 
+void SkeletalMeshComponent::SetUniforms(Shader* shader)
+{
+	static const UniformHandle worldTransform("uWorldTransform");
+	static const UniformHandle matrixPalette("uMatrixPalette");
+	static const UniformHandle specPower("uSpecPower");
+	// Set the world transform
+	shader->SetMatrixUniform(worldTransform, 
+		mOwner->GetRenderTransform());
+	// Set the matrix palette
+	shader->SetMatrixUniforms(matrixPalette, &GetPalette()->mEntry[0], 
+		MAX_SKELETON_BONES);
+	// Set specular power
+	shader->SetFloatUniform(specPower, mMesh->GetSpecPower());
+}
+
 void SkeletalMeshComponent::Update(float deltaTime)
 {
 	if (mAnimation && mSkeleton)
@@ -61,11 +96,59 @@ void SkeletalMeshComponent::Update(float deltaTime)
 			mAnimTime -= mAnimation->GetDuration();
 		}
 
-		// Recompute matrix palette
-		ComputeMatrixPalette();
+		// The palette is recomputed later in the frame, along with
+		// every other skeletal mesh (see Game::UpdateAnimations)
+		mPaletteDirty = true;
 	}
 }
 
+void SkeletalMeshComponent::UpdatePalette(const AnimLODCamera& camera)
+{
+	if (!mPaletteDirty)
+	{
+		return;
+	}
+	mFramesSinceUpdate++;
+
+	size_t maxBones = SIZE_MAX;
+	if (mLODEnabled && mMesh)
+	{
+		// Same bounding sphere the renderer culls with
+		const Matrix4& world = mOwner->GetRenderTransform();
+		Vector3 center = world.GetTranslation();
+		Vector3 scale = world.GetScale();
+		float radius = mMesh->GetRadius() * Math::Max(scale.x, Math::Max(scale.y, scale.z));
+
+		// Off screen, so leave the palette dirty until it's back
+		if (!mVisible || !camera.mFrustum->ContainsSphere(center, radius))
+		{
+			return;
+		}
+
+		float dist = (center - camera.mPosition).Length();
+		float size = dist > radius ? radius * camera.mProjScale / dist : 1.0f;
+		int interval = 1;
+		if (size < mLODLowSize)
+		{
+			interval = mLODLowInterval;
+			maxBones = static_cast<size_t>(Math::Max(mLODLowBones, 1));
+		}
+		else if (size < mLODMidSize)
+		{
+			interval = mLODMidInterval;
+		}
+
+		if (mFramesSinceUpdate < interval)
+		{
+			return;
+		}
+	}
+
+	ComputeMatrixPalette(maxBones);
+	mPaletteDirty = false;
+	mFramesSinceUpdate = 0;
+}
+
 float SkeletalMeshComponent::PlayAnimation(Animation* anim, float playRate)
 {
 	mAnimation = anim;
@@ -97,6 +180,13 @@ void SkeletalMeshComponent::LoadProperties(const rapidjson::Value& inObj)
 
 	JsonHelper::GetFloat(inObj, "animPlayRate", mAnimPlayRate);
 	JsonHelper::GetFloat(inObj, "animTime", mAnimTime);
+
+	JsonHelper::GetBool(inObj, "animLOD", mLODEnabled);
+	JsonHelper::GetFloat(inObj, "animLODMidSize", mLODMidSize);
+	JsonHelper::GetInt(inObj, "animLODMidInterval", mLODMidInterval);
+	JsonHelper::GetFloat(inObj, "animLODLowSize", mLODLowSize);
+	JsonHelper::GetInt(inObj, "animLODLowInterval", mLODLowInterval);
+	JsonHelper::GetInt(inObj, "animLODLowBones", mLODLowBones);
 }
 
 void SkeletalMeshComponent::SaveProperties(rapidjson::Document::AllocatorType& alloc, rapidjson::Value& inObj) const
@@ -115,18 +205,32 @@ void SkeletalMeshComponent::SaveProperties(rapidjson::Document::AllocatorType& a
 
 	JsonHelper::AddFloat(alloc, inObj, "animPlayRate", mAnimPlayRate);
 	JsonHelper::AddFloat(alloc, inObj, "animTime", mAnimTime);
+
+	JsonHelper::AddBool(alloc, inObj, "animLOD", mLODEnabled);
+	JsonHelper::AddFloat(alloc, inObj, "animLODMidSize", mLODMidSize);
+	JsonHelper::AddInt(alloc, inObj, "animLODMidInterval", mLODMidInterval);
+	JsonHelper::AddFloat(alloc, inObj, "animLODLowSize", mLODLowSize);
+	JsonHelper::AddInt(alloc, inObj, "animLODLowInterval", mLODLowInterval);
+	JsonHelper::AddInt(alloc, inObj, "animLODLowBones", mLODLowBones);
 }
 
-void SkeletalMeshComponent::ComputeMatrixPalette()
+void SkeletalMeshComponent::ComputeMatrixPalette(size_t maxBones)
 {
+	// Share with any other mesh playing this clip at about this time
+	PoseCache* cache = mOwner->GetGame()->GetPoseCache();
+	if (cache->IsEnabled())
+	{
+		mSharedPalette = cache->GetPalette(mAnimation, mSkeleton, mAnimTime,
+			maxBones, mCurrentPoses);
+		return;
+	}
+	mSharedPalette.reset();
+
 	const std::vector<Matrix4>& globalInvBindPoses = mSkeleton->GetGlobalInvBindPoses();
-	std::vector<Matrix4> currentPoses;
-	mAnimation->GetGlobalPoseAtTime(currentPoses, mSkeleton, mAnimTime);
+	mAnimation->GetGlobalPoseAtTime(mCurrentPoses, mSkeleton, mAnimTime, maxBones);
 
 	// Setup the palette for each bone
-	for (size_t i = 0; i < mSkeleton->GetNumBones(); i++)
-	{
-		// Global inverse bind pose matrix times current pose matrix
-		mPalette.mEntry[i] = globalInvBindPoses[i] * currentPoses[i];
-	}
+	// (global inverse bind pose matrix times current pose matrix)
+	Matrix4::MultiplyArray(globalInvBindPoses.data(), mCurrentPoses.data(),
+		mPalette.mEntry, mSkeleton->GetNumBones());
 }
@@ -9,18 +9,32 @@
 #pragma once
 #include "MeshComponent.h"
 #include "MatrixPalette.h"
+#include <memory>
+#include <vector>
+
+// The camera as seen by the animation LOD
+struct AnimLODCamera
+{
+	const class Frustum* mFrustum;
+	Vector3 mPosition;
+	// Projection y scale, so radius * scale / distance is the
+	// fraction of half the screen height a sphere covers
+	float mProjScale;
+};
 
 class SkeletalMeshComponent : public MeshComponent
 {
 public:
 	SkeletalMeshComponent(class Actor* owner);
+	DECLARE_POOLED(SkeletalMeshComponent)
 	// Draw this mesh component
 	void Draw(class Shader* shader) override;
+	void SetUniforms(class Shader* shader) override;
 
 	void Update(float deltaTime) override;
 
 	// Setters
-	void SetSkeleton(class Skeleton* sk) { mSkeleton = sk; }
+	void SetSkeleton(class Skeleton* sk);
 
 	// Play an animation. Returns the length of the animation
 	float PlayAnimation(class Animation* anim, float playRate = 1.0f);
@@ -30,12 +44,40 @@ public:
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
+
+	// Recomputes the palette if the animation advanced since the last
+	// call and the LOD allows it this frame. Only touches this
+	// component's own data, so it's safe to call for different
+	// components on different threads
+	void UpdatePalette(const AnimLODCamera& camera);
 protected:
-	void ComputeMatrixPalette();
+	void ComputeMatrixPalette(size_t maxBones = SIZE_MAX);
+
+	// Palette drawn with, either mPalette or one from the pose cache
+	const MatrixPalette* GetPalette() const { return mSharedPalette ? mSharedPalette.get() : &mPalette; }
 
 	MatrixPalette mPalette;
+	std::shared_ptr<const MatrixPalette> mSharedPalette;
+	// Global pose of each bone (kept so sampling doesn't allocate)
+	std::vector<Matrix4> mCurrentPoses;
 	class Skeleton* mSkeleton;
 	class Animation* mAnimation;
 	float mAnimPlayRate;
 	float mAnimTime;
+	// Set when mAnimTime changes
+	bool mPaletteDirty;
+	// Frames the palette has been out of date for
+	int mFramesSinceUpdate;
+
+	// Animation LOD (screen size is the fraction of half the screen
+	// height the bounding sphere covers). Off screen never updates.
+	bool mLODEnabled;
+	// Below this size, update every mLODMidInterval frames
+	float mLODMidSize;
+	int mLODMidInterval;
+	// Below this size, update every mLODLowInterval frames
+	// and only animate the first mLODLowBones bones
+	float mLODLowSize;
+	int mLODLowInterval;
+	int mLODLowBones;
 };
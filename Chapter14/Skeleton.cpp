@@ -11,9 +11,12 @@
 #include <SDL/SDL_log.h>
 #include "MatrixPalette.h"
 #include "LevelLoader.h"
+#include <algorithm>
+#include "Profiler.h"
 
 bool Skeleton::Load(const std::string& fileName)
 {
+	PROFILE_SCOPE_DETAIL("Skeleton::Load", fileName.c_str());
 	mFileName = fileName;
 	rapidjson::Document doc;
 	if (!LevelLoader::LoadJSON(fileName, doc))
@@ -107,6 +110,7 @@ bool Skeleton::Load(const std::string& fileName)
 
 	// Now that we have the bones
 	ComputeGlobalInvBindPose();
+	ComputeBoneRanks();
 
 	return true;
 }
@@ -115,23 +119,52 @@ void Skeleton::ComputeGlobalInvBindPose()
 {
 	// Resize to number of bones, which automatically fills identity
 	mGlobalInvBindPoses.resize(GetNumBones());
+	mLocalBindPoses.resize(GetNumBones());
 	
 	// Step 1: Compute global bind pose for each bone
 	
 	// The global bind pose for root is just the local bind pose
-	mGlobalInvBindPoses[0] = mBones[0].mLocalBindPose.ToMatrix();
+	mLocalBindPoses[0] = mBones[0].mLocalBindPose.ToMatrix();
+	mGlobalInvBindPoses[0] = mLocalBindPoses[0];
 
 	// Each remaining bone's global bind pose is its local pose
 	// multiplied by the parent's global bind pose
 	for (size_t i = 1; i < mGlobalInvBindPoses.size(); i++)
 	{
-		Matrix4 localMat = mBones[i].mLocalBindPose.ToMatrix();
-		mGlobalInvBindPoses[i] = localMat * mGlobalInvBindPoses[mBones[i].mParent];
+		mLocalBindPoses[i] = mBones[i].mLocalBindPose.ToMatrix();
+		mGlobalInvBindPoses[i] = mLocalBindPoses[i] * mGlobalInvBindPoses[mBones[i].mParent];
 	}
 
-	// Step 2: Invert
+	// Step 2: Invert (bind poses are only rotation/translation)
 	for (size_t i = 0; i < mGlobalInvBindPoses.size(); i++)
 	{
-		mGlobalInvBindPoses[i].Invert();
+		mGlobalInvBindPoses[i].InvertAffine();
+	}
+}
+
+void Skeleton::ComputeBoneRanks()
+{
+	// Depth of each bone in the hierarchy (parents always come
+	// before their children, so one pass is enough)
+	std::vector<size_t> depth(GetNumBones(), 0);
+	for (size_t i = 1; i < depth.size(); i++)
+	{
+		depth[i] = depth[mBones[i].mParent] + 1;
+	}
+
+	// Sort by depth, keeping the file order within a depth
+	std::vector<size_t> order(GetNumBones());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&depth](size_t a, size_t b) {
+		return depth[a] < depth[b];
+	});
+
+	mBoneRanks.resize(GetNumBones());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		mBoneRanks[order[i]] = i;
 	}
 }
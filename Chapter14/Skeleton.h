@@ -30,15 +30,24 @@ public:
 	const Bone& GetBone(size_t idx) const { return mBones[idx]; }
 	const std::vector<Bone>& GetBones() const { return mBones; }
 	const std::vector<Matrix4>& GetGlobalInvBindPoses() const { return mGlobalInvBindPoses; }
+	const std::vector<Matrix4>& GetLocalBindPoses() const { return mLocalBindPoses; }
+	const std::vector<size_t>& GetBoneRanks() const { return mBoneRanks; }
 	const std::string& GetFileName() const { return mFileName; }
 protected:
 	// Called automatically when the skeleton is loaded
 	// Computes the global inverse bind pose for each bone
 	void ComputeGlobalInvBindPose();
+	// Ranks the bones for animation LOD, so the first n ranks
+	// are the n bones closest to the root
+	void ComputeBoneRanks();
 private:
 	// The bones in the skeleton
 	std::vector<Bone> mBones;
 	// The global inverse bind poses for each bone
 	std::vector<Matrix4> mGlobalInvBindPoses;
+	// The local bind pose of each bone as a matrix
+	std::vector<Matrix4> mLocalBindPoses;
+	// LOD rank of each bone (0 is the root)
+	std::vector<size_t> mBoneRanks;
 	std::string mFileName;
 };
@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Refers to an entry in a SlotMap. The slot's generation changes
+// every time it's reused, so a stale handle is caught instead of
+// finding whatever took its place.
+struct SlotHandle
+{
+	uint32_t mIndex = UINT32_MAX;
+	uint32_t mGeneration = 0;
+};
+
+// Unordered container with O(1) insert, remove and lookup by handle.
+// The values are kept packed in one vector (removing swaps the last
+// value into the hole), so iterating is a straight walk through memory.
+template <typename T>
+class SlotMap
+{
+public:
+	SlotMap()
+		:mFreeHead(UINT32_MAX)
+	{
+	}
+
+	SlotHandle Insert(const T& value)
+	{
+		SlotHandle handle;
+		if (mFreeHead != UINT32_MAX)
+		{
+			handle.mIndex = mFreeHead;
+			mFreeHead = mSlots[mFreeHead].mDense;
+			// Back to an even generation
+			mSlots[handle.mIndex].mGeneration++;
+		}
+		else
+		{
+			handle.mIndex = static_cast<uint32_t>(mSlots.size());
+			mSlots.emplace_back();
+		}
+		Slot& slot = mSlots[handle.mIndex];
+		slot.mDense = static_cast<uint32_t>(mValues.size());
+		handle.mGeneration = slot.mGeneration;
+
+		mValues.emplace_back(value);
+		mDenseToSlot.emplace_back(handle.mIndex);
+		return handle;
+	}
+
+	// Returns false if the handle was already removed
+	bool Remove(SlotHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			return false;
+		}
+		Slot& slot = mSlots[handle.mIndex];
+		uint32_t dense = slot.mDense;
+		uint32_t last = static_cast<uint32_t>(mValues.size()) - 1;
+		if (dense != last)
+		{
+			// Move the last value into the hole
+			mValues[dense] = mValues[last];
+			mDenseToSlot[dense] = mDenseToSlot[last];
+			mSlots[mDenseToSlot[dense]].mDense = dense;
+		}
+		mValues.pop_back();
+		mDenseToSlot.pop_back();
+
+		// Invalidate old handles and put the slot on the free list
+		slot.mGeneration++;
+		slot.mDense = mFreeHead;
+		mFreeHead = handle.mIndex;
+		return true;
+	}
+
+	bool IsValid(SlotHandle handle) const
+	{
+		return handle.mIndex < mSlots.size() &&
+			mSlots[handle.mIndex].mGeneration == handle.mGeneration &&
+			mSlots[handle.mIndex].mGeneration % 2 == 0;
+	}
+
+	// Returns nullptr for a stale handle
+	T* Get(SlotHandle handle)
+	{
+		return IsValid(handle) ? &mValues[mSlots[handle.mIndex].mDense] : nullptr;
+	}
+
+	// Handle of the value at index in GetValues()
+	SlotHandle GetHandle(size_t index) const
+	{
+		SlotHandle handle;
+		handle.mIndex = mDenseToSlot[index];
+		handle.mGeneration = mSlots[handle.mIndex].mGeneration;
+		return handle;
+	}
+
+	void Clear()
+	{
+		// Free every slot (in order, so they're reused from the front)
+		mFreeHead = UINT32_MAX;
+		for (size_t i = mSlots.size(); i > 0; i--)
+		{
+			Slot& slot = mSlots[i - 1];
+			if (slot.mGeneration % 2 == 0)
+			{
+				slot.mGeneration++;
+			}
+			slot.mDense = mFreeHead;
+			mFreeHead = static_cast<uint32_t>(i - 1);
+		}
+		mValues.clear();
+		mDenseToSlot.clear();
+	}
+
+	// The values, packed, in no particular order
+	const std::vector<T>& GetValues() const { return mValues; }
+	size_t Size() const { return mValues.size(); }
+	bool Empty() const { return mValues.empty(); }
+	typename std::vector<T>::const_iterator begin() const { return mValues.begin(); }
+	typename std::vector<T>::const_iterator end() const { return mValues.end(); }
+private:
+	struct Slot
+	{
+		// Index into mValues while in use, next free slot otherwise
+		uint32_t mDense = UINT32_MAX;
+		// Even while in use, odd while free
+		uint32_t mGeneration = 0;
+	};
+
+	std::vector<T> mValues;
+	// Slot of each value, to fix up the slot when a value moves
+	std::vector<uint32_t> mDenseToSlot;
+	std::vector<Slot> mSlots;
+	uint32_t mFreeHead;
+};
@@ -0,0 +1,173 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SpriteBatch.h"
+#include "Texture.h"
+#include <GL/glew.h>
+#include <cstddef>
+
+SpriteBatch::SpriteBatch()
+	:mVertexArray(0)
+	,mVertexBuffer(0)
+	,mIndexBuffer(0)
+	,mIndexCapacity(0)
+	,mNumQuads(0)
+	,mNumDrawCalls(0)
+{
+	glGenVertexArrays(1, &mVertexArray);
+	glBindVertexArray(mVertexArray);
+
+	// The vertices are refilled every frame
+	glGenBuffers(1, &mVertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+	glGenBuffers(1, &mIndexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+
+	// Position is 2 floats, then texture coordinates are 2 floats,
+	// then color is 3 floats
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		reinterpret_cast<void*>(offsetof(Vertex, mPos)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		reinterpret_cast<void*>(offsetof(Vertex, mTexCoord)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		reinterpret_cast<void*>(offsetof(Vertex, mColor)));
+
+	ReserveIndices(256);
+}
+
+SpriteBatch::~SpriteBatch()
+{
+	glDeleteBuffers(1, &mVertexBuffer);
+	glDeleteBuffers(1, &mIndexBuffer);
+	glDeleteVertexArrays(1, &mVertexArray);
+}
+
+void SpriteBatch::Begin()
+{
+	mVerts.clear();
+	mRuns.clear();
+}
+
+void SpriteBatch::Draw(Texture* texture, const Matrix4& world)
+{
+	if (texture == nullptr)
+	{
+		return;
+	}
+
+	// Same corners/texture coordinates as the single sprite quad
+	const Vector2& uvMin = texture->GetUVMin();
+	const Vector2& uvMax = texture->GetUVMax();
+	const Vertex corners[4] = {
+		{ Vector2(-0.5f, 0.5f), Vector2(uvMin.x, uvMin.y), Color::White }, // top left
+		{ Vector2(0.5f, 0.5f), Vector2(uvMax.x, uvMin.y), Color::White }, // top right
+		{ Vector2(0.5f, -0.5f), Vector2(uvMax.x, uvMax.y), Color::White }, // bottom right
+		{ Vector2(-0.5f, -0.5f), Vector2(uvMin.x, uvMax.y), Color::White } // bottom left
+	};
+	for (const Vertex& corner : corners)
+	{
+		Vector3 pos = Vector3::Transform(Vector3(corner.mPos.x, corner.mPos.y, 0.0f), world);
+		mVerts.emplace_back(Vertex{ Vector2(pos.x, pos.y), corner.mTexCoord, corner.mColor });
+	}
+	AddToRun(texture);
+}
+
+void SpriteBatch::Draw(Texture* texture, const Vector2& center, const Vector2& size,
+	const Vector2& uvMin, const Vector2& uvMax, const Vector3& color)
+{
+	if (texture == nullptr)
+	{
+		return;
+	}
+
+	Vector2 half = size * 0.5f;
+	mVerts.emplace_back(Vertex{ Vector2(center.x - half.x, center.y + half.y),
+		Vector2(uvMin.x, uvMin.y), color }); // top left
+	mVerts.emplace_back(Vertex{ Vector2(center.x + half.x, center.y + half.y),
+		Vector2(uvMax.x, uvMin.y), color }); // top right
+	mVerts.emplace_back(Vertex{ Vector2(center.x + half.x, center.y - half.y),
+		Vector2(uvMax.x, uvMax.y), color }); // bottom right
+	mVerts.emplace_back(Vertex{ Vector2(center.x - half.x, center.y - half.y),
+		Vector2(uvMin.x, uvMax.y), color }); // bottom left
+	AddToRun(texture);
+}
+
+void SpriteBatch::AddToRun(Texture* texture)
+{
+	// Extend the current run if it's the same GL texture
+	size_t quad = mVerts.size() / 4 - 1;
+	if (!mRuns.empty() &&
+		mRuns.back().mTexture->GetTextureID() == texture->GetTextureID())
+	{
+		mRuns.back().mNumQuads++;
+	}
+	else
+	{
+		mRuns.emplace_back(Run{ texture, quad, 1 });
+	}
+}
+
+void SpriteBatch::End()
+{
+	mNumQuads = static_cast<int>(mVerts.size() / 4);
+	mNumDrawCalls = static_cast<int>(mRuns.size());
+	if (mVerts.empty())
+	{
+		return;
+	}
+
+	glBindVertexArray(mVertexArray);
+	ReserveIndices(mVerts.size() / 4);
+	// Orphan last frame's buffer rather than waiting for the GPU to be done with it
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, mVerts.size() * sizeof(Vertex), mVerts.data(), GL_STREAM_DRAW);
+
+	for (const Run& run : mRuns)
+	{
+		run.mTexture->SetActive();
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(run.mNumQuads * 6), GL_UNSIGNED_INT,
+			reinterpret_cast<void*>(run.mFirstQuad * 6 * sizeof(unsigned int)));
+	}
+}
+
+void SpriteBatch::ReserveIndices(size_t numQuads)
+{
+	if (numQuads <= mIndexCapacity)
+	{
+		return;
+	}
+	// Grow by doubling, so this only happens a few times
+	size_t capacity = mIndexCapacity > 0 ? mIndexCapacity : 1;
+	while (capacity < numQuads)
+	{
+		capacity *= 2;
+	}
+
+	// Two triangles per quad, the same for every quad
+	std::vector<unsigned int> indices;
+	indices.reserve(capacity * 6);
+	for (size_t i = 0; i < capacity; i++)
+	{
+		unsigned int base = static_cast<unsigned int>(i * 4);
+		indices.emplace_back(base);
+		indices.emplace_back(base + 1);
+		indices.emplace_back(base + 2);
+		indices.emplace_back(base + 2);
+		indices.emplace_back(base + 3);
+		indices.emplace_back(base);
+	}
+	// (The index buffer binding is part of the vertex array)
+	glBindVertexArray(mVertexArray);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+		indices.data(), GL_STATIC_DRAW);
+	mIndexCapacity = capacity;
+}
@@ -0,0 +1,67 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include "Math.h"
+#include <vector>
+
+// Collects the frame's 2D quads (sprites and UI) into one dynamic
+// vertex buffer. Quads draw in the order they're added, and each run
+// of quads using the same GL texture (like regions of one atlas page)
+// is a single draw call.
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+	~SpriteBatch();
+
+	// Clears the quads from last frame
+	void Begin();
+	// Adds a unit quad (centered on the origin) transformed by world,
+	// showing all of texture (or just its atlas region)
+	void Draw(class Texture* texture, const Matrix4& world);
+	// Adds an axis aligned quad (in screen units) showing the uvMin to
+	// uvMax part of texture, tinted by color (used for text glyphs)
+	void Draw(class Texture* texture, const Vector2& center, const Vector2& size,
+		const Vector2& uvMin, const Vector2& uvMax, const Vector3& color);
+	// Uploads the quads and draws them (the sprite shader should be active)
+	void End();
+
+	// Counts for the last End
+	int GetNumQuads() const { return mNumQuads; }
+	int GetNumDrawCalls() const { return mNumDrawCalls; }
+private:
+	struct Vertex
+	{
+		Vector2 mPos;
+		Vector2 mTexCoord;
+		Vector3 mColor;
+	};
+	// Quads in a row with the same texture
+	struct Run
+	{
+		class Texture* mTexture;
+		size_t mFirstQuad;
+		size_t mNumQuads;
+	};
+
+	// Adds the quad that was just pushed to mVerts to a run
+	void AddToRun(class Texture* texture);
+	// Makes sure the index buffer covers numQuads
+	void ReserveIndices(size_t numQuads);
+
+	std::vector<Vertex> mVerts;
+	std::vector<Run> mRuns;
+	unsigned int mVertexArray;
+	unsigned int mVertexBuffer;
+	unsigned int mIndexBuffer;
+	// Quads the index buffer has room for
+	size_t mIndexCapacity;
+	int mNumQuads;
+	int mNumDrawCalls;
+};
@@ -15,9 +15,10 @@ class SpriteComponent : public Component
 public:
 	// (Lower draw order corresponds with further back)
 	SpriteComponent(class Actor* owner, int drawOrder = 100);
+	DECLARE_POOLED(SpriteComponent)
 	~SpriteComponent();
 
-	virtual void Draw(class Shader* shader);
+	virtual void Draw(class SpriteBatch* batch);
 	virtual void SetTexture(class Texture* texture);
 
 	int GetDrawOrder() const { return mDrawOrder; }
@@ -38,4 +39,5 @@ protected:
 	int mTexWidth;
 	int mTexHeight;
 	bool mVisible;
+	SlotHandle mRendererHandle;
 };
@@ -0,0 +1,456 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+namespace
+{
+	// Endpoint a sorts before endpoint b. For ties, mins go before
+	// maxes, so boxes that just touch count as overlapping
+	// (which matches Intersect(AABB, AABB))
+	inline bool EndpointLess(float va, uint32_t a, float vb, uint32_t b)
+	{
+		return va < vb || (va == vb && (a & 1) < (b & 1));
+	}
+
+	inline float GetAxis(const Vector3& v, int axis)
+	{
+		return v.GetAsFloatPtr()[axis];
+	}
+}
+
+SweepAndPrune::SweepAndPrune()
+	:mFreeList(-1)
+{
+}
+
+int SweepAndPrune::CreateProxy(const AABB& box, void* userData)
+{
+	int proxyID = 0;
+	if (mFreeList != -1)
+	{
+		proxyID = mFreeList;
+		mFreeList = mProxies[proxyID].mNextFree;
+		mProxies[proxyID] = Proxy();
+	}
+	else
+	{
+		proxyID = static_cast<int>(mProxies.size());
+		mProxies.emplace_back();
+	}
+
+	Proxy& proxy = mProxies[proxyID];
+	proxy.mBox = box;
+	proxy.mUserData = userData;
+	proxy.mNew = true;
+
+	// Append the endpoints at the end, Update will sort them in
+	for (int axis = 0; axis < 3; axis++)
+	{
+		proxy.mMin[axis] = static_cast<uint32_t>(mValues[axis].size());
+		mValues[axis].emplace_back(GetAxis(box.mMin, axis));
+		mEndpoints[axis].emplace_back(MakeEndpoint(proxyID, false));
+
+		proxy.mMax[axis] = static_cast<uint32_t>(mValues[axis].size());
+		mValues[axis].emplace_back(GetAxis(box.mMax, axis));
+		mEndpoints[axis].emplace_back(MakeEndpoint(proxyID, true));
+	}
+	mNewProxies.emplace_back(proxyID);
+	return proxyID;
+}
+
+void SweepAndPrune::DestroyProxy(int proxyID)
+{
+	Proxy& proxy = mProxies[proxyID];
+
+	// Drop any pairs with this proxy
+	for (int other : proxy.mPairs)
+	{
+		mPairs.erase(MakePairKey(proxyID, other));
+		std::vector<int>& otherPairs = mProxies[other].mPairs;
+		auto iter = std::find(otherPairs.begin(), otherPairs.end(), proxyID);
+		*iter = otherPairs.back();
+		otherPairs.pop_back();
+	}
+	proxy.mPairs.clear();
+
+	// Removing the endpoints here would shift everything after them,
+	// so they're all taken out in one pass on the next Update. Until
+	// then the ID can't be reused, since the endpoints still refer to it.
+	proxy.mUserData = nullptr;
+	proxy.mDead = true;
+	mDeadProxies.emplace_back(proxyID);
+}
+
+void SweepAndPrune::SetBox(int proxyID, const AABB& box)
+{
+	Proxy& proxy = mProxies[proxyID];
+	proxy.mBox = box;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mValues[axis][proxy.mMin[axis]] = GetAxis(box.mMin, axis);
+		mValues[axis][proxy.mMax[axis]] = GetAxis(box.mMax, axis);
+	}
+}
+
+void SweepAndPrune::Update()
+{
+	mAddedPairs.clear();
+	mRemovedPairs.clear();
+	if (!mDeadProxies.empty())
+	{
+		RemoveDeadEndpoints();
+	}
+
+	// If a lot of proxies were just added it's faster to sort from scratch
+	size_t numProxies = mValues[0].size() / 2;
+	if (mNewProxies.size() * 4 > numProxies)
+	{
+		Rebuild();
+	}
+	else if (!mNewProxies.empty())
+	{
+		InsertNewProxies();
+	}
+	else
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			SortAxis(axis);
+		}
+	}
+
+	for (int proxyID : mNewProxies)
+	{
+		mProxies[proxyID].mNew = false;
+	}
+	mNewProxies.clear();
+}
+
+uint64_t SweepAndPrune::MakePairKey(int a, int b)
+{
+	if (a > b)
+	{
+		std::swap(a, b);
+	}
+	return (static_cast<uint64_t>(a) << 32) | static_cast<uint64_t>(b);
+}
+
+void SweepAndPrune::SetEndpointIndex(int axis, uint32_t endpoint, uint32_t index)
+{
+	Proxy& proxy = mProxies[GetProxy(endpoint)];
+	if (IsMax(endpoint))
+	{
+		proxy.mMax[axis] = index;
+	}
+	else
+	{
+		proxy.mMin[axis] = index;
+	}
+}
+
+void SweepAndPrune::SortAxis(int axis)
+{
+	std::vector<float>& values = mValues[axis];
+	std::vector<uint32_t>& endpoints = mEndpoints[axis];
+	size_t count = values.size();
+	for (size_t i = 1; i < count; i++)
+	{
+		float keyValue = values[i];
+		uint32_t key = endpoints[i];
+		size_t j = i;
+		// Shift the key left until it's in order. Every endpoint
+		// it passes is a potential change in overlap on this axis
+		while (j > 0 && EndpointLess(keyValue, key, values[j - 1], endpoints[j - 1]))
+		{
+			uint32_t other = endpoints[j - 1];
+			int keyProxy = GetProxy(key);
+			int otherProxy = GetProxy(other);
+			if (keyProxy != otherProxy)
+			{
+				if (!IsMax(key) && IsMax(other))
+				{
+					// Min passed a max, so they might overlap now
+					if (Intersect(mProxies[keyProxy].mBox, mProxies[otherProxy].mBox))
+					{
+						AddPair(keyProxy, otherProxy);
+					}
+				}
+				else if (IsMax(key) && !IsMax(other))
+				{
+					// Max passed a min, so they're now apart on this axis
+					RemovePair(keyProxy, otherProxy);
+				}
+			}
+
+			values[j] = values[j - 1];
+			endpoints[j] = other;
+			SetEndpointIndex(axis, other, static_cast<uint32_t>(j));
+			j--;
+		}
+
+		if (j != i)
+		{
+			values[j] = keyValue;
+			endpoints[j] = key;
+			SetEndpointIndex(axis, key, static_cast<uint32_t>(j));
+		}
+	}
+}
+
+void SweepAndPrune::RemoveDeadEndpoints()
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<float>& values = mValues[axis];
+		std::vector<uint32_t>& endpoints = mEndpoints[axis];
+		size_t write = 0;
+		for (size_t read = 0; read < endpoints.size(); read++)
+		{
+			uint32_t endpoint = endpoints[read];
+			if (mProxies[GetProxy(endpoint)].mDead)
+			{
+				continue;
+			}
+			if (write != read)
+			{
+				values[write] = values[read];
+				endpoints[write] = endpoint;
+				SetEndpointIndex(axis, endpoint, static_cast<uint32_t>(write));
+			}
+			write++;
+		}
+		values.resize(write);
+		endpoints.resize(write);
+	}
+
+	// A proxy can be created and destroyed before an update
+	mNewProxies.erase(std::remove_if(mNewProxies.begin(), mNewProxies.end(),
+		[this](int proxyID) { return mProxies[proxyID].mDead; }), mNewProxies.end());
+
+	for (int proxyID : mDeadProxies)
+	{
+		Proxy& proxy = mProxies[proxyID];
+		proxy.mDead = false;
+		proxy.mNew = false;
+		proxy.mNextFree = mFreeList;
+		mFreeList = proxyID;
+	}
+	mDeadProxies.clear();
+}
+
+void SweepAndPrune::Rebuild()
+{
+	// Sort each axis from scratch
+	std::vector<std::pair<float, uint32_t>> temp;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<float>& values = mValues[axis];
+		std::vector<uint32_t>& endpoints = mEndpoints[axis];
+		temp.resize(values.size());
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			temp[i] = std::make_pair(values[i], endpoints[i]);
+		}
+		std::sort(temp.begin(), temp.end(),
+			[](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+				return EndpointLess(a.first, a.second, b.first, b.second);
+		});
+		for (size_t i = 0; i < temp.size(); i++)
+		{
+			values[i] = temp[i].first;
+			endpoints[i] = temp[i].second;
+			SetEndpointIndex(axis, endpoints[i], static_cast<uint32_t>(i));
+		}
+	}
+
+	// Sweep along x to find every overlapping pair
+	std::unordered_set<uint64_t> newPairs;
+	std::vector<int> active;
+	const std::vector<uint32_t>& endpoints = mEndpoints[0];
+	for (uint32_t endpoint : endpoints)
+	{
+		int proxyID = GetProxy(endpoint);
+		if (IsMax(endpoint))
+		{
+			// Swap-remove from the active list
+			auto iter = std::find(active.begin(), active.end(), proxyID);
+			std::iter_swap(iter, active.end() - 1);
+			active.pop_back();
+		}
+		else
+		{
+			const AABB& box = mProxies[proxyID].mBox;
+			for (int other : active)
+			{
+				if (Intersect(box, mProxies[other].mBox))
+				{
+					newPairs.emplace(MakePairKey(proxyID, other));
+				}
+			}
+			active.emplace_back(proxyID);
+		}
+	}
+
+	// Compare against the old pairs to generate events
+	for (uint64_t key : mPairs)
+	{
+		if (newPairs.find(key) == newPairs.end())
+		{
+			int a = static_cast<int>(key >> 32);
+			int b = static_cast<int>(key & 0xFFFFFFFF);
+			UnlinkPair(a, b);
+			mRemovedPairs.emplace_back(Pair{ a, b });
+		}
+	}
+	for (uint64_t key : newPairs)
+	{
+		if (mPairs.find(key) == mPairs.end())
+		{
+			int a = static_cast<int>(key >> 32);
+			int b = static_cast<int>(key & 0xFFFFFFFF);
+			LinkPair(a, b);
+			mAddedPairs.emplace_back(Pair{ a, b });
+		}
+	}
+	mPairs.swap(newPairs);
+}
+
+void SweepAndPrune::InsertNewProxies()
+{
+	// Insertion sorting the new endpoints in from the end would move
+	// each of them past about half the list. Instead, sort the old
+	// endpoints as usual, then sort the new ones and merge them in.
+	size_t numNew = mNewProxies.size() * 2;
+	std::vector<std::pair<float, uint32_t>> temp(numNew);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<float>& values = mValues[axis];
+		std::vector<uint32_t>& endpoints = mEndpoints[axis];
+		// The new endpoints are all at the end
+		size_t numOld = values.size() - numNew;
+		for (size_t i = 0; i < numNew; i++)
+		{
+			temp[i] = std::make_pair(values[numOld + i], endpoints[numOld + i]);
+		}
+		std::sort(temp.begin(), temp.end(),
+			[](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+				return EndpointLess(a.first, a.second, b.first, b.second);
+		});
+
+		values.resize(numOld);
+		endpoints.resize(numOld);
+		SortAxis(axis);
+
+		// Merge from the back, so nothing before the first
+		// new endpoint has to move
+		values.resize(numOld + numNew);
+		endpoints.resize(numOld + numNew);
+		size_t oldIndex = numOld;
+		size_t newIndex = numNew;
+		size_t write = numOld + numNew;
+		while (newIndex > 0)
+		{
+			write--;
+			const std::pair<float, uint32_t>& next = temp[newIndex - 1];
+			if (oldIndex > 0 && EndpointLess(next.first, next.second,
+				values[oldIndex - 1], endpoints[oldIndex - 1]))
+			{
+				oldIndex--;
+				values[write] = values[oldIndex];
+				endpoints[write] = endpoints[oldIndex];
+			}
+			else
+			{
+				newIndex--;
+				values[write] = next.first;
+				endpoints[write] = next.second;
+			}
+			SetEndpointIndex(axis, endpoints[write], static_cast<uint32_t>(write));
+		}
+	}
+
+	FindNewPairs();
+}
+
+void SweepAndPrune::FindNewPairs()
+{
+	// Sweep along x like Rebuild, but only test pairs with a new proxy.
+	// SortAxis already took care of the pairs of old proxies.
+	std::vector<int> active[2];
+	for (uint32_t endpoint : mEndpoints[0])
+	{
+		int proxyID = GetProxy(endpoint);
+		Proxy& proxy = mProxies[proxyID];
+		std::vector<int>& list = active[proxy.mNew ? 1 : 0];
+		if (IsMax(endpoint))
+		{
+			// Swap-remove from the active list
+			int last = list.back();
+			list[proxy.mActiveIndex] = last;
+			mProxies[last].mActiveIndex = proxy.mActiveIndex;
+			list.pop_back();
+		}
+		else
+		{
+			// New proxies test against everything active,
+			// old ones only against the new proxies
+			for (int i = proxy.mNew ? 0 : 1; i < 2; i++)
+			{
+				for (int other : active[i])
+				{
+					if (Intersect(proxy.mBox, mProxies[other].mBox))
+					{
+						AddPair(proxyID, other);
+					}
+				}
+			}
+			proxy.mActiveIndex = static_cast<int>(list.size());
+			list.emplace_back(proxyID);
+		}
+	}
+}
+
+void SweepAndPrune::AddPair(int a, int b)
+{
+	if (mPairs.emplace(MakePairKey(a, b)).second)
+	{
+		LinkPair(a, b);
+		mAddedPairs.emplace_back(Pair{ a, b });
+	}
+}
+
+void SweepAndPrune::RemovePair(int a, int b)
+{
+	if (mPairs.erase(MakePairKey(a, b)) > 0)
+	{
+		UnlinkPair(a, b);
+		mRemovedPairs.emplace_back(Pair{ a, b });
+	}
+}
+
+void SweepAndPrune::LinkPair(int a, int b)
+{
+	mProxies[a].mPairs.emplace_back(b);
+	mProxies[b].mPairs.emplace_back(a);
+}
+
+void SweepAndPrune::UnlinkPair(int a, int b)
+{
+	// Pair lists are short, so a linear search is fine
+	// (and the order doesn't matter, so swap-remove)
+	for (int i = 0; i < 2; i++)
+	{
+		std::vector<int>& pairs = mProxies[a].mPairs;
+		auto iter = std::find(pairs.begin(), pairs.end(), b);
+		*iter = pairs.back();
+		pairs.pop_back();
+		std::swap(a, b);
+	}
+}
@@ -0,0 +1,111 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+#include "Collision.h"
+
+// Persistent sweep and prune on all three axes.
+// The sorted endpoint lists are kept between updates and fixed up
+// with an insertion sort, which is close to linear when boxes only
+// move a little each frame. Overlapping pairs are tracked, so each
+// update only reports pairs that started or stopped overlapping.
+class SweepAndPrune
+{
+public:
+	SweepAndPrune();
+
+	struct Pair
+	{
+		int mProxyA;
+		int mProxyB;
+	};
+
+	// Add a box. It won't generate any pairs until the next Update
+	int CreateProxy(const AABB& box, void* userData);
+	// Remove a box. Its pairs are dropped without reporting them, and
+	// its endpoints are taken out of the lists on the next Update
+	void DestroyProxy(int proxyID);
+	// Change the box of a proxy (takes effect on the next Update)
+	void SetBox(int proxyID, const AABB& box);
+
+	// Sort the endpoints and compute the added/removed pairs
+	void Update();
+
+	// Pairs that started/stopped overlapping during the last Update
+	const std::vector<Pair>& GetAddedPairs() const { return mAddedPairs; }
+	const std::vector<Pair>& GetRemovedPairs() const { return mRemovedPairs; }
+
+	void* GetUserData(int proxyID) const { return mProxies[proxyID].mUserData; }
+	size_t GetNumOverlaps() const { return mPairs.size(); }
+private:
+	struct Proxy
+	{
+		AABB mBox{ Vector3::Zero, Vector3::Zero };
+		void* mUserData = nullptr;
+		// Index of this proxy's endpoints in each axis
+		uint32_t mMin[3] = { 0, 0, 0 };
+		uint32_t mMax[3] = { 0, 0, 0 };
+		// The other proxy of every pair this one is in
+		std::vector<int> mPairs;
+		// Next free proxy, if this one isn't in use
+		int mNextFree = -1;
+		// Index in the active list while sweeping for new pairs
+		int mActiveIndex = -1;
+		// Destroyed, but the endpoints are still in the lists
+		bool mDead = false;
+		// Created since the last update (endpoints not sorted in yet)
+		bool mNew = false;
+	};
+
+	// Endpoint IDs are the proxy ID shifted left by one,
+	// with the low bit set for max endpoints
+	static uint32_t MakeEndpoint(int proxyID, bool isMax)
+	{
+		return (static_cast<uint32_t>(proxyID) << 1) | (isMax ? 1 : 0);
+	}
+	static int GetProxy(uint32_t endpoint) { return static_cast<int>(endpoint >> 1); }
+	static bool IsMax(uint32_t endpoint) { return (endpoint & 1) != 0; }
+	static uint64_t MakePairKey(int a, int b);
+
+	// Set index of the endpoint in the proxy
+	void SetEndpointIndex(int axis, uint32_t endpoint, uint32_t index);
+	// Insertion sort one axis, generating pair events
+	void SortAxis(int axis);
+	// Full sort of every axis, used when many proxies were added
+	void Rebuild();
+	// Sort the endpoints of new proxies and merge them into each axis,
+	// then sweep for the pairs they're in
+	void InsertNewProxies();
+	void FindNewPairs();
+	// Take the endpoints of destroyed proxies out of every axis,
+	// and free the proxies
+	void RemoveDeadEndpoints();
+	void AddPair(int a, int b);
+	void RemovePair(int a, int b);
+	// Add/remove b in a's pair list (and a in b's)
+	void LinkPair(int a, int b);
+	void UnlinkPair(int a, int b);
+
+	std::vector<Proxy> mProxies;
+	int mFreeList;
+	// Sorted endpoints for each axis, stored as parallel arrays
+	// so the sort only touches the values it compares
+	std::vector<float> mValues[3];
+	std::vector<uint32_t> mEndpoints[3];
+	// Currently overlapping pairs
+	std::unordered_set<uint64_t> mPairs;
+	std::vector<Pair> mAddedPairs;
+	std::vector<Pair> mRemovedPairs;
+	// Proxies added since the last update (endpoints appended unsorted)
+	std::vector<int> mNewProxies;
+	// Proxies destroyed since the last update
+	std::vector<int> mDeadProxies;
+};
@@ -13,5 +13,6 @@ class TargetActor : public Actor
 {
 public:
 	TargetActor(class Game* game);
+	DECLARE_POOLED(TargetActor)
 	TypeID GetType() const override { return TTargetActor; }
 };
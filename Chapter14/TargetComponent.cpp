@@ -18,10 +18,12 @@
 TargetComponent::TargetComponent(Actor * owner)
 	:Component(owner)
 {
-	mOwner->GetGame()->GetHUD()->AddTargetComponent(this);
+	// Nothing to do per frame
+	mUpdateMode = ENoUpdate;
+	mHUDHandle = mOwner->GetGame()->GetHUD()->AddTargetComponent(this);
 }
 
 TargetComponent::~TargetComponent()
 {
-	mOwner->GetGame()->GetHUD()->RemoveTargetComponent(this);
+	mOwner->GetGame()->GetHUD()->RemoveTargetComponent(mHUDHandle);
 }
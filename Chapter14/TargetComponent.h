@@ -13,6 +13,9 @@ class TargetComponent : public Component
 {
 public:
 	TargetComponent(class Actor* owner);
+	DECLARE_POOLED(TargetComponent)
 	~TargetComponent();
 	TypeID GetType() const override { return TTargetComponent; }
+private:
+	SlotHandle mHUDHandle;
 };
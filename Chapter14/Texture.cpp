@@ -8,13 +8,28 @@
 
 #include "Texture.h"
 #include <SOIL/SOIL.h>
+extern "C"
+{
+#include <SOIL/image_DXT.h>
+}
 #include <GL/glew.h>
 #include <SDL/SDL.h>
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
 
 Texture::Texture()
 :mTextureID(0)
 ,mWidth(0)
 ,mHeight(0)
+,mUVMin(Vector2::Zero)
+,mUVMax(1.0f, 1.0f)
+,mPlaceholder(false)
+,mAtlasRegion(false)
 {
 	
 }
@@ -24,36 +39,248 @@ Texture::~Texture()
 	
 }
 
+namespace
+{
+	// A baked texture (.png.bin) is a fixed size header followed by
+	// every mip level, largest first, each 16-byte aligned and in the
+	// layout glTexImage2D/glCompressedTexImage2D takes, so the levels
+	// are uploaded straight out of the mapped file
+	const uint32_t BinaryVersion = 1;
+	const uint32_t SectionAlignment = 16;
+	// Enough for a 32768x32768 texture
+	const uint32_t MaxMips = 16;
+	enum BinFormat : uint32_t
+	{
+		EFormatRGB8,
+		EFormatRGBA8,
+		EFormatDXT1,
+		EFormatDXT5
+	};
+	struct MipInfo
+	{
+		// Byte offset from the start of the file, and size
+		uint32_t mOffset;
+		uint32_t mSize;
+		uint32_t mWidth;
+		uint32_t mHeight;
+	};
+	struct TexBinHeader
+	{
+		// Signature for file type
+		char mSignature[4];
+		uint32_t mVersion;
+		uint32_t mFormat;
+		uint32_t mNumMips;
+		// Total size, to catch truncated files
+		uint32_t mFileSize;
+		uint32_t mPadding[3];
+		MipInfo mMips[MaxMips];
+	};
+	static_assert(sizeof(TexBinHeader) == 288, "TexBinHeader must stay 288 bytes");
+
+	uint32_t AlignSection(uint32_t offset)
+	{
+		return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+
+	// Box filters an image down to the next mip level
+	void Downsample(const std::vector<unsigned char>& src, int width, int height,
+		int channels, std::vector<unsigned char>& outDest)
+	{
+		int destWidth = width > 1 ? width / 2 : 1;
+		int destHeight = height > 1 ? height / 2 : 1;
+		outDest.resize(destWidth * destHeight * channels);
+		for (int y = 0; y < destHeight; y++)
+		{
+			// Clamp for odd (or 1 pixel) sizes
+			int y0 = y * 2;
+			int y1 = y0 + 1 < height ? y0 + 1 : y0;
+			for (int x = 0; x < destWidth; x++)
+			{
+				int x0 = x * 2;
+				int x1 = x0 + 1 < width ? x0 + 1 : x0;
+				for (int c = 0; c < channels; c++)
+				{
+					int sum = src[(y0 * width + x0) * channels + c] +
+						src[(y0 * width + x1) * channels + c] +
+						src[(y1 * width + x0) * channels + c] +
+						src[(y1 * width + x1) * channels + c];
+					outDest[(y * destWidth + x) * channels + c] =
+						static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+// What Decode hands to Upload: either pixels SOIL decoded (which
+// get their mips made by GL), or a baked file's mip chain
+struct Texture::Image
+{
+	~Image()
+	{
+		if (mPixels)
+		{
+			SOIL_free_image_data(mPixels);
+		}
+	}
+	unsigned char* mPixels = nullptr;
+	int mWidth = 0;
+	int mHeight = 0;
+	int mChannels = 0;
+	MappedFile mFile;
+	const TexBinHeader* mHeader = nullptr;
+};
+
 bool Texture::Load(const std::string& fileName)
 {
+	PROFILE_SCOPE_DETAIL("Texture::Load", fileName.c_str());
 	mFileName = fileName;
-	int channels = 0;
-	
-	unsigned char* image = SOIL_load_image(fileName.c_str(),
-										   &mWidth, &mHeight, &channels, SOIL_LOAD_AUTO);
+	std::shared_ptr<Image> image = Decode(fileName);
+	if (!image)
+	{
+		return false;
+	}
+	Upload(*image);
+	return true;
+}
+
+std::shared_ptr<Texture::Image> Texture::Decode(const std::string& fileName)
+{
+	PROFILE_SCOPE_DETAIL("Texture::Decode", fileName.c_str());
+	std::shared_ptr<Image> image = std::make_shared<Image>();
+	// Baked textures skip the decode and the mip generation, so
+	// only fall back to the image file if this one isn't baked
+	if (ReadBinary(fileName + ".bin", *image))
+	{
+		return image;
+	}
+
+	image->mPixels = SOIL_load_image(fileName.c_str(), &image->mWidth,
+		&image->mHeight, &image->mChannels, SOIL_LOAD_AUTO);
 	
-	if (image == nullptr)
+	if (image->mPixels == nullptr)
 	{
 		SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
+		return nullptr;
+	}
+	return image;
+}
+
+bool Texture::ReadBinary(const std::string& fileName, Image& outImage)
+{
+	MappedFile& file = outImage.mFile;
+	if (!file.Open(fileName) || file.GetSize() < sizeof(TexBinHeader))
+	{
 		return false;
 	}
-	
-	int format = GL_RGB;
-	if (channels == 4)
+	const unsigned char* data = file.GetData();
+	// (The mapping is page aligned, so the header can be read in place)
+	const TexBinHeader& header = *reinterpret_cast<const TexBinHeader*>(data);
+
+	// Validate the header signature and version
+	if (memcmp(header.mSignature, "GTEX", 4) != 0)
+	{
+		return false;
+	}
+	if (header.mVersion != BinaryVersion)
+	{
+		SDL_Log("Texture %s is an old version, rebake it with -bake", fileName.c_str());
+		return false;
+	}
+	if (header.mFormat > EFormatDXT5 || header.mNumMips == 0 ||
+		header.mNumMips > MaxMips || header.mFileSize != file.GetSize())
+	{
+		SDL_Log("Texture %s is corrupt", fileName.c_str());
+		return false;
+	}
+	for (uint32_t i = 0; i < header.mNumMips; i++)
+	{
+		const MipInfo& mip = header.mMips[i];
+		if (mip.mOffset % SectionAlignment != 0 ||
+			static_cast<uint64_t>(mip.mOffset) + mip.mSize > header.mFileSize)
+		{
+			SDL_Log("Texture %s is corrupt", fileName.c_str());
+			return false;
+		}
+	}
+
+	// Without S3TC, use the image file instead
+	if (header.mFormat >= EFormatDXT1 && !GLEW_EXT_texture_compression_s3tc)
 	{
-		format = GL_RGBA;
+		return false;
+	}
+
+	// Touch every page now, so the disk reads happen on this thread
+	// rather than in the upload
+	volatile unsigned char touch = 0;
+	for (size_t i = 0; i < file.GetSize(); i += 4096)
+	{
+		touch += data[i];
 	}
+
+	outImage.mHeader = &header;
+	outImage.mWidth = static_cast<int>(header.mMips[0].mWidth);
+	outImage.mHeight = static_cast<int>(header.mMips[0].mHeight);
+	return true;
+}
+
+void Texture::Upload(const Image& image)
+{
+	mWidth = image.mWidth;
+	mHeight = image.mHeight;
+	mPlaceholder = false;
 	
 	glGenTextures(1, &mTextureID);
 	glBindTexture(GL_TEXTURE_2D, mTextureID);
-	
-	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format,
-				 GL_UNSIGNED_BYTE, image);
-	
-	SOIL_free_image_data(image);
-	
-	// Generate mipmaps for texture
-	glGenerateMipmap(GL_TEXTURE_2D);
+
+	if (image.mHeader)
+	{
+		// Upload the baked mip chain level by level
+		const TexBinHeader& header = *image.mHeader;
+		const unsigned char* data = image.mFile.GetData();
+		// RGB rows aren't 4-byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (uint32_t i = 0; i < header.mNumMips; i++)
+		{
+			const MipInfo& mip = header.mMips[i];
+			switch (header.mFormat)
+			{
+			case EFormatRGB8:
+				glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, mip.mWidth, mip.mHeight, 0,
+					GL_RGB, GL_UNSIGNED_BYTE, data + mip.mOffset);
+				break;
+			case EFormatRGBA8:
+				glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, mip.mWidth, mip.mHeight, 0,
+					GL_RGBA, GL_UNSIGNED_BYTE, data + mip.mOffset);
+				break;
+			case EFormatDXT1:
+				glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+					mip.mWidth, mip.mHeight, 0, mip.mSize, data + mip.mOffset);
+				break;
+			default:
+				glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+					mip.mWidth, mip.mHeight, 0, mip.mSize, data + mip.mOffset);
+				break;
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.mNumMips - 1);
+	}
+	else
+	{
+		int format = GL_RGB;
+		if (image.mChannels == 4)
+		{
+			format = GL_RGBA;
+		}
+		
+		glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format,
+					 GL_UNSIGNED_BYTE, image.mPixels);
+		
+		// Generate mipmaps for texture
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
 	// Enable linear filtering
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -67,13 +294,158 @@ bool Texture::Load(const std::string& fileName)
 		// Enable it
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, largest);
 	}
-	
-	return true;
+}
+
+bool Texture::Bake(const std::string& fileName)
+{
+	return BakeBinary(fileName, false);
+}
+
+bool Texture::BakeCompressed(const std::string& fileName)
+{
+	return BakeBinary(fileName, true);
+}
+
+bool Texture::BakeBinary(const std::string& fileName, bool compress)
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	unsigned char* pixels = SOIL_load_image(fileName.c_str(), &width, &height,
+		&channels, SOIL_LOAD_AUTO);
+	if (pixels == nullptr)
+	{
+		SDL_Log("SOIL failed to load image %s: %s", fileName.c_str(), SOIL_last_result());
+		return false;
+	}
+	// Gray images get expanded, since GL wants RGB(A) here
+	if (channels < 3)
+	{
+		SOIL_free_image_data(pixels);
+		int force = channels == 2 ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB;
+		pixels = SOIL_load_image(fileName.c_str(), &width, &height, &channels, force);
+		if (pixels == nullptr)
+		{
+			return false;
+		}
+		channels = force;
+	}
+	std::vector<unsigned char> level(pixels, pixels + width * height * channels);
+	SOIL_free_image_data(pixels);
+
+	TexBinHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mSignature, "GTEX", 4);
+	header.mVersion = BinaryVersion;
+	if (compress)
+	{
+		header.mFormat = channels == 4 ? EFormatDXT5 : EFormatDXT1;
+	}
+	else
+	{
+		header.mFormat = channels == 4 ? EFormatRGBA8 : EFormatRGB8;
+	}
+
+	// Build each level from the one above, down to 1x1
+	std::vector<std::vector<unsigned char>> mips;
+	uint32_t offset = AlignSection(sizeof(header));
+	while (true)
+	{
+		MipInfo& mip = header.mMips[header.mNumMips];
+		mip.mWidth = width;
+		mip.mHeight = height;
+		mip.mOffset = offset;
+		if (compress)
+		{
+			int size = 0;
+			unsigned char* dxt = channels == 4 ?
+				convert_image_to_DXT5(level.data(), width, height, channels, &size) :
+				convert_image_to_DXT1(level.data(), width, height, channels, &size);
+			if (dxt == nullptr)
+			{
+				SDL_Log("Failed to compress %s", fileName.c_str());
+				return false;
+			}
+			mips.emplace_back(dxt, dxt + size);
+			free(dxt);
+		}
+		else
+		{
+			mips.emplace_back(level);
+		}
+		mip.mSize = static_cast<uint32_t>(mips.back().size());
+		offset = AlignSection(offset + mip.mSize);
+		header.mNumMips++;
+
+		if ((width == 1 && height == 1) || header.mNumMips == MaxMips)
+		{
+			break;
+		}
+		std::vector<unsigned char> next;
+		Downsample(level, width, height, channels, next);
+		level.swap(next);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	header.mFileSize = header.mMips[header.mNumMips - 1].mOffset +
+		header.mMips[header.mNumMips - 1].mSize;
+
+	std::string outName = fileName + ".bin";
+	std::ofstream outFile(outName, std::ios::out
+		| std::ios::binary | std::ios::trunc);
+	if (!outFile.is_open())
+	{
+		SDL_Log("Failed to write texture %s", outName.c_str());
+		return false;
+	}
+
+	// Writes each section, zero padding up to its offset
+	const char zeros[SectionAlignment] = {};
+	uint32_t written = 0;
+	auto writeSection = [&](uint32_t sectionOffset, const void* data, uint32_t size)
+	{
+		outFile.write(zeros, sectionOffset - written);
+		outFile.write(reinterpret_cast<const char*>(data), size);
+		written = sectionOffset + size;
+	};
+	writeSection(0, &header, sizeof(header));
+	for (uint32_t i = 0; i < header.mNumMips; i++)
+	{
+		writeSection(header.mMips[i].mOffset, mips[i].data(), header.mMips[i].mSize);
+	}
+	return outFile.good();
+}
+
+void Texture::SetPlaceholder(const std::string& fileName, const Texture* other)
+{
+	mFileName = fileName;
+	mTextureID = other->mTextureID;
+	mWidth = other->mWidth;
+	mHeight = other->mHeight;
+	mPlaceholder = true;
+}
+
+void Texture::SetAtlasRegion(const std::string& fileName, const Texture* page,
+	int x, int y, int width, int height)
+{
+	mFileName = fileName;
+	mTextureID = page->mTextureID;
+	mWidth = width;
+	mHeight = height;
+	float pageWidth = static_cast<float>(page->mWidth);
+	float pageHeight = static_cast<float>(page->mHeight);
+	mUVMin = Vector2(x / pageWidth, y / pageHeight);
+	mUVMax = Vector2((x + width) / pageWidth, (y + height) / pageHeight);
+	mAtlasRegion = true;
 }
 
 void Texture::Unload()
 {
-	glDeleteTextures(1, &mTextureID);
+	// Placeholders and atlas regions use another texture's GL texture
+	if (!mPlaceholder && !mAtlasRegion)
+	{
+		glDeleteTextures(1, &mTextureID);
+	}
 }
 
 void Texture::CreateFromSurface(SDL_Surface* surface)
@@ -100,7 +472,9 @@ void Texture::CreateForRendering(int width, int height, unsigned int format)
 	glGenTextures(1, &mTextureID);
 	glBindTexture(GL_TEXTURE_2D, mTextureID);
 	// Set the image width/height with null initial data
-	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, GL_RGB,
+	// (a depth texture needs a depth format, even with no data)
+	GLenum dataFormat = format == GL_DEPTH_COMPONENT24 ? GL_DEPTH_COMPONENT : GL_RGB;
+	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, dataFormat,
 		GL_FLOAT, nullptr);
 
 	// For a texture we'll render to, just use nearest neighbor
@@ -108,6 +482,34 @@ void Texture::CreateForRendering(int width, int height, unsigned int format)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
+void Texture::CreateDynamic(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+	glGenTextures(1, &mTextureID);
+	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	// Start cleared, so the gaps between pieces filter to nothing
+	std::vector<unsigned char> clear(mWidth * mHeight * 4, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_BGRA,
+		GL_UNSIGNED_BYTE, clear.data());
+
+	// Use linear filtering
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void Texture::UpdateFromSurface(int x, int y, SDL_Surface* surface)
+{
+	// Surface rows can be padded, so give GL the real row length
+	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, surface->pitch / 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, surface->w, surface->h, GL_BGRA,
+		GL_UNSIGNED_BYTE, surface->pixels);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
 void Texture::SetActive(int index)
 {
 	glActiveTexture(GL_TEXTURE0 + index);
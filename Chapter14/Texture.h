@@ -6,6 +6,8 @@
 // See LICENSE in root directory for full details.
 // ----------------------------------------------------------------
 
+#include "Math.h"
+#include <memory>
 #include <string>
 
 class Texture
@@ -16,8 +18,35 @@ public:
 	
 	bool Load(const std::string& fileName);
 	void Unload();
+	// Load split in two, so the decode can run off the main thread.
+	// Decode returns null on failure, Upload needs the GL context.
+	struct Image;
+	static std::shared_ptr<Image> Decode(const std::string& fileName);
+	void Upload(const Image& image);
+	// Shows other's texture until Upload is called
+	void SetPlaceholder(const std::string& fileName, const Texture* other);
+	bool IsPlaceholder() const { return mPlaceholder; }
+
+	// Convert an image to the .bin next to it, with its whole mip chain
+	// (BakeCompressed stores it as DXT1, or DXT5 if it has alpha)
+	static bool Bake(const std::string& fileName);
+	static bool BakeCompressed(const std::string& fileName);
+
+	// Makes this the region of an atlas page at (x, y), so it draws
+	// (through the SpriteBatch) as if it were its own texture
+	void SetAtlasRegion(const std::string& fileName, const Texture* page,
+		int x, int y, int width, int height);
+	bool IsAtlasRegion() const { return mAtlasRegion; }
+	// Texture coordinates of the top left/bottom right corners
+	const Vector2& GetUVMin() const { return mUVMin; }
+	const Vector2& GetUVMax() const { return mUVMax; }
+
 	void CreateFromSurface(struct SDL_Surface* surface);
 	void CreateForRendering(int width, int height, unsigned int format);
+	// An empty (transparent) RGBA texture that's filled in a piece at
+	// a time with UpdateFromSurface, like the font glyph atlas
+	void CreateDynamic(int width, int height);
+	void UpdateFromSurface(int x, int y, struct SDL_Surface* surface);
 	
 	void SetActive(int index = 0);
 	
@@ -27,8 +56,16 @@ public:
 
 	const std::string& GetFileName() const { return mFileName; }
 private:
+	// Maps a baked texture made by Bake
+	static bool ReadBinary(const std::string& fileName, Image& outImage);
+	static bool BakeBinary(const std::string& fileName, bool compress);
+
 	std::string mFileName;
 	unsigned int mTextureID;
 	int mWidth;
 	int mHeight;
+	Vector2 mUVMin;
+	Vector2 mUVMax;
+	bool mPlaceholder;
+	bool mAtlasRegion;
 };
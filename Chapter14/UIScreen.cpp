@@ -8,14 +8,13 @@
 
 #include "UIScreen.h"
 #include "Texture.h"
-#include "Shader.h"
+#include "SpriteBatch.h"
 #include "Game.h"
 #include "Renderer.h"
 #include "Font.h"
 
 UIScreen::UIScreen(Game* game)
 	:mGame(game)
-	,mTitle(nullptr)
 	,mBackground(nullptr)
 	,mTitlePos(0.0f, 300.0f)
 	,mNextButtonPos(0.0f, 200.0f)
@@ -31,12 +30,6 @@ UIScreen::UIScreen(Game* game)
 
 UIScreen::~UIScreen()
 {
-	if (mTitle)
-	{
-		mTitle->Unload();
-		delete mTitle;
-	}
-
 	for (auto b : mButtons)
 	{
 		delete b;
@@ -49,26 +42,26 @@ void UIScreen::Update(float deltaTime)
 	
 }
 
-void UIScreen::Draw(Shader* shader)
+void UIScreen::Draw(SpriteBatch* batch)
 {
 	// Draw background (if exists)
 	if (mBackground)
 	{
-		DrawTexture(shader, mBackground, mBGPos);
+		DrawTexture(batch, mBackground, mBGPos);
 	}
 	// Draw title (if exists)
-	if (mTitle)
+	if (!mTitle.IsEmpty())
 	{
-		DrawTexture(shader, mTitle, mTitlePos);
+		mTitle.Draw(batch, mTitlePos);
 	}
 	// Draw buttons
 	for (auto b : mButtons)
 	{
 		// Draw background of button
 		Texture* tex = b->GetHighlighted() ? mButtonOn : mButtonOff;
-		DrawTexture(shader, tex, b->GetPosition());
+		DrawTexture(batch, tex, b->GetPosition());
 		// Draw text of button
-		DrawTexture(shader, b->GetNameTex(), b->GetPosition());
+		b->GetNameText().Draw(batch, b->GetPosition());
 	}
 	// Override in subclasses to draw any textures
 }
@@ -132,14 +125,8 @@ void UIScreen::SetTitle(const std::string& text,
 						const Vector3& color,
 						int pointSize)
 {
-	// Clear out previous title texture if it exists
-	if (mTitle)
-	{
-		mTitle->Unload();
-		delete mTitle;
-		mTitle = nullptr;
-	}
-	mTitle = mFont->RenderText(text, color, pointSize);
+	// Reuses the title's glyph quads, so no new texture
+	mFont->LayoutText(mTitle, text, color, pointSize);
 }
 
 void UIScreen::AddButton(const std::string& name, std::function<void()> onClick)
@@ -154,7 +141,7 @@ void UIScreen::AddButton(const std::string& name, std::function<void()> onClick)
 	mNextButtonPos.y -= mButtonOff->GetHeight() + 20.0f;
 }
 
-void UIScreen::DrawTexture(class Shader* shader, class Texture* texture,
+void UIScreen::DrawTexture(class SpriteBatch* batch, class Texture* texture,
 				 const Vector2& offset, float scale, bool flipY)
 {
 	// Scale the quad by the width/height of texture
@@ -171,13 +158,9 @@ void UIScreen::DrawTexture(class Shader* shader, class Texture* texture,
 	Matrix4 transMat = Matrix4::CreateTranslation(
 		Vector3(offset.x, offset.y, 0.0f));
 
-	// Set world transform
+	// Add the quad to the batch
 	Matrix4 world = scaleMat * transMat;
-	shader->SetMatrixUniform("uWorldTransform", world);
-	// Set current texture
-	texture->SetActive();
-	// Draw quad
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	batch->Draw(texture, world);
 }
 
 void UIScreen::SetRelativeMouseMode(bool relative)
@@ -198,7 +181,6 @@ Button::Button(const std::string& name, Font* font,
 	std::function<void()> onClick,
 	const Vector2& pos, const Vector2& dims)
 	:mOnClick(onClick)
-	,mNameTex(nullptr)
 	,mFont(font)
 	,mPosition(pos)
 	,mDimensions(dims)
@@ -209,24 +191,12 @@ Button::Button(const std::string& name, Font* font,
 
 Button::~Button()
 {
-	if (mNameTex)
-	{
-		mNameTex->Unload();
-		delete mNameTex;
-	}
 }
 
 void Button::SetName(const std::string& name)
 {
 	mName = name;
-
-	if (mNameTex)
-	{
-		mNameTex->Unload();
-		delete mNameTex;
-		mNameTex = nullptr;
-	}
-	mNameTex = mFont->RenderText(mName);
+	mFont->LayoutText(mNameText, mName);
 }
 
 bool Button::ContainsPoint(const Vector2& pt) const
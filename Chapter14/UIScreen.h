@@ -8,6 +8,7 @@
 
 #pragma once
 #include "Math.h"
+#include "Font.h"
 #include <cstdint>
 #include <string>
 #include <functional>
@@ -25,7 +26,7 @@ public:
 	void SetName(const std::string& name);
 	
 	// Getters/setters
-	class Texture* GetNameTex() { return mNameTex; }
+	const Text& GetNameText() const { return mNameText; }
 	const Vector2& GetPosition() const { return mPosition; }
 	void SetHighlighted(bool sel) { mHighlighted = sel; }
 	bool GetHighlighted() const { return mHighlighted; }
@@ -37,7 +38,7 @@ public:
 private:
 	std::function<void()> mOnClick;
 	std::string mName;
-	class Texture* mNameTex;
+	Text mNameText;
 	class Font* mFont;
 	Vector2 mPosition;
 	Vector2 mDimensions;
@@ -51,7 +52,7 @@ public:
 	virtual ~UIScreen();
 	// UIScreen subclasses can override these
 	virtual void Update(float deltaTime);
-	virtual void Draw(class Shader* shader);
+	virtual void Draw(class SpriteBatch* batch);
 	virtual void ProcessInput(const uint8_t* keys);
 	virtual void HandleKeyPress(int key);
 	// Tracks if the UI is active or closing
@@ -72,7 +73,7 @@ public:
 	void AddButton(const std::string& name, std::function<void()> onClick);
 protected:
 	// Helper to draw a texture
-	void DrawTexture(class Shader* shader, class Texture* texture,
+	void DrawTexture(class SpriteBatch* batch, class Texture* texture,
 					 const Vector2& offset = Vector2::Zero,
 					 float scale = 1.0f,
 					 bool flipY = false);
@@ -81,7 +82,7 @@ protected:
 	class Game* mGame;
 	
 	class Font* mFont;
-	class Texture* mTitle;
+	Text mTitle;
 	class Texture* mBackground;
 	class Texture* mButtonOn;
 	class Texture* mButtonOff;
@@ -0,0 +1,33 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "UniformBuffer.h"
+#include <GL/glew.h>
+
+UniformBuffer::UniformBuffer(size_t size, unsigned int bindingPoint)
+	:mBuffer(0)
+	,mBindingPoint(bindingPoint)
+	,mSize(size)
+{
+	glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	// Attach the buffer to the binding point
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, mBuffer);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	glDeleteBuffers(1, &mBuffer);
+}
+
+void UniformBuffer::Update(const void* data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, mSize, data);
+}
@@ -0,0 +1,32 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+
+// A uniform buffer object, which holds the data for a uniform
+// block. Any shader with the block bound to the same binding
+// point reads from the buffer, so shared data (like the view-
+// projection matrix) only has to be uploaded once
+class UniformBuffer
+{
+public:
+	// size should match the std140 layout of the block
+	UniformBuffer(size_t size, unsigned int bindingPoint);
+	~UniformBuffer();
+
+	// Upload new contents for the whole buffer
+	void Update(const void* data);
+
+	unsigned int GetBindingPoint() const { return mBindingPoint; }
+private:
+	// OpenGL ID of the buffer
+	unsigned int mBuffer;
+	unsigned int mBindingPoint;
+	size_t mSize;
+};
@@ -81,6 +81,20 @@ void VertexArray::SetActive()
 	glBindVertexArray(mVertexArray);
 }
 
+void VertexArray::SetInstanceBuffer(unsigned int instanceBuffer)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	// A Matrix4 is 4 rows of 4 floats, and advances once per instance
+	const unsigned int matrixSize = 16 * sizeof(float);
+	for (unsigned int row = 0; row < 4; row++)
+	{
+		glEnableVertexAttribArray(3 + row);
+		glVertexAttribPointer(3 + row, 4, GL_FLOAT, GL_FALSE, matrixSize,
+			reinterpret_cast<void*>(sizeof(float) * 4 * row));
+		glVertexAttribDivisor(3 + row, 1);
+	}
+}
+
 unsigned int VertexArray::GetVertexSize(VertexArray::Layout layout)
 {
 	unsigned vertexSize = 8 * sizeof(float);
@@ -22,8 +22,13 @@ public:
 	~VertexArray();
 
 	void SetActive();
+	// Use the buffer for the per-instance world transform
+	// (attributes 3-6, one row of the matrix each).
+	// The vertex array needs to be active
+	void SetInstanceBuffer(unsigned int instanceBuffer);
 	unsigned int GetNumIndices() const { return mNumIndices; }
 	unsigned int GetNumVerts() const { return mNumVerts; }
+	unsigned int GetArrayID() const { return mVertexArray; }
 
 	static unsigned int GetVertexSize(VertexArray::Layout layout);
 private: